@@ -1,51 +1,64 @@
-#include <stdlib.h>
-#include "SnakeFood.h"
-using namespace snakelinkedlist;
-
-const float SnakeFood::kfood_modifier_ = 0.02;
-
-SnakeFood::SnakeFood() {
-    int window_width = ofGetWindowWidth();
-    int window_height = ofGetWindowHeight();
-    window_dims_.set(window_width, window_height);
-    float size_d = kfood_modifier_ * window_width;
-    food_rect_.setSize(size_d, size_d);
-    
-    generator_ = std::mt19937(rand());
-    dist_x_ = std::uniform_int_distribution<>(0, window_width - size_d);
-    dist_y_ = std::uniform_int_distribution<>(0, window_height - size_d);
-    
-    rebase();
-}
-
-void SnakeFood::resize(int w, int h) {
-    float size_d = kfood_modifier_ * w;
-    food_rect_.setSize(size_d, size_d);
-    
-    float new_x = ((food_rect_.getX() / window_dims_.x) * w);
-    float new_y = ((food_rect_.getY() / window_dims_.y) * h);
-    food_rect_.setPosition(new_x, new_y);
-    
-    dist_x_ = std::uniform_int_distribution<>(0, w - size_d);
-    dist_y_ = std::uniform_int_distribution<>(0, h - size_d);
-    window_dims_.set(w, h);
-}
-
-void SnakeFood::rebase() {
-    auto x = dist_x_(generator_);
-    auto y = dist_y_(generator_);
-    food_rect_.setPosition(x, y);
-    
-    // Make the food red, like an apple
-    color_.r = 255;
-    color_.g = 0;
-    color_.b = 0;
-}
-
-ofRectangle SnakeFood::getFoodRect() {
-    return food_rect_;
-}
-
-ofColor SnakeFood::getColor() {
-    return color_;
-}
+#include <stdlib.h>
+#include "SnakeFood.h"
+using namespace snakelinkedlist;
+
+const float SnakeFood::kfood_modifier_ = 0.02;
+
+SnakeFood::SnakeFood(OccupancyGrid& grid, int window_width, int window_height) : grid_(&grid) {
+    generator_ = std::mt19937(rand());
+    
+    // Make the food red, like an apple
+    color_.r = 255;
+    color_.g = 0;
+    color_.b = 0;
+    
+    resize(window_width, window_height);
+    rebase();
+}
+
+SnakeFood::~SnakeFood() {
+    if (placed_) {
+        grid_->unreserve(cell_);
+    }
+}
+
+// Positions are kept in cells, so resizing only changes how big a cell is on screen
+void SnakeFood::resize(int w, int /*h*/) {
+    float size_d = kfood_modifier_ * w;
+    food_rect_.setSize(size_d, size_d);
+    updateRect();
+}
+
+bool SnakeFood::rebase() {
+    // If the snake ate the pellet its head is in the cell now and unreserving does nothing,
+    // the cell becomes free again once the snake's tail leaves it
+    if (placed_) {
+        grid_->unreserve(cell_);
+    }
+    placed_ = grid_->randomFreeCell(generator_, cell_);
+    if (placed_) {
+        grid_->reserve(cell_);
+        updateRect();
+    }
+    return placed_;
+}
+
+void SnakeFood::updateRect() {
+    food_rect_.setPosition(cell_.x * food_rect_.width, cell_.y * food_rect_.height);
+}
+
+ofRectangle SnakeFood::getFoodRect() {
+    return food_rect_;
+}
+
+ofColor SnakeFood::getColor() {
+    return color_;
+}
+
+const GridCell& SnakeFood::getCell() const {
+    return cell_;
+}
+
+bool SnakeFood::isPlaced() const {
+    return placed_;
+}
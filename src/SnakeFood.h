@@ -1,29 +1,43 @@
-#ifndef SNAKEFOOD_H
-#define SNAKEFOOD_H
-#pragma once
-#include <random>
-#include "ofMain.h"
-
-namespace snakelinkedlist {
-    
-    class SnakeFood {
-    private:
-        ofVec2f window_dims_; // The object must be aware of current window dimensions for resizing things appropriately
-        std::mt19937 generator_; // Generator used for pseudorandom number generation for food color and position
-        std::uniform_int_distribution<> dist_x_; // Generates valid x positions in current window dimension
-        std::uniform_int_distribution<> dist_y_; // Generates valid y positions in current window dimension
-        
-        static const float kfood_modifier_; // What proportion of the window width the food square should be in size
-        ofRectangle food_rect_; // The rectangle which represents the actual food pellet on the game board
-        ofColor color_; // The color of the food rectangle
-        
-    public:
-        SnakeFood(); // Default constructor, sets up generator devices and rarndomly places food at a valid location
-        void rebase(); // Called once the snake has successfully eaten food, replaces the foods color and location
-        void resize(int w, int h); // Called by application resize, resizes food rect to new window dimensions
-        ofRectangle getFoodRect(); // Gets the rectangle that represents the food object
-        ofColor getColor(); // Gets the color of the current food object
-    };
-} // namespace snakelinkedlist
-
-#endif
+#ifndef SNAKEFOOD_H
+#define SNAKEFOOD_H
+#pragma once
+#include <random>
+#include "ofMain.h"
+#include "occupancy_grid.h"
+
+namespace snakelinkedlist {
+    
+    /*
+     A food pellet on the board shared with the snakes.
+     The pellet lives in a grid cell like a snake segment does. It is placed on a random cell that no snake
+     and no other pellet is in, drawn in O(1) from the grid's free cells however full the board is, and the
+     cell stays reserved while the pellet is there so nothing else gets placed on top of it.
+     */
+    class SnakeFood {
+    private:
+        OccupancyGrid* grid_; // The board shared with the snakes, it has to track its free cells
+        std::mt19937 generator_; // Generator used for pseudorandom number generation for food position
+        GridCell cell_; // Where the pellet is, valid while placed_
+        bool placed_ = false; // False if the board was full the last time the pellet was placed
+        
+        static const float kfood_modifier_; // What proportion of the window width the food square should be in size
+        ofRectangle food_rect_; // The rectangle which represents the actual food pellet on the game board
+        ofColor color_; // The color of the food rectangle
+        
+        void updateRect(); // Puts food_rect_ over cell_
+        
+    public:
+        SnakeFood(OccupancyGrid& grid, int w, int h); // Places food at a random free cell of grid, drawn on a w by h pixel window
+        SnakeFood(const SnakeFood&) = delete; // Two copies would both own the same reserved cell
+        SnakeFood& operator=(const SnakeFood&) = delete;
+        ~SnakeFood(); // Gives the pellet's cell back
+        bool rebase(); // Called once the snake has successfully eaten food, moves the food to a new free cell. False if there is none.
+        void resize(int w, int h); // Called by application resize, resizes food rect to new window dimensions
+        ofRectangle getFoodRect(); // Gets the rectangle that represents the food object
+        ofColor getColor(); // Gets the color of the current food object
+        const GridCell& getCell() const; // The cell the food is in, only meaningful if isPlaced()
+        bool isPlaced() const; // False if there was no free cell to put the food on
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <bitset>
+#include "bitboard.h"
+
+namespace snakelinkedlist {
+
+    namespace {
+
+        // Bits below width in a row's last word, all of them if the row fills it exactly
+        uint64_t lastWordMask(int width) {
+            int used = width & 63;
+            return used == 0 ? ~uint64_t(0) : (uint64_t(1) << used) - 1;
+        }
+    } // namespace
+
+    Bitboard::Bitboard(int width, int height) {
+        resize(width, height);
+    }
+
+    void Bitboard::resize(int width, int height) {
+        width_ = std::max(width, 0);
+        height_ = std::max(height, 0);
+        stride_ = (static_cast<std::size_t>(width_) + 63) / 64;
+        words_.assign(stride_ * height_, 0);
+    }
+
+    void Bitboard::clear() {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+    void Bitboard::fill() {
+        std::fill(words_.begin(), words_.end(), ~uint64_t(0));
+        if (stride_ == 0) {
+            return;
+        }
+        uint64_t mask = lastWordMask(width_);
+        for (int y = 0; y < height_; ++y) {
+            row(y)[stride_ - 1] &= mask;
+        }
+    }
+
+    void Bitboard::invert() {
+        for (uint64_t& word : words_) {
+            word = ~word;
+        }
+        if (stride_ == 0) {
+            return;
+        }
+        uint64_t mask = lastWordMask(width_);
+        for (int y = 0; y < height_; ++y) {
+            row(y)[stride_ - 1] &= mask;
+        }
+    }
+
+    std::size_t Bitboard::count() const {
+        std::size_t total = 0;
+        for (uint64_t word : words_) {
+            total += std::bitset<64>(word).count();
+        }
+        return total;
+    }
+
+    void Bitboard::dilateInto(const Bitboard& allowed, Bitboard& out, int first, int last) const {
+        first = std::max(first, 0);
+        last = std::min(last, height_);
+        for (int y = first; y < last; ++y) {
+            const uint64_t* here = row(y);
+            const uint64_t* above = y > 0 ? row(y - 1) : nullptr;
+            const uint64_t* below = y + 1 < height_ ? row(y + 1) : nullptr;
+            const uint64_t* mask = allowed.row(y);
+            uint64_t* target = out.row(y);
+            for (std::size_t w = 0; w < stride_; ++w) {
+                uint64_t cells = here[w];
+                // A cell's left neighbour is the bit below it, carried over from the previous word at bit 0
+                uint64_t from_left = cells << 1 | (w > 0 ? here[w - 1] >> 63 : 0);
+                uint64_t from_right = cells >> 1 | (w + 1 < stride_ ? here[w + 1] << 63 : 0);
+                uint64_t grown = cells | from_left | from_right;
+                if (above) {
+                    grown |= above[w];
+                }
+                if (below) {
+                    grown |= below[w];
+                }
+                target[w] = grown & mask[w];
+            }
+        }
+    }
+
+    void Bitboard::windowInto(int left, int top, int size, Bitboard& out) const {
+        out.resize(size, size);
+        uint64_t tail_mask = lastWordMask(size);
+        for (int r = 0; r < size; ++r) {
+            int y = top + r;
+            uint64_t* target = out.row(r);
+            for (std::size_t w = 0; w < out.stride(); ++w) {
+                long long x0 = static_cast<long long>(left) + static_cast<long long>(w) * 64;
+                uint64_t bits;
+                if (y < 0 || y >= height_) {
+                    bits = ~uint64_t(0);
+                } else {
+                    // 64 cells from x0, read across two words; the words past either end of the row are empty
+                    long long word = x0 >= 0 ? x0 / 64 : -((-x0 + 63) / 64);
+                    int shift = static_cast<int>(x0 - word * 64);
+                    const uint64_t* source = row(y);
+                    uint64_t low = (word >= 0 && word < static_cast<long long>(stride_)) ? source[word] : 0;
+                    uint64_t high = (word + 1 >= 0 && word + 1 < static_cast<long long>(stride_)) ? source[word + 1] : 0;
+                    bits = shift == 0 ? low : (low >> shift | high << (64 - shift));
+                    // Cells left of the board and right of it are walls
+                    if (x0 < 0) {
+                        long long outside = std::min<long long>(-x0, 64);
+                        bits |= outside == 64 ? ~uint64_t(0) : (uint64_t(1) << outside) - 1;
+                    }
+                    long long past = width_ - x0;
+                    if (past < 64) {
+                        bits |= past <= 0 ? ~uint64_t(0) : ~((uint64_t(1) << past) - 1);
+                    }
+                }
+                if (w + 1 == out.stride()) {
+                    bits &= tail_mask;
+                }
+                target[w] = bits;
+            }
+        }
+    }
+
+} // namespace snakelinkedlist
@@ -0,0 +1,86 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "snakebody.h"
+
+namespace snakelinkedlist {
+
+    // Index of the lowest set bit of word, which must not be zero
+    inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(word);
+#else
+        int bit = 0;
+        while (!(word & 1)) {
+            word >>= 1;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    /*
+     One bit per cell of a board, a row at a time in 64 bit words.
+     Every row starts on a word of its own and the bits past the right edge are always zero, so whole-board
+     operations are plain loops over contiguous words that the compiler turns into SIMD, and growing a set of
+     cells by one step in every direction (a BFS layer) is a few shifts and ors per word instead of a queue
+     pop and four lookups per cell.
+     */
+    class Bitboard {
+    private:
+        int width_ = 0;
+        int height_ = 0;
+        std::size_t stride_ = 0; // Words per row
+        std::vector<uint64_t> words_;
+
+    public:
+        Bitboard() = default;
+        Bitboard(int width, int height); // All clear
+
+        int width() const { return width_; }
+        int height() const { return height_; }
+        std::size_t stride() const { return stride_; }
+
+        bool contains(int x, int y) const {
+            return static_cast<unsigned>(x) < static_cast<unsigned>(width_) && static_cast<unsigned>(y) < static_cast<unsigned>(height_);
+        }
+        // Cells off the board read as clear
+        bool test(int x, int y) const {
+            return contains(x, y) && (words_[y * stride_ + (x >> 6)] >> (x & 63) & 1);
+        }
+        bool test(const GridCell& cell) const { return test(cell.x, cell.y); }
+        // Cells off the board are ignored
+        void set(int x, int y) {
+            if (contains(x, y)) {
+                words_[y * stride_ + (x >> 6)] |= uint64_t(1) << (x & 63);
+            }
+        }
+        void set(const GridCell& cell) { set(cell.x, cell.y); }
+
+        void clear(); // Every cell clear
+        void fill(); // Every cell of the board set, none of the padding
+        void resize(int width, int height); // All clear
+
+        uint64_t* row(int y) { return &words_[y * stride_]; }
+        const uint64_t* row(int y) const { return &words_[y * stride_]; }
+
+        std::size_t count() const; // Set cells
+
+        void invert(); // Set cells clear and clear cells set, the padding stays clear
+
+        // out = cells of this grown one step up, down, left and right, and kept only where allowed is set.
+        // Only rows first to last - 1 of out are written, so bands of rows can be spread across threads.
+        // All three must be the same size and out must not be this.
+        void dilateInto(const Bitboard& allowed, Bitboard& out, int first, int last) const;
+
+        // Copies the size x size cells whose top left corner is (left, top) into out, resizing it. Cells of the
+        // square that are off this board are set, so a window around a snake near the edge sees the wall.
+        void windowInto(int left, int top, int size, Bitboard& out) const;
+    };
+
+} // namespace snakelinkedlist
+#endif
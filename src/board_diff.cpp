@@ -0,0 +1,248 @@
+#include "board_diff.h"
+#include <algorithm>
+
+using namespace snakelinkedlist;
+
+const std::size_t BoardDiff::kMaxShift;
+const int BoardDiff::kTile;
+
+void BoardDiff::clear(const std::pair<int, int>& cell) {
+    if (rect_.contains(cell)) {
+        uint16_t& covers = covers_[index(cell)];
+        covers = covers > 0 ? covers - 1 : 0;
+        cleared_.push_back(cell);
+    }
+}
+
+void BoardDiff::paint(const std::pair<int, int>& cell, const std::array<int, 3>& color) {
+    if (rect_.contains(cell)) {
+        std::size_t i = index(cell);
+        ++covers_[i];
+        paint_marks_[i] = stamp_;
+        DirtyCell dirty;
+        dirty.cell = cell;
+        dirty.color = color;
+        painted_.push_back(dirty);
+    }
+}
+
+void BoardDiff::diffSnake(const std::vector<std::pair<int, int>>& before, const std::vector<std::pair<int, int>>& after,
+                          const std::array<int, 3>& color) {
+    // How far the head moved: after[shift] is where the head was, and the cell behind it agrees
+    std::size_t shift = 0;
+    bool found = false;
+    if (!before.empty()) {
+        for (; shift <= kMaxShift && shift < after.size(); ++shift) {
+            if (after[shift] == before[0] && (before.size() < 2 || shift + 1 >= after.size() || after[shift + 1] == before[1])) {
+                found = true;
+                break;
+            }
+        }
+    }
+    if (!found) {
+        for (const std::pair<int, int>& cell : before) {
+            clear(cell);
+        }
+        for (const std::pair<int, int>& cell : after) {
+            paint(cell, color);
+        }
+        return;
+    }
+
+    // before[i] is after[i + shift], so the body past after's end is what the tail left behind
+    for (std::size_t i = after.size() - shift; i < before.size(); ++i) {
+        clear(before[i]);
+    }
+    for (std::size_t i = 0; i < shift; ++i) {
+        paint(after[i], color);
+    }
+    // and a body that grew by more than it moved has new cells at the tail too
+    for (std::size_t i = before.size() + shift; i < after.size(); ++i) {
+        paint(after[i], color);
+    }
+}
+
+void BoardDiff::diffFood(const std::vector<std::pair<int, int>>& before, const std::vector<std::pair<int, int>>& after) {
+    // stamp_ + 1 marks a pellet that is there now, stamp_ one that was there before as well
+    for (const std::pair<int, int>& cell : after) {
+        if (rect_.contains(cell)) {
+            food_marks_[index(cell)] = stamp_ + 1;
+        }
+    }
+    for (const std::pair<int, int>& cell : before) {
+        if (rect_.contains(cell)) {
+            uint32_t& mark = food_marks_[index(cell)];
+            if (mark == stamp_ + 1) {
+                mark = stamp_; // Still there, nothing to do
+            } else if (mark != stamp_) {
+                clear(cell); // Eaten
+            }
+        }
+    }
+    for (const std::pair<int, int>& cell : after) {
+        if (rect_.contains(cell) && food_marks_[index(cell)] == stamp_ + 1) {
+            paint(cell, kFoodColor); // Spawned
+        }
+    }
+}
+
+void BoardDiff::reset(const WorldSnapshot& current, const snakejson::snake* own, const CellRect& rect) {
+    rect_ = rect;
+    std::size_t cells = static_cast<std::size_t>(std::max(0, rect.right - rect.left)) * std::max(0, rect.bottom - rect.top);
+    covers_.assign(cells, 0);
+    food_marks_.assign(cells, 0);
+    paint_marks_.assign(cells, 0);
+    contest_marks_.assign(cells, 0);
+    resolved_.assign(cells, 0);
+    stamp_ = 0;
+    forEachCellIn(current, rect, own, [this](const std::pair<int, int>& cell, const snakejson::snake*) {
+        ++covers_[index(cell)];
+    });
+    cleared_.clear();
+    painted_.clear();
+}
+
+void BoardDiff::diff(const WorldSnapshot& previous, const snakejson::snake* previous_own,
+                     const WorldSnapshot& current, const snakejson::snake* own) {
+    cleared_.clear();
+    painted_.clear();
+    stamp_ += 2;
+    if (stamp_ < 2) {
+        // Wrapped around, old marks could be mistaken for new ones
+        std::fill(food_marks_.begin(), food_marks_.end(), 0);
+        std::fill(paint_marks_.begin(), paint_marks_.end(), 0);
+        std::fill(contest_marks_.begin(), contest_marks_.end(), 0);
+        stamp_ = 2;
+    }
+
+    previous_index_.build(previous.snakes);
+    previous_kept_.assign(previous.snakes.size(), false);
+
+    // Every snake here now against its old self, and then the ones that are gone
+    static const std::vector<std::pair<int, int>> kNoBody;
+    for (const snakejson::snake& s : current.snakes) {
+        const std::vector<std::pair<int, int>>* before = &kNoBody;
+        std::size_t old = previous_index_.find(s.id);
+        if (old != SnakeIndex::kNotFound) {
+            previous_kept_[old] = true;
+            before = &previous.snakes[old].coords;
+        }
+        if (previous_own && previous_own->id == s.id) {
+            before = &previous_own->coords;
+        }
+        const std::vector<std::pair<int, int>>& after = (own && own->id == s.id) ? own->coords : s.coords;
+        diffSnake(*before, after, s.color);
+    }
+    for (std::size_t i = 0; i < previous.snakes.size(); ++i) {
+        if (!previous_kept_[i]) {
+            const snakejson::snake& s = previous.snakes[i];
+            for (const std::pair<int, int>& cell : (previous_own && previous_own->id == s.id) ? previous_own->coords : s.coords) {
+                clear(cell);
+            }
+        }
+    }
+
+    diffFood(previous.food, current.food);
+
+    resolveContested(current, own);
+}
+
+void BoardDiff::contest(const std::pair<int, int>& cell) {
+    uint32_t& mark = contest_marks_[index(cell)];
+    if (mark != stamp_) {
+        mark = stamp_;
+        contested_.push_back(cell);
+    }
+}
+
+void BoardDiff::resolveContested(const WorldSnapshot& current, const snakejson::snake* own) {
+    // A cleared cell that still has something on it that wasn't painted this time would be left blank,
+    // and a painted cell that something else is on as well may have been painted in the wrong color
+    contested_.clear();
+    for (const std::pair<int, int>& cell : cleared_) {
+        std::size_t i = index(cell);
+        if (covers_[i] > 0 && paint_marks_[i] != stamp_) {
+            contest(cell);
+        }
+    }
+    for (const DirtyCell& dirty : painted_) {
+        if (covers_[index(dirty.cell)] > 1) {
+            contest(dirty.cell);
+        }
+    }
+    if (contested_.empty()) {
+        return;
+    }
+
+    // Look up what is on them the way a full repaint would, food first and then the snakes in order, the
+    // last thing drawn on a cell wins. Food is in food_marks_ already.
+    std::size_t resolved_from = painted_.size();
+    for (const std::pair<int, int>& cell : contested_) {
+        if (food_marks_[index(cell)] >= stamp_) {
+            resolve(cell, kFoodColor);
+        }
+    }
+
+    // Snakes can only be on cells within their length of their head, so only the bodies of snakes with a
+    // contested cell in reach are looked at. Contested cells are counted per tile, and the counts summed so
+    // the tiles in reach of a snake are counted at once.
+    int width = rect_.right - rect_.left;
+    int height = rect_.bottom - rect_.top;
+    std::size_t tiles_wide = static_cast<std::size_t>(width + kTile - 1) / kTile + 1;
+    std::size_t tiles_high = static_cast<std::size_t>(height + kTile - 1) / kTile + 1;
+    tile_sums_.assign(tiles_wide * tiles_high, 0);
+    for (const std::pair<int, int>& cell : contested_) {
+        ++tile_sums_[((cell.second - rect_.top) / kTile + 1) * tiles_wide + (cell.first - rect_.left) / kTile + 1];
+    }
+    for (std::size_t y = 1; y < tiles_high; ++y) {
+        for (std::size_t x = 1; x < tiles_wide; ++x) {
+            tile_sums_[y * tiles_wide + x] += tile_sums_[(y - 1) * tiles_wide + x] + tile_sums_[y * tiles_wide + x - 1] -
+                                              tile_sums_[(y - 1) * tiles_wide + x - 1];
+        }
+    }
+
+    for (const snakejson::snake& s : current.snakes) {
+        const snakejson::snake& shown = (own && own->id == s.id) ? *own : s;
+        if (shown.coords.empty()) {
+            continue;
+        }
+        int reach = static_cast<int>(shown.coords.size());
+        const std::pair<int, int>& head = shown.coords.front();
+        int left = std::max(rect_.left, head.first - reach);
+        int right = std::min(rect_.right - 1, head.first + reach);
+        int top = std::max(rect_.top, head.second - reach);
+        int bottom = std::min(rect_.bottom - 1, head.second + reach);
+        if (left > right || top > bottom) {
+            continue;
+        }
+        std::size_t x0 = (left - rect_.left) / kTile, x1 = (right - rect_.left) / kTile + 1;
+        std::size_t y0 = (top - rect_.top) / kTile, y1 = (bottom - rect_.top) / kTile + 1;
+        uint32_t in_reach = tile_sums_[y1 * tiles_wide + x1] - tile_sums_[y0 * tiles_wide + x1] -
+                            tile_sums_[y1 * tiles_wide + x0] + tile_sums_[y0 * tiles_wide + x0];
+        if (in_reach == 0) {
+            continue;
+        }
+        for (const std::pair<int, int>& cell : shown.coords) {
+            if (rect_.contains(cell) && contest_marks_[index(cell)] == stamp_) {
+                resolve(cell, s.color);
+            }
+        }
+    }
+    resolved_cells_ += painted_.size() - resolved_from;
+}
+
+void BoardDiff::resolve(const std::pair<int, int>& cell, const std::array<int, 3>& color) {
+    // The first time a contested cell comes up it gets an entry after everything else painted, after that
+    // the entry is recolored. stamp_ + 1 in paint_marks_ marks a cell that has one.
+    std::size_t i = index(cell);
+    if (paint_marks_[i] != stamp_ + 1) {
+        paint_marks_[i] = stamp_ + 1;
+        resolved_[i] = static_cast<uint32_t>(painted_.size());
+        DirtyCell dirty;
+        dirty.cell = cell;
+        dirty.color = color;
+        painted_.push_back(dirty);
+    } else {
+        painted_[resolved_[i]].color = color;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef BOARD_DIFF_H
+#define BOARD_DIFF_H
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "camera.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    // One cell that looks different than it did, and what it should look like now
+    struct DirtyCell {
+        std::pair<int, int> cell;
+        std::array<int, 3> color; // What to paint, ignored for cells that are cleared
+    };
+
+    /*
+     Works out which cells of the board changed between two world states, so a renderer that keeps the last
+     picture can repaint only those. A snake that moved k cells has k new cells at the front and lost the
+     cells past its new length at the back, and the rest of its body is where it was, so telling which is
+     which takes a look at its head rather than its whole body. Snakes that appear, disappear or jump
+     (respawns, snakes coming into view) are cleared and painted in full. Food is compared as sets.
+     Cleared cells come out before painted ones: a cell one snake's tail left and another's head moved into
+     is cleared and then painted. Only cells inside the rect passed to reset() come out.
+     Every cell keeps a count of the things on it, so cells that more than one thing is on, like a dead
+     snake's body that another snake crawls over, are noticed. Those are looked up in the new state to
+     paint them the same color a full repaint would, which only looks at the bodies of snakes whose head is
+     close enough to reach one of them.
+     */
+    class BoardDiff {
+    public:
+        static const std::size_t kMaxShift = 8; // A snake that moved further than this is repainted in full
+        static const int kTile = 16; // Side in cells of the tiles contested cells are counted in
+
+    private:
+        std::vector<std::pair<int, int>> cleared_;
+        std::vector<DirtyCell> painted_;
+        CellRect rect_;
+
+        SnakeIndex previous_index_; // The previous state's snakes by id
+        std::vector<bool> previous_kept_; // Per snake of the previous state, whether the current one has it too
+
+        // Per cell of rect_, row major: how many food pellets and snake cells are on it, the stamp of the last
+        // diff that had food there, that painted it and that found it contested, and where in painted_ its
+        // contested color went. Stamps save clearing the marks between diffs.
+        std::vector<uint16_t> covers_;
+        std::vector<uint32_t> food_marks_;
+        std::vector<uint32_t> paint_marks_;
+        std::vector<uint32_t> contest_marks_;
+        std::vector<uint32_t> resolved_;
+        uint32_t stamp_ = 0;
+        std::vector<std::pair<int, int>> contested_; // Cells more than one thing is on, or was on, this diff
+        std::vector<uint32_t> tile_sums_; // Contested cells in the tiles above and left of each, one row and column of zeros first
+        uint64_t resolved_cells_ = 0;
+
+        std::size_t index(const std::pair<int, int>& cell) const {
+            return static_cast<std::size_t>(cell.second - rect_.top) * (rect_.right - rect_.left) + (cell.first - rect_.left);
+        }
+        void clear(const std::pair<int, int>& cell);
+        void paint(const std::pair<int, int>& cell, const std::array<int, 3>& color);
+        void diffSnake(const std::vector<std::pair<int, int>>& before, const std::vector<std::pair<int, int>>& after,
+                       const std::array<int, 3>& color);
+        void diffFood(const std::vector<std::pair<int, int>>& before, const std::vector<std::pair<int, int>>& after);
+        void contest(const std::pair<int, int>& cell);
+        void resolveContested(const WorldSnapshot& current, const snakejson::snake* own);
+        void resolve(const std::pair<int, int>& cell, const std::array<int, 3>& color);
+
+    public:
+        // Starts over from a picture of current inside rect, own standing in for the snake with the same id
+        // like BoardRenderer::rebuild(). Call after every full repaint.
+        void reset(const WorldSnapshot& current, const snakejson::snake* own, const CellRect& rect);
+
+        /*
+         Finds the cells that differ between previous, the state of the last reset() or diff(), and current.
+         previous_own and own stand in for the snake with the same id in each. previous and current may be
+         the same state when only our predicted snake moved.
+         */
+        void diff(const WorldSnapshot& previous, const snakejson::snake* previous_own,
+                  const WorldSnapshot& current, const snakejson::snake* own);
+
+        const std::vector<std::pair<int, int>>& cleared() const { return cleared_; }
+        const std::vector<DirtyCell>& painted() const { return painted_; }
+        const CellRect& rect() const { return rect_; }
+        uint64_t resolvedCells() const { return resolved_cells_; } // Contested cells looked up so far
+    };
+
+    const std::array<int, 3> kFoodColor = {{255, 0, 0}};
+} // namespace snakelinkedlist
+
+#endif
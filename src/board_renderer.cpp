@@ -0,0 +1,152 @@
+#include "board_renderer.h"
+#include <chrono>
+
+using namespace snakelinkedlist;
+
+BoardRenderer::BoardRenderer() {
+    mesh_.setMode(OF_PRIMITIVE_TRIANGLES);
+    mesh_.setUsage(GL_DYNAMIC_DRAW); // Rewritten on every server tick, or every frame while interpolating
+}
+
+void BoardRenderer::writeCell(std::size_t first, float x, float y, const ofFloatColor& color) {
+    std::vector<ofDefaultVertexType>& vertices = mesh_.getVertices();
+    vertices[first] = ofDefaultVertexType(x, y, 0);
+    vertices[first + 1] = ofDefaultVertexType(x + 1, y, 0);
+    vertices[first + 2] = ofDefaultVertexType(x + 1, y + 1, 0);
+    vertices[first + 3] = ofDefaultVertexType(x, y + 1, 0);
+
+    std::vector<ofFloatColor>& colors = mesh_.getColors();
+    for (std::size_t i = first; i < first + 4; ++i) {
+        colors[i] = color;
+    }
+}
+
+void BoardRenderer::resize(std::size_t cells) {
+    mesh_.getVertices().resize(cells * 4);
+    mesh_.getColors().resize(cells * 4);
+
+    // The index pattern is the same for every cell, only extend it when the board grows
+    std::vector<ofIndexType>& indices = mesh_.getIndices();
+    std::size_t indexed = indices.size() / 6;
+    indices.resize(cells * 6);
+    for (std::size_t cell = indexed; cell < cells; ++cell) {
+        ofIndexType base = static_cast<ofIndexType>(cell * 4);
+        ofIndexType* quad = &indices[cell * 6];
+        quad[0] = base;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+        quad[3] = base;
+        quad[4] = base + 2;
+        quad[5] = base + 3;
+    }
+}
+
+void BoardRenderer::rebuild(const WorldSnapshot& snapshot, const CellRect& region, const snakejson::snake* own) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Count first so the arrays are resized once, the rect test is far cheaper than writing a cell
+    std::size_t cells = 0;
+    std::size_t board_cells = forEachCellIn(snapshot, region, own, [&cells](const std::pair<int, int>&, const snakejson::snake*) {
+        ++cells;
+    });
+    resize(cells);
+
+    std::size_t vertex = 0;
+    const ofFloatColor food_color(1, 0, 0);
+    forEachCellIn(snapshot, region, own, [&](const std::pair<int, int>& cell, const snakejson::snake* s) {
+        float x = static_cast<float>(cell.first);
+        float y = static_cast<float>(cell.second);
+        if (s) {
+            writeCell(vertex, x, y, ofFloatColor(s->color[0] / 255.0f, s->color[1] / 255.0f, s->color[2] / 255.0f));
+        } else {
+            writeCell(vertex, x, y, food_color);
+        }
+        vertex += 4;
+    });
+
+    cells_ = cells;
+    board_cells_ = board_cells;
+    region_ = region;
+    build_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BoardRenderer::rebuild(const InterpolatedFrame& frame, const CellRect& region) {
+    auto start = std::chrono::steady_clock::now();
+
+    // A segment between two cells overlaps both, so it is in if its top left corner is less than a cell outside
+    auto inside = [&region](const std::pair<float, float>& corner) {
+        return corner.first > region.left - 1 && corner.first < region.right
+            && corner.second > region.top - 1 && corner.second < region.bottom;
+    };
+    // Like forEachCellIn(), a snake whose head is further from region than its length can't reach into it
+    auto skip = [&region](const InterpolatedSnake& s) {
+        if (s.coords.empty()) {
+            return true;
+        }
+        CellRect reach = region.grown(static_cast<int>(s.coords.size()) + 1);
+        return !reach.contains(std::make_pair(static_cast<int>(s.coords.front().first), static_cast<int>(s.coords.front().second)));
+    };
+
+    std::size_t cells = 0;
+    std::size_t board_cells = 0;
+    if (frame.food) {
+        board_cells += frame.food->size();
+        for (const std::pair<int, int>& cell : *frame.food) {
+            cells += region.contains(cell) ? 1 : 0;
+        }
+    }
+    for (std::size_t i = 0; i < frame.snake_count; ++i) {
+        const InterpolatedSnake& s = frame.snakes[i];
+        board_cells += s.coords.size();
+        if (skip(s)) {
+            continue;
+        }
+        for (const std::pair<float, float>& corner : s.coords) {
+            cells += inside(corner) ? 1 : 0;
+        }
+    }
+    resize(cells);
+
+    std::size_t vertex = 0;
+    if (frame.food) {
+        const ofFloatColor food_color(1, 0, 0);
+        for (const std::pair<int, int>& cell : *frame.food) {
+            if (region.contains(cell)) {
+                writeCell(vertex, static_cast<float>(cell.first), static_cast<float>(cell.second), food_color);
+                vertex += 4;
+            }
+        }
+    }
+    for (std::size_t i = 0; i < frame.snake_count; ++i) {
+        const InterpolatedSnake& s = frame.snakes[i];
+        if (skip(s)) {
+            continue;
+        }
+        ofFloatColor color(s.color[0] / 255.0f, s.color[1] / 255.0f, s.color[2] / 255.0f);
+        for (const std::pair<float, float>& corner : s.coords) {
+            if (inside(corner)) {
+                writeCell(vertex, corner.first, corner.second, color);
+                vertex += 4;
+            }
+        }
+    }
+
+    cells_ = cells;
+    board_cells_ = board_cells;
+    region_ = region;
+    build_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int BoardRenderer::draw(const Camera& camera) {
+    if (cells_ == 0) {
+        return 0;
+    }
+    // Vertex colors multiply with the current color, which has to be white for them to show as is
+    ofSetColor(255, 255, 255);
+    ofPushMatrix();
+    ofTranslate(camera.offsetX(), camera.offsetY());
+    ofScale(camera.cellSize(), camera.cellSize());
+    mesh_.draw();
+    ofPopMatrix();
+    return 1;
+}
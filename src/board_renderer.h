@@ -0,0 +1,69 @@
+#ifndef BOARD_RENDERER_H
+#define BOARD_RENDERER_H
+#pragma once
+#include <cstddef>
+
+#include "camera.h"
+#include "ofMain.h"
+#include "snapshot_interpolator.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    // Per frame rendering counters, shown on screen so we can see how drawing scales with the board
+    struct RenderStats {
+        int draw_calls = 0; // Draw calls issued for the board in the last frame
+        std::size_t cells = 0; // Cells drawn in the last frame
+        std::size_t board_cells = 0; // Cells on the whole board, the ones off screen were culled
+        double build_ms = 0; // Time it took to rebuild the mesh for the last new snapshot
+        double draw_ms = 0; // CPU time spent in draw(), smoothed over recent frames
+    };
+
+    /*
+     Draws the whole board (food and every snake segment) as a single mesh.
+     The mesh is rebuilt only when a new snapshot arrives, or every frame while snakes slide between two
+     interpolated states, and is kept in a VBO between frames, so each frame costs one draw call however many
+     cells are on the board. The vertex, color and index
+     arrays keep their capacity between rebuilds, and a steady board size causes no reallocation.
+     Only cells inside the region passed to rebuild() go into the mesh, so on a large arena the cost
+     follows what is on screen rather than the size of the board. The mesh is in cell units and
+     draw() scales and moves it with the camera, so panning and zooming within the region need no rebuild.
+     */
+    class BoardRenderer {
+    private:
+        ofVboMesh mesh_; // Two triangles per cell with per-vertex colors
+        std::size_t cells_ = 0; // Cells currently in the mesh
+        std::size_t board_cells_ = 0; // Cells in the snapshot the mesh was built from
+        CellRect region_; // The cells the mesh covers
+        double build_ms_ = 0;
+
+        // Writes the four corners of one cell, top left corner at x, y, starting at vertex index first
+        void writeCell(std::size_t first, float x, float y, const ofFloatColor& color);
+
+        // Sizes the vertex and color arrays for cells cells and extends the index pattern to cover them
+        void resize(std::size_t cells);
+
+    public:
+        BoardRenderer();
+
+        // Rebuilds the mesh from the cells of snapshot inside region. If own is given it is drawn in place of
+        // the snapshot's snake with the same id, which is how our predicted snake gets on screen.
+        void rebuild(const WorldSnapshot& snapshot, const CellRect& region, const snakejson::snake* own = nullptr);
+
+        // Rebuilds the mesh from an interpolated frame, whose segments sit between cells. A segment is kept
+        // if any part of it is inside region.
+        void rebuild(const InterpolatedFrame& frame, const CellRect& region);
+
+        // Draws the board where camera puts it, returns the number of draw calls issued
+        int draw(const Camera& camera);
+
+        // The cells the last rebuild() covered. Once the camera sees past them the mesh needs rebuilding.
+        const CellRect& region() const { return region_; }
+
+        std::size_t cells() const { return cells_; }
+        std::size_t boardCells() const { return board_cells_; }
+        double buildMs() const { return build_ms_; }
+    };
+} // namespace snakelinkedlist
+
+#endif
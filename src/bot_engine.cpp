@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include "bot_engine.h"
+
+namespace snakelinkedlist {
+
+    const uint16_t BotEngine::kUnreachable;
+    const int BotEngine::kWindow;
+
+    namespace {
+
+        typedef std::chrono::steady_clock Clock;
+
+        // Boards smaller than this many words spread one BFS layer over a single thread, waking the others
+        // would cost more than the layer
+        const std::size_t kParallelLayerWords = 1 << 14;
+        const std::size_t kBotsPerChunk = 16;
+
+        const char kActions[] = {'W', 'A', 'S', 'D'};
+        const int kStepX[] = {0, -1, 0, 1};
+        const int kStepY[] = {-1, 0, 1, 0};
+
+        bool opposite(char a, char b) {
+            return (a == 'W' && b == 'S') || (a == 'S' && b == 'W') || (a == 'A' && b == 'D') || (a == 'D' && b == 'A');
+        }
+    } // namespace
+
+    BotEngine::BotEngine(std::size_t threads) : pool_(threads) {
+    }
+
+    void BotEngine::load(const WorldSnapshot& state, int width, int height) {
+        Clock::time_point start = Clock::now();
+        state_ = &state;
+        width_ = std::max(width, 0);
+        height_ = std::max(height, 0);
+        buildBoards(state);
+        spreadDistances();
+        ++stats_.states;
+        stats_.load_time += Clock::now() - start;
+    }
+
+    void BotEngine::buildBoards(const WorldSnapshot& state) {
+        if (blocked_.width() != width_ || blocked_.height() != height_) {
+            blocked_.resize(width_, height_);
+            heads_.resize(width_, height_);
+            frontier_.resize(width_, height_);
+            reached_.resize(width_, height_);
+            next_.resize(width_, height_);
+            distance_.resize(static_cast<std::size_t>(width_) * height_);
+        } else {
+            blocked_.clear();
+            heads_.clear();
+        }
+
+        int max_id = 0;
+        for (const snakejson::snake& s : state.snakes) {
+            max_id = std::max(max_id, s.id);
+        }
+        snake_index_.assign(static_cast<std::size_t>(max_id) + 1, -1);
+        for (std::size_t i = 0; i < state.snakes.size(); ++i) {
+            const snakejson::snake& s = state.snakes[i];
+            if (s.id >= 0) {
+                snake_index_[s.id] = static_cast<int>(i);
+            }
+            if (!s.alive || s.coords.empty()) {
+                continue;
+            }
+            for (const std::pair<int, int>& cell : s.coords) {
+                blocked_.set(cell.first, cell.second);
+            }
+            heads_.set(s.coords.front().first, s.coords.front().second);
+        }
+        open_ = blocked_;
+        open_.invert();
+    }
+
+    void BotEngine::spreadDistances() {
+        std::fill(distance_.begin(), distance_.end(), kUnreachable);
+        frontier_.clear();
+        for (const std::pair<int, int>& food : state_->food) {
+            if (open_.test(food.first, food.second)) {
+                frontier_.set(food.first, food.second);
+                distance_[static_cast<std::size_t>(food.second) * width_ + food.first] = 0;
+            }
+        }
+        reached_ = frontier_;
+
+        std::size_t stride = open_.stride();
+        std::size_t rows_per_band = static_cast<std::size_t>(height_);
+        if (stride * height_ >= kParallelLayerWords) {
+            rows_per_band = std::max<std::size_t>(1, height_ / (pool_.threads() * 4));
+        }
+        for (uint16_t layer = 1; layer < kUnreachable; ++layer) {
+            std::atomic<bool> grew(false);
+            pool_.parallelFor(static_cast<std::size_t>(height_), rows_per_band, [&](std::size_t first, std::size_t last) {
+                frontier_.dilateInto(open_, next_, static_cast<int>(first), static_cast<int>(last));
+                bool any = false;
+                for (std::size_t y = first; y < last; ++y) {
+                    uint64_t* fresh = next_.row(static_cast<int>(y));
+                    uint64_t* seen = reached_.row(static_cast<int>(y));
+                    uint16_t* distances = &distance_[y * width_];
+                    for (std::size_t w = 0; w < stride; ++w) {
+                        uint64_t bits = fresh[w] & ~seen[w];
+                        fresh[w] = bits;
+                        seen[w] |= bits;
+                        any = any || bits != 0;
+                        while (bits) {
+                            distances[w * 64 + lowestBit(bits)] = layer;
+                            bits &= bits - 1;
+                        }
+                    }
+                }
+                if (any) {
+                    grew.store(true, std::memory_order_relaxed);
+                }
+            });
+            if (!grew.load(std::memory_order_relaxed)) {
+                break;
+            }
+            std::swap(frontier_, next_);
+        }
+    }
+
+    uint16_t BotEngine::distance(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+            return kUnreachable;
+        }
+        return distance_[static_cast<std::size_t>(y) * width_ + x];
+    }
+
+    std::size_t BotEngine::roomAt(int x, int y, std::size_t needed, Bitboard& window, Bitboard& fill, Bitboard& grown) const {
+        const int half = kWindow / 2;
+        blocked_.windowInto(x - half, y - half, kWindow, window);
+        window.invert();
+        fill.resize(kWindow, kWindow);
+        if (grown.width() != kWindow || grown.height() != kWindow) {
+            grown.resize(kWindow, kWindow);
+        }
+        fill.set(half, half);
+        std::size_t room = 1;
+        while (room < needed) {
+            fill.dilateInto(window, grown, 0, kWindow);
+            std::size_t more = grown.count();
+            if (more == room) {
+                break; // Nowhere left to go
+            }
+            room = more;
+            std::swap(fill, grown);
+        }
+        return room;
+    }
+
+    BotDecision BotEngine::decideOne(int id, Bitboard& window, Bitboard& fill, Bitboard& grown) const {
+        BotDecision decision;
+        decision.id = id;
+        if (id < 0 || static_cast<std::size_t>(id) >= snake_index_.size() || snake_index_[id] < 0) {
+            return decision;
+        }
+        const snakejson::snake& s = state_->snakes[snake_index_[id]];
+        if (!s.alive) {
+            decision.action = 'R';
+            return decision;
+        }
+        if (s.coords.empty()) {
+            return decision;
+        }
+
+        const int head_x = s.coords.front().first;
+        const int head_y = s.coords.front().second;
+        const char current = s.direction.empty() ? 0 : s.direction[0];
+        // The window can't see further than itself, a quarter of it is plenty of room
+        const std::size_t needed = std::min<std::size_t>(s.coords.size(), kWindow * kWindow / 4);
+
+        // Lower is better: boxed in, next to another head, distance to food, turning
+        struct Score {
+            bool trapped;
+            bool risky;
+            uint16_t distance;
+            bool turns;
+            bool operator<(const Score& other) const {
+                if (trapped != other.trapped) return !trapped;
+                if (risky != other.risky) return !risky;
+                if (distance != other.distance) return distance < other.distance;
+                return !turns && other.turns;
+            }
+        };
+        bool found = false;
+        Score best = Score();
+        char best_action = current;
+        for (int d = 0; d < 4; ++d) {
+            char action = kActions[d];
+            if (s.coords.size() > 1 && opposite(action, current)) {
+                continue;
+            }
+            int x = head_x + kStepX[d];
+            int y = head_y + kStepY[d];
+            if (!open_.test(x, y)) {
+                continue;
+            }
+            Score score;
+            score.trapped = roomAt(x, y, needed, window, fill, grown) < needed;
+            score.risky = false;
+            for (int n = 0; n < 4; ++n) {
+                int nx = x + kStepX[n];
+                int ny = y + kStepY[n];
+                if ((nx != head_x || ny != head_y) && heads_.test(nx, ny)) {
+                    score.risky = true;
+                }
+            }
+            score.distance = distance_[static_cast<std::size_t>(y) * width_ + x];
+            score.turns = action != current;
+            if (!found || score < best) {
+                found = true;
+                best = score;
+                best_action = action;
+            }
+        }
+        decision.trapped = !found || best.trapped;
+        if (found && best_action != current) {
+            decision.action = best_action;
+        }
+        return decision;
+    }
+
+    void BotEngine::decide(const std::vector<int>& ids, std::vector<BotDecision>& decisions) {
+        Clock::time_point start = Clock::now();
+        decisions.resize(ids.size());
+        pool_.parallelFor(ids.size(), kBotsPerChunk, [&](std::size_t first, std::size_t last) {
+            // Scratch boards per thread, sized once and reused for every bot after that
+            static thread_local Bitboard window;
+            static thread_local Bitboard fill;
+            static thread_local Bitboard grown;
+            for (std::size_t i = first; i < last; ++i) {
+                decisions[i] = decideOne(ids[i], window, fill, grown);
+            }
+        });
+        stats_.decisions += ids.size();
+        stats_.decide_time += Clock::now() - start;
+    }
+
+} // namespace snakelinkedlist
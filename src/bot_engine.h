@@ -0,0 +1,85 @@
+#ifndef BOT_ENGINE_H
+#define BOT_ENGINE_H
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+#include "work_stealing_pool.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    // What one bot wants to do this tick
+    struct BotDecision {
+        int id = 0;
+        char action = 0; // W, A, S, D or R to send, 0 if the snake should carry on as it is
+        bool trapped = false; // Every way out leads somewhere smaller than the snake
+    };
+
+    struct BotStats {
+        uint64_t states = 0; // World states loaded
+        uint64_t decisions = 0;
+        std::chrono::steady_clock::duration load_time{0}; // Building the bitboards and the food distances
+        std::chrono::steady_clock::duration decide_time{0};
+    };
+
+    /*
+     Steers any number of snakes towards food from the world states the client receives.
+     load() turns a state into bitboards, one bit per cell for what is blocked (walls are off the board,
+     bodies of live snakes are on it), where the heads are and where the food is. It then runs one BFS from
+     every pellet at once over the open cells, a layer at a time as bitboard dilations, which gives every cell
+     its distance to the nearest food. That is shared by all bots, so no bot runs a BFS of its own.
+     decide() then only looks at each bot's neighbourhood: of the moves that don't hit anything it prefers
+     ones that leave room, found by flood filling a bitboard window around the move until there is space for
+     the whole snake, then ones away from other snakes' heads, then the one closest to food. Bots are spread
+     across a WorkStealingPool, and so are the rows of each BFS layer on big boards.
+     */
+    class BotEngine {
+    public:
+        static const uint16_t kUnreachable = 0xFFFF; // Distance of a cell no food can be reached from
+        static const int kWindow = 64; // Side of the square a bot flood fills to see whether a move leaves room
+
+    private:
+        WorkStealingPool pool_;
+        int width_ = 0;
+        int height_ = 0;
+
+        Bitboard blocked_; // Bodies of live snakes
+        Bitboard open_; // Not blocked, what a BFS may step into
+        Bitboard heads_; // Heads of live snakes
+        Bitboard frontier_; // Cells the food BFS reached on its last layer, and the layer being built
+        Bitboard reached_;
+        Bitboard next_;
+        std::vector<uint16_t> distance_; // Row major steps to the nearest food, kUnreachable if there is none
+
+        std::vector<int> snake_index_; // By snake id, index in the loaded state's snakes or -1
+        const WorldSnapshot* state_ = nullptr;
+
+        BotStats stats_;
+
+        void buildBoards(const WorldSnapshot& state);
+        void spreadDistances();
+        BotDecision decideOne(int id, Bitboard& window, Bitboard& fill, Bitboard& grown) const;
+        std::size_t roomAt(int x, int y, std::size_t needed, Bitboard& window, Bitboard& fill, Bitboard& grown) const;
+
+    public:
+        explicit BotEngine(std::size_t threads); // Threads for decide() and the BFS, the caller included
+
+        // Reads a world state. The state must stay alive and unchanged until the next load().
+        void load(const WorldSnapshot& state, int width, int height);
+
+        // One decision per id in ids, in the same order. Snakes that are dead get an R, ids that are
+        // not in the state get no action.
+        void decide(const std::vector<int>& ids, std::vector<BotDecision>& decisions);
+
+        uint16_t distance(int x, int y) const; // Steps from the cell to the nearest food
+        const BotStats& stats() const { return stats_; }
+        std::size_t threads() const { return pool_.threads(); }
+        uint64_t steals() const { return pool_.steals(); }
+    };
+
+} // namespace snakelinkedlist
+#endif
@@ -0,0 +1,58 @@
+#include "camera.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace snakelinkedlist;
+
+Camera::Camera(int arena_width, int arena_height, float screen_width, float screen_height)
+    : arena_width_(arena_width), arena_height_(arena_height), screen_width_(screen_width),
+      screen_height_(screen_height), center_x_(arena_width / 2.0), center_y_(arena_height / 2.0) {
+    clamp();
+}
+
+void Camera::resize(float screen_width, float screen_height) {
+    screen_width_ = screen_width;
+    screen_height_ = screen_height;
+    clamp();
+}
+
+void Camera::zoom(float factor) {
+    cell_size_ = std::min(kMaxCellSize, std::max(kMinCellSize, cell_size_ * factor));
+    clamp();
+}
+
+void Camera::follow(const std::pair<int, int>& cell, double seconds) {
+    double target_x = cell.first + 0.5;
+    double target_y = cell.second + 0.5;
+    // Exponential easing, the same fraction of the gap closes per second whatever the frame rate
+    double step = seconds <= 0 ? 1 : 1 - std::exp(-seconds / kFollowSeconds);
+    center_x_ += (target_x - center_x_) * step;
+    center_y_ += (target_y - center_y_) * step;
+    clamp();
+}
+
+void Camera::clamp() {
+    double half_width = screen_width_ / 2 / cell_size_;
+    double half_height = screen_height_ / 2 / cell_size_;
+    if (2 * half_width >= arena_width_) {
+        center_x_ = arena_width_ / 2.0;
+    } else {
+        center_x_ = std::min(arena_width_ - half_width, std::max(half_width, center_x_));
+    }
+    if (2 * half_height >= arena_height_) {
+        center_y_ = arena_height_ / 2.0;
+    } else {
+        center_y_ = std::min(arena_height_ - half_height, std::max(half_height, center_y_));
+    }
+}
+
+CellRect Camera::visibleCells() const {
+    double half_width = screen_width_ / 2 / cell_size_;
+    double half_height = screen_height_ / 2 / cell_size_;
+    CellRect rect;
+    rect.left = static_cast<int>(std::floor(center_x_ - half_width));
+    rect.top = static_cast<int>(std::floor(center_y_ - half_height));
+    rect.right = static_cast<int>(std::ceil(center_x_ + half_width));
+    rect.bottom = static_cast<int>(std::ceil(center_y_ + half_height));
+    return rect;
+}
@@ -0,0 +1,120 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+#pragma once
+#include <cstddef>
+#include <utility>
+
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    const float kDefaultCellSize = 25; // Size in pixels of one grid cell on screen, before zooming
+    const float kMinCellSize = 2; // Zoomed all the way out
+    const float kMaxCellSize = 100; // Zoomed all the way in
+    const double kFollowSeconds = 0.15; // The camera closes most of the gap to our snake's head in about this long
+
+    // A block of grid cells, left and top included, right and bottom excluded
+    struct CellRect {
+        int left = 0;
+        int top = 0;
+        int right = 0;
+        int bottom = 0;
+
+        bool contains(const std::pair<int, int>& cell) const {
+            return cell.first >= left && cell.first < right && cell.second >= top && cell.second < bottom;
+        }
+        bool operator==(const CellRect& other) const {
+            return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+        }
+        bool contains(const CellRect& other) const {
+            return other.left >= left && other.right <= right && other.top >= top && other.bottom <= bottom;
+        }
+        // The same rect with margin more cells on every side
+        CellRect grown(int margin) const {
+            CellRect rect;
+            rect.left = left - margin;
+            rect.top = top - margin;
+            rect.right = right + margin;
+            rect.bottom = bottom + margin;
+            return rect;
+        }
+    };
+
+    /*
+     Which part of the arena is on screen, and at what zoom.
+     The camera keeps the world position, in cells, that sits at the middle of the window and the size of a
+     cell in pixels. Screen position = (world position - center) * cell size + half the window.
+     It eases towards our snake's head rather than jumping with it, and never shows past the arena's edges
+     unless the whole arena fits in the window, in which case the arena is centered.
+     */
+    class Camera {
+    private:
+        int arena_width_; // Cells
+        int arena_height_;
+        float screen_width_; // Pixels
+        float screen_height_;
+        float cell_size_ = kDefaultCellSize;
+        double center_x_; // Cells, may be fractional while the camera is moving
+        double center_y_;
+
+        // Keeps the view inside the arena, or centered on it when it fits
+        void clamp();
+
+    public:
+        Camera(int arena_width, int arena_height, float screen_width, float screen_height);
+
+        void resize(float screen_width, float screen_height);
+
+        // Multiplies the cell size by factor, keeping it between kMinCellSize and kMaxCellSize
+        void zoom(float factor);
+
+        // Moves towards the middle of cell, seconds is the time since the last call. Jumps there if seconds <= 0.
+        void follow(const std::pair<int, int>& cell, double seconds);
+
+        float cellSize() const { return cell_size_; }
+
+        // Screen position of the top left corner of cell (0, 0), the translation to draw world cells with
+        float offsetX() const { return static_cast<float>(screen_width_ / 2 - center_x_ * cell_size_); }
+        float offsetY() const { return static_cast<float>(screen_height_ / 2 - center_y_ * cell_size_); }
+
+        // Top left corner of cell on screen, in pixels
+        std::pair<float, float> worldToScreen(const std::pair<int, int>& cell) const {
+            return std::make_pair(offsetX() + cell.first * cell_size_, offsetY() + cell.second * cell_size_);
+        }
+
+        // Every cell at least partly on screen
+        CellRect visibleCells() const;
+    };
+
+    /*
+     Calls f(cell, snake) for every cell of the board inside rect, with snake nullptr for food.
+     If own is given it is used in place of the snapshot's snake with the same id, like BoardRenderer::rebuild().
+     Every cell of a body is next to the one before it, so no cell is further than the body's length from the head.
+     A snake whose head is further than that from rect is skipped without looking at the rest of its body, which
+     keeps a huge arena about as cheap as the number of snakes on it. Returns the number of cells on the board.
+     */
+    template <typename F>
+    std::size_t forEachCellIn(const WorldSnapshot& snapshot, const CellRect& rect, const snakejson::snake* own, F&& f) {
+        std::size_t board_cells = snapshot.food.size();
+        for (const std::pair<int, int>& cell : snapshot.food) {
+            if (rect.contains(cell)) {
+                f(cell, static_cast<const snakejson::snake*>(nullptr));
+            }
+        }
+        for (const snakejson::snake& s : snapshot.snakes) {
+            const snakejson::snake& shown = (own && own->id == s.id) ? *own : s;
+            board_cells += shown.coords.size();
+            if (shown.coords.empty() || !rect.grown(static_cast<int>(shown.coords.size())).contains(shown.coords.front())) {
+                continue;
+            }
+            for (const std::pair<int, int>& cell : shown.coords) {
+                if (rect.contains(cell)) {
+                    f(cell, &s);
+                }
+            }
+        }
+        return board_cells;
+    }
+} // namespace snakelinkedlist
+
+#endif
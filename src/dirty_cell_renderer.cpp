@@ -0,0 +1,159 @@
+#include "dirty_cell_renderer.h"
+#include <chrono>
+
+using namespace snakelinkedlist;
+
+namespace {
+    ofFloatColor toFloatColor(const std::array<int, 3>& color) {
+        return ofFloatColor(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f);
+    }
+} // namespace
+
+DirtyCellRenderer::DirtyCellRenderer() {
+    cells_mesh_.setMode(OF_PRIMITIVE_TRIANGLES);
+    cells_mesh_.setUsage(GL_DYNAMIC_DRAW); // Different cells every tick
+}
+
+void DirtyCellRenderer::resize(std::size_t cells) {
+    cells_mesh_.getVertices().resize(cells * 4);
+    cells_mesh_.getColors().resize(cells * 4);
+
+    // Same index pattern for every cell, as in BoardRenderer
+    std::vector<ofIndexType>& indices = cells_mesh_.getIndices();
+    std::size_t indexed = indices.size() / 6;
+    indices.resize(cells * 6);
+    for (std::size_t cell = indexed; cell < cells; ++cell) {
+        ofIndexType base = static_cast<ofIndexType>(cell * 4);
+        ofIndexType* quad = &indices[cell * 6];
+        quad[0] = base;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+        quad[3] = base;
+        quad[4] = base + 2;
+        quad[5] = base + 3;
+    }
+}
+
+void DirtyCellRenderer::writeCell(std::size_t cell, const std::pair<int, int>& at, const ofFloatColor& color) {
+    std::size_t first = cell * 4;
+    float x = static_cast<float>(at.first - region_.left);
+    float y = static_cast<float>(at.second - region_.top);
+    std::vector<ofDefaultVertexType>& vertices = cells_mesh_.getVertices();
+    vertices[first] = ofDefaultVertexType(x, y, 0);
+    vertices[first + 1] = ofDefaultVertexType(x + 1, y, 0);
+    vertices[first + 2] = ofDefaultVertexType(x + 1, y + 1, 0);
+    vertices[first + 3] = ofDefaultVertexType(x, y + 1, 0);
+
+    std::vector<ofFloatColor>& colors = cells_mesh_.getColors();
+    for (std::size_t i = first; i < first + 4; ++i) {
+        colors[i] = color;
+    }
+}
+
+void DirtyCellRenderer::repaintAll(const WorldSnapshot& current, const CellRect& region, const snakejson::snake* own) {
+    int width = region.right - region.left;
+    int height = region.bottom - region.top;
+    if (!fbo_.isAllocated() || static_cast<int>(fbo_.getWidth()) != width || static_cast<int>(fbo_.getHeight()) != height) {
+        fbo_.allocate(width, height, GL_RGBA);
+        fbo_.getTexture().setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+    }
+    region_ = region;
+
+    std::size_t cells = 0;
+    board_cells_ = forEachCellIn(current, region, own, [&cells](const std::pair<int, int>&, const snakejson::snake*) {
+        ++cells;
+    });
+    resize(cells);
+    std::size_t cell = 0;
+    const ofFloatColor food_color = toFloatColor(kFoodColor);
+    forEachCellIn(current, region, own, [&](const std::pair<int, int>& at, const snakejson::snake* s) {
+        writeCell(cell++, at, s ? toFloatColor(s->color) : food_color);
+    });
+
+    fbo_.begin();
+    ofClear(255, 255, 255, 0);
+    ofSetColor(255, 255, 255);
+    cells_mesh_.draw();
+    fbo_.end();
+
+    diff_.reset(current, own, region);
+    cells_painted_ = cells;
+    ++full_repaints_;
+}
+
+void DirtyCellRenderer::paintDirty() {
+    std::size_t cells = diff_.cleared().size() + diff_.painted().size();
+    resize(cells);
+    std::size_t cell = 0;
+    // Cleared cells go in first, transparent, and painted ones over them
+    const ofFloatColor empty(1, 1, 1, 0);
+    for (const std::pair<int, int>& at : diff_.cleared()) {
+        writeCell(cell++, at, empty);
+    }
+    for (const DirtyCell& dirty : diff_.painted()) {
+        writeCell(cell++, dirty.cell, toFloatColor(dirty.color));
+    }
+
+    fbo_.begin();
+    // Without blending a transparent quad replaces what is there instead of leaving it be
+    ofDisableAlphaBlending();
+    ofSetColor(255, 255, 255);
+    cells_mesh_.draw();
+    ofEnableAlphaBlending();
+    fbo_.end();
+
+    cells_painted_ = cells;
+    ++partial_repaints_;
+}
+
+void DirtyCellRenderer::rememberOwn(const snakejson::snake* own) {
+    has_painted_own_ = own != nullptr;
+    if (own) {
+        painted_own_.id = own->id;
+        painted_own_.coords = own->coords; // Reuses painted_own_'s capacity
+    }
+}
+
+bool DirtyCellRenderer::update(const WorldSnapshot& current, const WorldSnapshot* previous, const CellRect& region,
+                               const snakejson::snake* own) {
+    // The state the picture was painted from, if it is one of the two we have
+    const WorldSnapshot* base = nullptr;
+    if (painted_ == &current && painted_tick_ == current.tick) {
+        base = &current;
+    } else if (previous && painted_ == previous && painted_tick_ == previous->tick) {
+        base = previous;
+    }
+    bool own_unchanged = own ? has_painted_own_ && own->id == painted_own_.id && own->coords == painted_own_.coords
+                             : !has_painted_own_;
+    if (base == &current && own_unchanged && region == region_) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!base || !(region == region_) || !fbo_.isAllocated()) {
+        repaintAll(current, region, own);
+    } else {
+        diff_.diff(*base, has_painted_own_ ? &painted_own_ : nullptr, current, own);
+        paintDirty();
+        board_cells_ = current.food.size();
+        for (const snakejson::snake& s : current.snakes) {
+            board_cells_ += (own && own->id == s.id) ? own->coords.size() : s.coords.size();
+        }
+    }
+    painted_ = &current;
+    painted_tick_ = current.tick;
+    rememberOwn(own);
+    paint_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+int DirtyCellRenderer::draw(const Camera& camera) {
+    if (!painted_) {
+        return 0;
+    }
+    float cell_size = camera.cellSize();
+    ofSetColor(255, 255, 255);
+    fbo_.draw(camera.offsetX() + region_.left * cell_size, camera.offsetY() + region_.top * cell_size,
+              (region_.right - region_.left) * cell_size, (region_.bottom - region_.top) * cell_size);
+    return 1;
+}
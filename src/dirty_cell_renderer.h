@@ -0,0 +1,78 @@
+#ifndef DIRTY_CELL_RENDERER_H
+#define DIRTY_CELL_RENDERER_H
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "board_diff.h"
+#include "camera.h"
+#include "ofMain.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    /*
+     Keeps a picture of the board in a framebuffer that lasts from one frame to the next, one texel per cell,
+     and only paints the cells that changed. Between two ticks that is each snake's new head and old tail
+     and the food that was eaten or spawned (see BoardDiff), so the work per tick follows how much changed
+     rather than how long the snakes are. Every frame draws the framebuffer as one textured quad, scaled up
+     with nearest filtering so cells stay sharp. Like BoardRenderer the picture covers a region around what
+     is on screen, and it is painted from scratch when that region moves, when the state it was painted
+     from is no longer the previous one (states were skipped, or the mode was switched). Cells are whole
+     cells, snakes don't slide.
+     */
+    class DirtyCellRenderer {
+    private:
+        ofFbo fbo_; // Transparent where the board is empty, so whatever is drawn underneath shows through
+        ofVboMesh cells_mesh_; // The cells to paint into fbo_, two triangles each
+        CellRect region_;
+        BoardDiff diff_;
+
+        // What fbo_ shows: the state it was last painted from, by address and tick since states are recycled,
+        // and our predicted snake as it was painted
+        const WorldSnapshot* painted_ = nullptr;
+        uint64_t painted_tick_ = 0;
+        snakejson::snake painted_own_;
+        bool has_painted_own_ = false;
+
+        std::size_t cells_painted_ = 0; // Cells painted or cleared by the last update that painted anything
+        std::size_t board_cells_ = 0;
+        uint64_t full_repaints_ = 0;
+        uint64_t partial_repaints_ = 0;
+        double paint_ms_ = 0;
+
+        // Sizes cells_mesh_ for cells quads, and writes one of them at cell at, in texels of fbo_
+        void resize(std::size_t cells);
+        void writeCell(std::size_t cell, const std::pair<int, int>& at, const ofFloatColor& color);
+        void repaintAll(const WorldSnapshot& current, const CellRect& region, const snakejson::snake* own);
+        void paintDirty();
+        void rememberOwn(const snakejson::snake* own);
+
+    public:
+        DirtyCellRenderer();
+
+        /*
+         Brings the picture up to date with current, painting only what changed since it was last updated if
+         that was from current or previous. If own is given it is drawn in place of the snake with the same id.
+         region is the cells the picture should cover, a change of region repaints everything.
+         Returns whether anything was painted.
+         */
+        bool update(const WorldSnapshot& current, const WorldSnapshot* previous, const CellRect& region,
+                    const snakejson::snake* own);
+
+        // The next update() paints everything, for when the picture may be out of date
+        void invalidate() { painted_ = nullptr; }
+
+        // Draws the picture where camera puts it, returns the number of draw calls issued
+        int draw(const Camera& camera);
+
+        const CellRect& region() const { return region_; }
+        std::size_t cellsPainted() const { return cells_painted_; }
+        std::size_t boardCells() const { return board_cells_; }
+        uint64_t fullRepaints() const { return full_repaints_; }
+        uint64_t partialRepaints() const { return partial_repaints_; }
+        double paintMs() const { return paint_ms_; }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,106 @@
+#include "frame_decoder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace snakelinkedlist;
+
+const std::size_t FrameDecoder::kHeaderLength;
+const std::size_t FrameDecoder::kMaxBodyLength;
+const char FrameDecoder::kLongMarker;
+const std::size_t FrameDecoder::kLongHeaderLength;
+const std::size_t FrameDecoder::kMaxLongBodyLength;
+const std::size_t FrameDecoder::kBufferSize;
+
+FrameDecoder::FrameDecoder() : buffer_(kBufferSize) {
+}
+
+std::pair<char*, std::size_t> FrameDecoder::prepare() {
+    // Room behind begin_ for the message there, or for the longest short one while its length is unknown
+    std::size_t needed = std::max(waiting_, kHeaderLength + kMaxBodyLength);
+    if (begin_ == end_) {
+        begin_ = end_ = 0;
+    } else if (buffer_.size() - begin_ < needed) {
+        // The message that was cut short might not fit behind it, start it over at the front
+        std::size_t left = end_ - begin_;
+        std::memmove(buffer_.data(), buffer_.data() + begin_, left);
+        moved_bytes_ += left;
+        begin_ = 0;
+        end_ = left;
+    }
+    if (buffer_.size() < needed) {
+        buffer_.resize(std::max(needed, buffer_.size() * 2));
+    }
+    return std::make_pair(buffer_.data() + end_, buffer_.size() - end_);
+}
+
+void FrameDecoder::commit(std::size_t size) {
+    end_ += size;
+    ++reads_;
+}
+
+FrameDecoder::Result FrameDecoder::next(const char*& data, std::size_t& size) {
+    waiting_ = 0;
+    if (end_ - begin_ < kHeaderLength) {
+        return Result::INCOMPLETE;
+    }
+
+    const char* header = buffer_.data() + begin_;
+    std::size_t header_length = kHeaderLength;
+    std::size_t length = 0;
+    if (std::all_of(header, header + kHeaderLength, [](char c) { return c == kLongMarker; })) {
+        // "####" and a u32 little endian length
+        if (end_ - begin_ < kLongHeaderLength) {
+            return Result::INCOMPLETE;
+        }
+        for (std::size_t i = kLongHeaderLength; i > kHeaderLength; --i) {
+            length = (length << 8) | static_cast<unsigned char>(header[i - 1]);
+        }
+        if (length > kMaxLongBodyLength) {
+            return Result::BAD_HEADER;
+        }
+        header_length = kLongHeaderLength;
+    } else {
+        // "%4d": spaces, then at least one digit
+        std::size_t i = 0;
+        while (i < kHeaderLength && header[i] == ' ') {
+            ++i;
+        }
+        if (i == kHeaderLength) {
+            return Result::BAD_HEADER;
+        }
+        for (; i < kHeaderLength; ++i) {
+            if (header[i] < '0' || header[i] > '9') {
+                return Result::BAD_HEADER;
+            }
+            length = length * 10 + (header[i] - '0');
+        }
+    }
+
+    if (end_ - begin_ < header_length + length) {
+        waiting_ = header_length + length;
+        return Result::INCOMPLETE;
+    }
+    data = header + header_length;
+    size = length;
+    begin_ += header_length + length;
+    ++messages_;
+    return Result::MESSAGE;
+}
+
+bool snakelinkedlist::frameMessage(const std::string& body, bool allow_long, std::string& framed) {
+    if (body.size() <= FrameDecoder::kMaxBodyLength) {
+        char header[FrameDecoder::kHeaderLength + 1];
+        std::snprintf(header, sizeof(header), "%4d", static_cast<int>(body.size()));
+        framed.assign(header, FrameDecoder::kHeaderLength);
+    } else if (allow_long && body.size() <= FrameDecoder::kMaxLongBodyLength) {
+        framed.assign(FrameDecoder::kHeaderLength, FrameDecoder::kLongMarker);
+        for (std::size_t i = 0; i < FrameDecoder::kLongHeaderLength - FrameDecoder::kHeaderLength; ++i) {
+            framed.push_back(static_cast<char>((body.size() >> (8 * i)) & 0xFF));
+        }
+    } else {
+        return false;
+    }
+    framed += body;
+    return true;
+}
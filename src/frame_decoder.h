@@ -0,0 +1,78 @@
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace snakelinkedlist {
+
+    // Offered in HELLO by a side that reads long headers, and echoed back by a server that will send them
+    const std::string kFrameLongName("u32");
+
+    /*
+     Splits the byte stream from the server back into messages, framed like chat_message.hpp: a 4 character
+     decimal body length, padded with spaces, followed by the body. TCP does not keep the writes apart, so a
+     read can end part way through a header or a body, or hold several messages at once.
+     A body longer than 9999 bytes gets a long header instead, "####" followed by its length as a 32 bit
+     little endian integer. Only a peer that offered kFrameLongName in its HELLO is ever sent one, anything
+     else still sees nothing but 4 digit headers. The decoder reads both whenever they come.
+     Reads go straight into the decoder's buffer and every complete message is handed out where it lies, so
+     nothing is copied. The only bytes that ever move are the start of a message that a read cut short, and
+     only when the buffer has no room left behind it for the whole message. A long message that does not
+     fit the buffer at all makes it grow.
+     */
+    class FrameDecoder {
+    public:
+        static const std::size_t kHeaderLength = 4;
+        static const std::size_t kMaxBodyLength = 9999; // The most 4 digits can say
+        static const char kLongMarker = '#'; // Four of them instead of digits start a long header
+        static const std::size_t kLongHeaderLength = 8; // The marker and a u32 little endian length
+        static const std::size_t kMaxLongBodyLength = 64 * 1024 * 1024; // Anything longer is a broken stream
+        static const std::size_t kBufferSize = 64 * 1024; // Room for several whole world states per read
+
+        enum class Result {
+            MESSAGE, // A message was handed out
+            INCOMPLETE, // No whole message left, read some more
+            BAD_HEADER // Not a length, the stream can't be trusted from here on
+        };
+
+    private:
+        std::vector<char> buffer_;
+        std::size_t begin_ = 0; // First byte not handed out yet
+        std::size_t end_ = 0; // One past the last byte received
+        std::size_t waiting_ = 0; // Header and body length of the message at begin_, once its header is in
+        uint64_t messages_ = 0;
+        uint64_t reads_ = 0;
+        uint64_t moved_bytes_ = 0;
+
+    public:
+        FrameDecoder();
+
+        // Where the next read should put its bytes, and how many fit. Messages handed out so far are no longer valid.
+        std::pair<char*, std::size_t> prepare();
+
+        // The next read put size bytes where prepare() said
+        void commit(std::size_t size);
+
+        // Hands out the next whole message, which stays valid until the next prepare() or reset()
+        Result next(const char*& data, std::size_t& size);
+
+        // Forgets everything received, for a new connection
+        void reset() { begin_ = end_ = waiting_ = 0; }
+
+        std::size_t buffered() const { return end_ - begin_; }
+        uint64_t messages() const { return messages_; }
+        uint64_t reads() const { return reads_; }
+        uint64_t movedBytes() const { return moved_bytes_; } // Bytes of cut short messages moved to the front
+        std::size_t capacity() const { return buffer_.size(); }
+    };
+
+    // Sets framed to body behind its header. A body longer than kMaxBodyLength gets a long header if
+    // allow_long, otherwise, or if it is too long for that too, this returns false and framed is left alone.
+    bool frameMessage(const std::string& body, bool allow_long, std::string& framed);
+} // namespace snakelinkedlist
+
+#endif
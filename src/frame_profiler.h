@@ -0,0 +1,78 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#include "latency_histogram.h"
+
+namespace snakelinkedlist {
+
+    // The stages a world state goes through on its way to the screen, in order
+    enum class FrameStage {
+        RECEIVE_WAIT = 0, // From arriving on the io thread until update() picks it up
+        PARSE, // Decoding a state and applying it to the world model on the io thread, up to the published snapshot
+        STATE_UPDATE, // GameClient::update(): taking the snapshot, reconciling and stepping the prediction
+        DRAW_PREP, // Rebuilding the board mesh from a new snapshot
+        DRAW, // snakeGame::draw()
+        FRAME, // From the start of one update() to the start of the next, the whole frame
+        COUNT
+    };
+
+    const std::size_t kFrameStageCount = static_cast<std::size_t>(FrameStage::COUNT);
+
+    inline const char* frameStageName(FrameStage stage) {
+        switch (stage) {
+            case FrameStage::RECEIVE_WAIT: return "receive wait";
+            case FrameStage::PARSE: return "parse";
+            case FrameStage::STATE_UPDATE: return "state update";
+            case FrameStage::DRAW_PREP: return "draw prep";
+            case FrameStage::DRAW: return "draw";
+            case FrameStage::FRAME: return "frame";
+            default: return "?";
+        }
+    }
+
+    /*
+     One latency histogram per frame stage. The io thread records parse times while the update thread
+     records the rest, and either may read them, so everything goes through LatencyHistogram's atomics.
+     */
+    class FrameProfiler {
+    private:
+        std::array<LatencyHistogram, kFrameStageCount> stages_;
+
+    public:
+        void add(FrameStage stage, std::chrono::steady_clock::duration sample) {
+            stages_[static_cast<std::size_t>(stage)].add(sample);
+        }
+
+        const LatencyHistogram& stage(FrameStage stage) const {
+            return stages_[static_cast<std::size_t>(stage)];
+        }
+
+        // Not safe against concurrent add(), the numbers of a stage being recorded at the time may be off by a sample
+        void reset() {
+            for (LatencyHistogram& histogram : stages_) {
+                histogram.reset();
+            }
+        }
+
+        // Writes one row per stage with its sample count, mean and percentiles in milliseconds. Returns false if the file could not be written.
+        bool writeCsv(const std::string& path) const {
+            std::ofstream out(path);
+            out << "stage,count,mean_ms,p50_ms,p90_ms,p99_ms,p999_ms,max_ms\n";
+            for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+                const LatencyHistogram& histogram = stages_[i];
+                out << frameStageName(static_cast<FrameStage>(i)) << ',' << histogram.count() << ',' << histogram.meanMs()
+                    << ',' << histogram.percentileMs(0.5) << ',' << histogram.percentileMs(0.9) << ','
+                    << histogram.percentileMs(0.99) << ',' << histogram.percentileMs(0.999) << ',' << histogram.maxMs() << '\n';
+            }
+            return static_cast<bool>(out);
+        }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include "free_cell_set.h"
+
+namespace snakelinkedlist {
+
+    const uint32_t FreeCellSet::kAbsent;
+
+    FreeCellSet::FreeCellSet(int width, int height)
+        : width_(std::max(width, 0)), height_(std::max(height, 0)) {
+        fill();
+    }
+
+    bool FreeCellSet::insert(const GridCell& cell) {
+        uint32_t cell_index = index(cell);
+        if (position_[cell_index] != kAbsent) {
+            return false;
+        }
+        position_[cell_index] = static_cast<uint32_t>(cells_.size());
+        cells_.push_back(cell_index);
+        return true;
+    }
+
+    bool FreeCellSet::remove(const GridCell& cell) {
+        uint32_t cell_index = index(cell);
+        uint32_t position = position_[cell_index];
+        if (position == kAbsent) {
+            return false;
+        }
+        // The last free cell takes the removed one's place
+        uint32_t last = cells_.back();
+        cells_[position] = last;
+        position_[last] = position;
+        cells_.pop_back();
+        position_[cell_index] = kAbsent;
+        return true;
+    }
+
+    void FreeCellSet::fill() {
+        std::size_t count = static_cast<std::size_t>(width_) * height_;
+        cells_.resize(count);
+        position_.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            cells_[i] = static_cast<uint32_t>(i);
+            position_[i] = static_cast<uint32_t>(i);
+        }
+    }
+
+} // namespace snakelinkedlist
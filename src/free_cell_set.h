@@ -0,0 +1,67 @@
+#ifndef FREE_CELL_SET_H
+#define FREE_CELL_SET_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "snakebody.h"
+
+namespace snakelinkedlist {
+
+    /*
+     The free cells of a board, kept so that a uniformly random one can be drawn in O(1) however full it is.
+     The free cells sit packed in one array in no particular order, and every cell of the board remembers its
+     position in that array. Removing a cell moves the last free cell into its place (swap-remove), adding
+     one appends it, so both are O(1). Drawing a random free cell is one random index into the packed array.
+     Retrying random cells until one is free instead takes 1 / (free fraction) tries on average, a hundred
+     at 99% full, and never finishes on a full board.
+     */
+    class FreeCellSet {
+    public:
+        static const uint32_t kAbsent = 0xFFFFFFFF; // Position of a cell that is not free
+
+    private:
+        int width_;
+        int height_;
+        std::vector<uint32_t> cells_; // Row major index of every free cell, packed
+        std::vector<uint32_t> position_; // For every cell of the board, where it is in cells_ or kAbsent
+
+        uint32_t index(const GridCell& cell) const {
+            return static_cast<uint32_t>(cell.y) * static_cast<uint32_t>(width_) + static_cast<uint32_t>(cell.x);
+        }
+
+    public:
+        FreeCellSet(int width, int height); // A board of width by height cells, all free
+
+        int width() const { return width_; }
+        int height() const { return height_; }
+        std::size_t size() const { return cells_.size(); }
+        bool empty() const { return cells_.empty(); }
+
+        bool contains(const GridCell& cell) const { return position_[index(cell)] != kAbsent; }
+
+        // Both return whether the set changed. The cell must be on the board.
+        bool insert(const GridCell& cell);
+        bool remove(const GridCell& cell);
+
+        // Every cell of the board free again
+        void fill();
+
+        // Writes a uniformly random free cell to cell, returns false if there is none
+        template <typename Generator>
+        bool random(Generator& generator, GridCell& cell) const {
+            if (cells_.empty()) {
+                return false;
+            }
+            std::uniform_int_distribution<std::size_t> pick(0, cells_.size() - 1);
+            uint32_t chosen = cells_[pick(generator)];
+            cell.x = static_cast<int>(chosen % static_cast<uint32_t>(width_));
+            cell.y = static_cast<int>(chosen / static_cast<uint32_t>(width_));
+            return true;
+        }
+    };
+
+} // namespace snakelinkedlist
+#endif
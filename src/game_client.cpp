@@ -0,0 +1,463 @@
+#include "game_client.h"
+#include <algorithm>
+#include <iostream>
+#include "wire_codec.h"
+
+using namespace snakelinkedlist;
+using nlohmann::json;
+
+const std::size_t GameClient::kOutboxCapacity;
+const std::size_t GameClient::kMaxUnacked;
+
+GameClient::GameClient(uint32_t own_id, int board_width, int board_height)
+    : id_(own_id), predictor_(board_width, board_height, own_id) {
+}
+
+GameClient::~GameClient() {
+    stop();
+}
+
+void GameClient::connect(const std::string& host, const std::string& port) {
+    connect_started_at_ = std::chrono::steady_clock::now();
+    io_context_ = std::make_unique<boost::asio::io_context>();
+
+    // World states are pushed to us on the io thread as soon as they arrive
+    connection_ = std::make_unique<ServerConnection>(*io_context_, host, port,
+        [this](const char* data, std::size_t size) { this->onServerMessage(data, size); },
+        [this]() { this->onConnected(); },
+        [this]() { this->onReadDone(); });
+    connection_->start();
+    thread_ = std::make_unique<std::thread>([this](){ this->io_context_->run(); });
+}
+
+void GameClient::stop() {
+    if (thread_) {
+        // Not io_context::stop(), which would leave the close still queued on the strand. Once it has run and
+        // the aborted reads, writes and timers have come back, run() is out of work and returns by itself.
+        connection_->close();
+        thread_->join();
+        thread_.reset();
+    }
+    if (recorder_) {
+        recorder_->close();
+        std::cout << "Recorded " << recorder_->recorded() << " world states (" << recorder_->dropped()
+                  << " dropped)" << std::endl;
+        recorder_.reset();
+    }
+    if (shared_) {
+        std::cout << "Shared " << shared_->summary() << std::endl;
+        shared_.reset();
+    }
+}
+
+void GameClient::record(const std::string& path) {
+    recorder_ = std::make_unique<MatchRecorder>(path, id_);
+}
+
+void GameClient::share(const std::string& name) {
+    shared_ = std::make_unique<SharedWorldWriter>(name, id_);
+}
+
+void GameClient::publish(std::unique_ptr<WorldSnapshot> snapshot) {
+    if (shared_) {
+        shared_->publish(*snapshot);
+    }
+    snapshot_pool_.recycle(inbox_.publish(std::move(snapshot)));
+}
+
+void GameClient::replay(const std::string& path, double speed) {
+    replay_ = std::make_unique<MatchReplay>(path);
+    std::cout << "Replaying " << replay_->records() << " world states, ticks " << replay_->firstTick() << " to "
+              << replay_->lastTick() << std::endl;
+    auto now = std::chrono::steady_clock::now();
+    seekReplay(replay_->firstTick(), now);
+    setReplaySpeed(speed, now);
+}
+
+void GameClient::seekReplay(uint64_t tick, std::chrono::steady_clock::time_point now) {
+    if (!replay_) {
+        return;
+    }
+    std::unique_ptr<WorldSnapshot> snapshot = replay_->seek(tick);
+    if (snapshot) {
+        snapshot->received_at = now;
+        publish(std::move(snapshot));
+    }
+    replay_started_at_ = now;
+    replay_started_from_ = replay_->position();
+}
+
+void GameClient::setReplaySpeed(double speed, std::chrono::steady_clock::time_point now) {
+    if (!replay_) {
+        return;
+    }
+    // Keep the replay where it is, only the rate it moves at from now on changes
+    pumpReplay(now);
+    replay_started_from_ += std::chrono::duration_cast<std::chrono::nanoseconds>((now - replay_started_at_) * replay_speed_);
+    replay_started_at_ = now;
+    replay_speed_ = std::max(networking::kMinReplaySpeed, std::min(networking::kMaxReplaySpeed, speed));
+}
+
+void GameClient::pumpReplay(std::chrono::steady_clock::time_point now) {
+    auto position = replay_started_from_
+        + std::chrono::duration_cast<std::chrono::nanoseconds>((now - replay_started_at_) * replay_speed_);
+    auto parse_start = std::chrono::steady_clock::now();
+    std::unique_ptr<WorldSnapshot> snapshot = replay_->advanceTo(position);
+    if (snapshot) {
+        // Replayed states are decoded here rather than on the io thread, the parse stage times them all the same
+        profiler_.add(FrameStage::PARSE, std::chrono::steady_clock::now() - parse_start);
+        snapshot->received_at = now;
+        publish(std::move(snapshot));
+    }
+}
+
+bool GameClient::update(std::chrono::steady_clock::time_point now) {
+    if (replay_) {
+        pumpReplay(now);
+    }
+
+    // Pick up the newest snapshot the io thread has published, if there is one.
+    // This never blocks, frames in between server ticks just redraw what we have.
+    auto update_start = std::chrono::steady_clock::now();
+    std::unique_ptr<WorldSnapshot> latest = inbox_.take();
+    bool changed = static_cast<bool>(latest);
+    if (latest) {
+        profiler_.add(FrameStage::RECEIVE_WAIT, update_start - latest->received_at);
+        snapshot_pool_.recycle(interpolator_.push(std::move(latest)));
+        const WorldSnapshot* snapshot = interpolator_.newest();
+        state_received_at_ = snapshot->received_at;
+        ++states_taken_;
+        if (startup_.first_state_ms < 0 && connection_) {
+            startup_.first_state_ms = std::chrono::duration<double, std::milli>(update_start - connect_started_at_).count();
+        }
+
+        // A replay already shows where the server had our snake, there is nothing to predict
+        uint64_t reconciles = predictor_.stats().reconciles;
+        if (!replay_) {
+            predictor_.reconcile(*snapshot);
+        }
+        if (predictor_.stats().reconciles != reconciles
+            && predictor_.stats().reconciles % networking::kPredictionReportEvery == 0) {
+            std::cout << "Prediction: " << predictor_.summary() << std::endl;
+        }
+
+        // Our own snake was already found while decoding
+        if (snapshot->has_own_snake) {
+            num_food_eaten_ = snapshot->own_length;
+            if (snapshot->own_alive) {
+                current_state_ = GameState::IN_PROGRESS;
+            } else {
+                current_state_ = GameState::FINISHED;
+            }
+        }
+    }
+
+    if (predictor_.advance(now)) {
+        changed = true;
+    }
+    // Our snake slides over one predicted step, which takes a server tick
+    double tick_ms = predictor_.stats().tick_interval_ms;
+    std::chrono::steady_clock::duration step = tick_ms > 0
+        ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(tick_ms))
+        : std::chrono::steady_clock::duration(kDefaultTickInterval);
+    if (interpolator_.advance(now, predictedOwnSnake(), step)) {
+        changed = true;
+    }
+    profiler_.add(FrameStage::STATE_UPDATE, std::chrono::steady_clock::now() - update_start);
+    return changed && interpolator_.newest();
+}
+
+void GameClient::steer(char action, std::chrono::steady_clock::time_point now) {
+    if (current_state_ != GameState::IN_PROGRESS || !connection_) {
+        return;
+    }
+    if (predictor_.redundant(action)) {
+        commands_coalesced_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t seq = queueCommand(action, now);
+    if (seq) {
+        predictor_.pressed(action, seq, now);
+    }
+}
+
+void GameClient::respawn() {
+    if (current_state_ != GameState::FINISHED || !connection_) {
+        return;
+    }
+    // The server only needs to hear it once, until the next state shows whether it worked
+    if (respawn_state_ == states_taken_) {
+        commands_coalesced_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (queueCommand('R', std::chrono::steady_clock::now())) {
+        respawn_state_ = states_taken_;
+    }
+}
+
+uint64_t GameClient::queueCommand(char action, std::chrono::steady_clock::time_point now) {
+    OutboundCommand command;
+    command.action = action;
+    command.seq = next_seq_ + 1;
+    command.pressed_at = now;
+    command.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (!outbox_.push(command)) {
+        commands_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    ++next_seq_;
+
+    // Only the first key press since the last sample is timed, later ones would just
+    // measure how long the user waited between presses
+    if (!input_pending_) {
+        input_pending_ = true;
+        input_time_ = now;
+    }
+    if (!drain_posted_.exchange(true)) {
+        boost::asio::post(*io_context_, [this]() { this->drainCommands(); });
+    }
+    return command.seq;
+}
+
+void GameClient::setInterest(const CellRect& rect) {
+    if (!connection_ || (has_interest_requested_ && interest_requested_ == rect)) {
+        return;
+    }
+    interest_requested_ = rect;
+    has_interest_requested_ = true;
+    // The camera only moves past its margin now and then, one small allocation each time is fine
+    interest_inbox_.publish(std::make_unique<CellRect>(rect));
+    boost::asio::post(*io_context_, [this]() { this->sendInterest(); });
+}
+
+StartupTimes GameClient::startupTimes() const {
+    StartupTimes times = startup_;
+    int64_t connected_ns = first_connected_ns_.load();
+    times.connected_ms = connected_ns < 0 ? -1 : connected_ns / 1e6;
+    return times;
+}
+
+const snakejson::snake* GameClient::predictedOwnSnake() const {
+    return predictor_.active() && !replay_ ? &predictor_.predicted() : nullptr;
+}
+
+void GameClient::framePresented(std::chrono::steady_clock::time_point now) {
+    if (startup_.first_state_ms >= 0 && startup_.first_frame_ms < 0) {
+        startup_.first_frame_ms = std::chrono::duration<double, std::milli>(now - connect_started_at_).count();
+        StartupTimes times = startupTimes();
+        std::cout << "Time to first frame: " << times.first_frame_ms << " ms (connected after " << times.connected_ms
+                  << " ms, first world state after " << times.first_state_ms << " ms)" << std::endl;
+    }
+
+    // The frame just presented only reflects the key press if its state arrived after the press
+    if (!input_pending_ || state_received_at_ < input_time_) {
+        return;
+    }
+    input_pending_ = false;
+    input_latency_.add(now - input_time_);
+
+    if (input_latency_.count() % networking::kLatencyReportEvery == 0) {
+        std::cout << "Input-to-pixel latency: " << input_latency_.summary()
+                  << " (" << statesDropped() << " stale states dropped)" << std::endl;
+    }
+}
+
+void GameClient::drainCommands() {
+    // Cleared before anything is taken, so a command queued from here on posts another drain
+    drain_posted_.store(false);
+    OutboundCommand command;
+    if (!outbox_.pop(command)) {
+        return;
+    }
+    OutboundCommand next;
+    while (outbox_.pop(next)) {
+        if (next.action == command.action) {
+            // The same key again with nothing in between does nothing the first press did not. Only the later
+            // one is sent, its sequence number acknowledges both, and the latency is timed from the first.
+            next.pressed_at = command.pressed_at;
+            next.time_us = command.time_us;
+            command = next;
+            commands_coalesced_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        sendCommand(command);
+        command = next;
+    }
+    sendCommand(command);
+}
+
+void GameClient::sendCommand(const OutboundCommand& command) {
+    json json_to_send;
+    json_to_send["id"] = id_;
+    json_to_send["action"] = std::string(1, command.action);
+    json_to_send["seq"] = command.seq;
+    json_to_send["time_us"] = command.time_us;
+    connection_->send(json_to_send);
+    commands_sent_.fetch_add(1, std::memory_order_relaxed);
+
+    if (unacked_.size() == kMaxUnacked) {
+        unacked_.pop_front();
+    }
+    unacked_.push_back(SentCommand{command.seq, command.pressed_at});
+}
+
+void GameClient::sendInterest() {
+    std::unique_ptr<CellRect> latest = interest_inbox_.take();
+    if (latest) {
+        interest_ = *latest;
+        has_interest_ = true;
+    } else if (!has_interest_) {
+        return;
+    }
+    json view;
+    view["id"] = id_;
+    view["action"] = std::string("VIEW");
+    view["rect"] = {interest_.left, interest_.top, interest_.right, interest_.bottom};
+    connection_->send(view);
+}
+
+void GameClient::onConnected() {
+    int64_t not_yet = -1;
+    first_connected_ns_.compare_exchange_strong(not_yet, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - connect_started_at_).count());
+
+    // Acknowledgements for what was sent over an earlier connection are not coming any more
+    unacked_.clear();
+
+    // Offer what we can read beyond JSON in 4 digit frames, a server that knows none of it ignores HELLO
+    json hello;
+    hello["id"] = id_;
+    hello["action"] = std::string("HELLO");
+    hello["frame"] = {kFrameLongName};
+    if (networking::kOfferBinaryWire) {
+        hello["wire"] = {kWireBinaryName, kWireJsonName};
+    }
+    connection_->send(hello);
+    // A new connection is a new session on the server, it has to be told again what we are looking at
+    sendInterest();
+}
+
+void GameClient::onServerMessage(const char* data, std::size_t size) {
+    auto received_at = std::chrono::steady_clock::now();
+    try {
+        bool changed = false;
+        if (isWireMessage(data, size)) {
+            if (recorder_) {
+                bool keyframe = wireMessageType(data, size) == WireMessageType::KEYFRAME;
+                recorder_->append(wireMessageTick(data, size), kRecordBinary | (keyframe ? kRecordKeyframe : 0),
+                                  received_at, data, size);
+            }
+            changed = model_.applyWire(data, size);
+        } else if (json_reader_.read(data, size, states_received_ + 1) != JsonStateReader::Kind::OTHER) {
+            if (recorder_) {
+                bool keyframe = json_reader_.kind() == JsonStateReader::Kind::KEYFRAME;
+                recorder_->append(json_reader_.tick(), keyframe ? kRecordKeyframe : 0, received_at, data, size);
+            }
+            changed = model_.apply(json_reader_);
+        } else {
+            // Not a world state. Acks and the like are small, a DOM is fine for them.
+            json message = json::parse(data, data + size);
+            if (handleControlMessage(message)) {
+                return;
+            }
+            changed = model_.apply(message, states_received_ + 1);
+        }
+        ++states_received_;
+
+        // Deltas received while we are out of sync change nothing, so there is nothing to publish.
+        // Whatever is published waits until the read's last message, a newer state may be right behind it.
+        if (changed) {
+            if (snapshot_pending_) {
+                states_superseded_.fetch_add(1, std::memory_order_relaxed);
+            }
+            snapshot_pending_ = true;
+            pending_received_at_ = received_at;
+            pending_ack_ = last_ack_;
+            pending_ack_at_ = last_ack_at_;
+        }
+    } catch (std::exception& e) {
+        // A state we cannot decode is dropped, the update thread keeps showing the previous one
+        std::cerr << e.what() << std::endl;
+    }
+
+    if (states_received_ > 0 && states_received_ % networking::kModelReportEvery == 0) {
+        logModelStats();
+    }
+}
+
+void GameClient::onReadDone() {
+    if (!snapshot_pending_) {
+        return;
+    }
+    snapshot_pending_ = false;
+    std::unique_ptr<WorldSnapshot> snapshot = snapshot_pool_.acquire();
+    model_.snapshotInto(*snapshot, id_);
+    snapshot->received_at = pending_received_at_;
+    snapshot->acked_input = pending_ack_;
+    snapshot->acked_at = pending_ack_at_;
+    publish(std::move(snapshot));
+    // From when the state's own message was picked up, the ones behind it in the same read are not its cost but
+    // they did hold it up
+    profiler_.add(FrameStage::PARSE, std::chrono::steady_clock::now() - pending_received_at_);
+}
+
+double GameClient::messagesPerRead() const {
+    uint64_t reads = connection_ ? connection_->reads() : 0;
+    return reads == 0 ? 0 : double(connection_->messagesReceived()) / reads;
+}
+
+bool GameClient::handleControlMessage(const json& message) {
+    if (message.find("Error") != message.end()) {
+        std::cout << "Reconnecting..." << std::endl;
+        connection_->reconnect();
+        return true;
+    }
+
+    // The server has applied our inputs up to this one, every state from here on reflects them.
+    // It comes in order with the states, so it always precedes the first state that includes the input.
+    auto ack = message.find("ack");
+    if (ack != message.end()) {
+        last_ack_ = std::max(last_ack_, ack->get<uint64_t>());
+        last_ack_at_ = std::chrono::steady_clock::now();
+
+        // Acknowledgements are cumulative, every command up to this one has been applied
+        uint64_t reports = ack_latency_.count() / networking::kLatencyReportEvery;
+        while (!unacked_.empty() && unacked_.front().seq <= last_ack_) {
+            ack_latency_.add(last_ack_at_ - unacked_.front().pressed_at);
+            unacked_.pop_front();
+        }
+        if (ack_latency_.count() / networking::kLatencyReportEvery != reports) {
+            std::cout << "Input-to-ack latency: " << ack_latency_.summary() << " (" << commandsSent() << " sent, "
+                      << commandsCoalesced() << " coalesced, " << commandsDropped() << " dropped)" << std::endl;
+        }
+        return true;
+    }
+
+    // The server's answer to our HELLO, everything after it comes in the format it picked
+    bool answered = false;
+    auto wire = message.find("wire");
+    if (wire != message.end()) {
+        std::cout << "Server is sending world states as " << wire->get<std::string>() << std::endl;
+        answered = true;
+    }
+    auto frame = message.find("frame");
+    if (frame != message.end()) {
+        if (*frame == kFrameLongName) {
+            connection_->allowLongFrames();
+        }
+        answered = true;
+    }
+    return answered;
+}
+
+void GameClient::logModelStats() const {
+    const WorldModel::Stats& stats = model_.stats();
+    auto mean_us = [](std::chrono::steady_clock::duration total, uint64_t count) {
+        return count ? std::chrono::duration<double, std::micro>(total).count() / count : 0.0;
+    };
+    std::cout << "World model: " << stats.keyframes << " keyframes (mean " << mean_us(stats.keyframe_time, stats.keyframes)
+              << "us), " << stats.deltas << " deltas (mean " << mean_us(stats.delta_time, stats.deltas + stats.ignored_deltas)
+              << "us), " << stats.resyncs << " resyncs, " << stats.ignored_deltas << " deltas ignored, "
+              << stats.snakes_gone << " snakes out of view" << std::endl;
+}
@@ -0,0 +1,319 @@
+#ifndef GAME_CLIENT_H
+#define GAME_CLIENT_H
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <boost/asio.hpp>
+#include "camera.h"
+#include "frame_profiler.h"
+#include "json.hpp"
+#include "json_state_reader.h"
+#include "latency_histogram.h"
+#include "latest_slot.h"
+#include "latency_stats.h"
+#include "match_recording.h"
+#include "recycle_pool.h"
+#include "server_connection.h"
+#include "shared_world.h"
+#include "snake_predictor.h"
+#include "snapshot_interpolator.h"
+#include "spsc_queue.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    // Enum to represent the current state of the game
+    enum class GameState {
+        IN_PROGRESS = 0,
+        FINISHED
+    };
+
+    // How long startup took, in milliseconds from connect(). Negative until it has happened.
+    struct StartupTimes {
+        double connected_ms = -1; // The first connection to the server was made
+        double first_state_ms = -1; // update() picked up the first world state
+        double first_frame_ms = -1; // The first frame showing a world state was presented
+    };
+
+    /*
+     Everything the client does apart from drawing: the connection, decoding world states on the io thread,
+     the world model, predicting our own snake and tracking whether we are still alive.
+     The windowed app and the headless runner drive the same GameClient, so the whole client loop can run
+     without a GL context, under a profiler or in automated tests, at whatever rate update() is called.
+     All public methods are for the thread that calls update(), the io thread only runs the private handlers.
+     */
+    class GameClient {
+    private:
+        // A key press on its way to the server. The update thread queues it and the io thread sends it.
+        struct OutboundCommand {
+            char action; // W, A, S, D or R
+            uint64_t seq; // Shared by every command, so the server's acknowledgements cover all of them in order
+            std::chrono::steady_clock::time_point pressed_at;
+            int64_t time_us; // Wall clock time of the press in microseconds since the epoch, sent with the command
+        };
+
+        // A command sent and not acknowledged yet
+        struct SentCommand {
+            uint64_t seq;
+            std::chrono::steady_clock::time_point pressed_at;
+        };
+
+        static const std::size_t kOutboxCapacity = 64; // Key presses beyond this, queued faster than they are sent, are dropped
+        static const std::size_t kMaxUnacked = 256; // Servers that never acknowledge stop being tracked beyond this
+
+        uint32_t id_; // Our snake, set before the io thread starts decoding
+
+        // The last few world states, the newest of which is the current one. They are owned by the update thread
+        // and never modified, update() pushes in the newest one from inbox_ when the io thread has published it
+        // and the board is drawn somewhere between them
+        SnapshotInterpolator interpolator_;
+
+        // Moves our own snake between server states and steers it the moment a key is pressed,
+        // corrected against every state the server sends
+        SnakePredictor predictor_;
+
+        GameState current_state_ = GameState::IN_PROGRESS; // Start us off as alive
+        int num_food_eaten_ = 0;
+
+        std::unique_ptr<boost::asio::io_context> io_context_;
+        std::unique_ptr<ServerConnection> connection_;
+        std::unique_ptr<std::thread> thread_;
+
+        // Decoded world states travel from the io thread to the update thread through here, newest wins
+        LatestSlot<WorldSnapshot> inbox_;
+        // and go back through here once they are no longer shown, so a steady stream of states
+        // is decoded into the same few snapshots without allocating
+        RecyclePool<WorldSnapshot> snapshot_pool_;
+        uint64_t states_received_ = 0; // Only touched on the io thread, stands in for a missing tick number
+        uint64_t last_ack_ = 0; // Only touched on the io thread, newest input sequence number the server acknowledged
+        std::chrono::steady_clock::time_point last_ack_at_; // Only touched on the io thread, when last_ack_ arrived
+
+        // Io thread only: the newest state of the read being handed out, published once the read's messages are
+        // done so the states it superseded are never copied into a snapshot. The ack is the one it was sent with.
+        bool snapshot_pending_ = false;
+        std::chrono::steady_clock::time_point pending_received_at_;
+        uint64_t pending_ack_ = 0;
+        std::chrono::steady_clock::time_point pending_ack_at_;
+        std::atomic<uint64_t> states_superseded_{0}; // Applied to model_ but superseded in the same read
+        WorldModel model_; // Only touched on the io thread, keeps every snake's body between ticks
+        JsonStateReader json_reader_; // Only touched on the io thread, reads JSON world states without a DOM
+        uint64_t states_taken_ = 0; // Snapshots update() picked up
+
+        // Input-to-pixel latency: the time from a key press until the first frame presented
+        // from a world state that arrived after it
+        bool input_pending_ = false;
+        std::chrono::steady_clock::time_point input_time_;
+        std::chrono::steady_clock::time_point state_received_at_; // Arrival time of the state being shown
+        LatencyStats input_latency_;
+
+        // Time to first frame. The io thread records when the first connection is made, the rest is update thread only.
+        std::chrono::steady_clock::time_point connect_started_at_;
+        std::atomic<int64_t> first_connected_ns_{-1}; // Nanoseconds after connect_started_at_
+        StartupTimes startup_;
+
+        // Per-stage timing histograms. Parse times are recorded on the io thread, the rest on the update thread.
+        FrameProfiler profiler_;
+
+        // Every world state received is appended here when recording, from the io thread
+        std::unique_ptr<MatchRecorder> recorder_;
+
+        // Every snapshot handed to the update thread is also written here for other local processes, from the
+        // io thread, or from the update thread when replaying
+        std::unique_ptr<SharedWorldWriter> shared_;
+
+        // Replaying a recording instead of connecting: the recording's clock runs at replay_speed_ times
+        // real time from replay_started_from_, which was the position when replay_started_at_ was now
+        std::unique_ptr<MatchReplay> replay_;
+        double replay_speed_ = 1;
+        std::chrono::steady_clock::time_point replay_started_at_;
+        std::chrono::nanoseconds replay_started_from_{0};
+
+        // Commands travel from the update thread to the io thread through outbox_ without locks. A drain is only
+        // posted to the io thread when none is pending, so a burst of key presses costs one wake-up.
+        SpscQueue<OutboundCommand, kOutboxCapacity> outbox_;
+        std::atomic<bool> drain_posted_{false};
+        uint64_t next_seq_ = 0; // Sequence number of the last command queued, update thread only
+        uint64_t respawn_state_ = UINT64_MAX; // states_taken_ when R was last queued, update thread only
+        std::deque<SentCommand> unacked_; // Only touched on the io thread, oldest first
+        LatencyHistogram ack_latency_; // Key press to the server's acknowledgement, recorded on the io thread
+        std::atomic<uint64_t> commands_sent_{0};
+        std::atomic<uint64_t> commands_coalesced_{0}; // Redundant key presses that were never sent
+        std::atomic<uint64_t> commands_dropped_{0}; // Key presses that found outbox_ full
+
+        // The part of the board we want to hear about. The update thread publishes a new one and posts a send,
+        // the io thread keeps the last one in interest_ to send again whenever it reconnects.
+        LatestSlot<CellRect> interest_inbox_;
+        CellRect interest_requested_; // Update thread only, the last rect passed to setInterest()
+        bool has_interest_requested_ = false;
+        CellRect interest_; // Only touched on the io thread
+        bool has_interest_ = false;
+
+        // Queues a command for the io thread, returns its sequence number or 0 if it was dropped. Update thread only.
+        uint64_t queueCommand(char action, std::chrono::steady_clock::time_point now);
+
+        // Runs on the io_context thread: sends everything queued, merging a key pressed again with nothing in between
+        void drainCommands();
+        void sendCommand(const OutboundCommand& command);
+
+        // Runs on the io_context thread: takes the newest interest rect, if there is one, and sends it
+        void sendInterest();
+
+        // Runs on the io_context thread every time a connection is made: offers the binary wire format to the server
+        void onConnected();
+
+        // Runs on the io_context thread for every message: applies world states to model_
+        void onServerMessage(const char* data, std::size_t size);
+
+        // Runs on the io_context thread after the messages of each read: hands a WorldSnapshot of the newest
+        // state to the update thread through inbox_
+        void onReadDone();
+
+        // Handles the JSON messages that are not world states. Returns false if message is a world state.
+        bool handleControlMessage(const nlohmann::json& message);
+
+        // Prints how many keyframes and deltas model_ applied and what they cost, io thread only
+        void logModelStats() const;
+
+        // Publishes the newest replayed state that is due by now, the replay's stand-in for the io thread
+        void pumpReplay(std::chrono::steady_clock::time_point now);
+
+        // Hands a snapshot to the update thread through inbox_, and to other processes if sharing
+        void publish(std::unique_ptr<WorldSnapshot> snapshot);
+
+    public:
+        // board_width and board_height are in cells, they bound the predicted snake
+        GameClient(uint32_t own_id, int board_width, int board_height);
+        ~GameClient(); // Stops the io thread
+
+        GameClient(const GameClient&) = delete;
+        GameClient& operator=(const GameClient&) = delete;
+
+        // Starts connecting on a new io thread and returns straight away. The server is resolved and connected
+        // asynchronously, and reconnected with a backoff whenever the connection fails or drops.
+        void connect(const std::string& host, const std::string& port);
+
+        // Closes the connection and joins the io thread, then closes the recording if there is one
+        void stop();
+
+        // Records every world state received to a file, see match_recording.h. Call before connect().
+        // Throws RecordingError if the file cannot be created.
+        void record(const std::string& path);
+
+        // Publishes every world state to the processes on this machine that attach to the shared memory called
+        // name, see shared_world.h. Call before connect() or replay(). Throws SharedWorldError.
+        void share(const std::string& name);
+
+        // Plays a recording instead of connecting, at speed times real time. Steering and respawning do nothing
+        // and our snake is not predicted. Throws RecordingError if the file cannot be opened.
+        void replay(const std::string& path, double speed);
+
+        // Jumps the replay to a tick and carries on playing from there
+        void seekReplay(uint64_t tick, std::chrono::steady_clock::time_point now);
+
+        // Changes the replay speed, clamped to kMinReplaySpeed..kMaxReplaySpeed
+        void setReplaySpeed(double speed, std::chrono::steady_clock::time_point now);
+
+        /*
+         Called once per frame
+         1. Take the newest world snapshot the io thread has published into the jitter buffer. If there is none
+            we keep the ones we have.
+         2. Rewind our predicted snake to it and read our own snake's status
+         3. Step the predicted snake to wherever the server should have it by now
+         4. Move the interpolated board along to now, less the interpolation delay
+         Returns whether anything that is drawn changed.
+         */
+        bool update(std::chrono::steady_clock::time_point now);
+
+        // Queues a W, A, S or D turn with a sequence number for the predictor. Ignored once the game is over,
+        // and when it repeats the last turn at the same predicted tick, which the server would not notice.
+        void steer(char action, std::chrono::steady_clock::time_point now);
+
+        // Asks the server for a new snake. Only once the game is over, and only once per world state shown.
+        void respawn();
+
+        /*
+         Subscribes to the snakes and food inside rect, in cells, instead of the whole board. The server then
+         sends keyframes of only what is inside, and deltas in which snakes come into view with their whole
+         body and leave it with a "gone" entry, so bytes and parse time per tick follow the size of the view.
+         Sent as {"id", "action": "VIEW", "rect": [left, top, right, bottom]}. Servers that do not know
+         VIEW ignore it and keep sending everything. Does nothing if rect is the one already asked for.
+         */
+        void setInterest(const CellRect& rect);
+
+        // The last rect passed to setInterest(), and whether there was one
+        const CellRect* interest() const { return has_interest_requested_ ? &interest_requested_ : nullptr; }
+
+        // Call after each frame is presented, records how long the last key press took to show up
+        // and, once, how long it took from connect() to the first frame with a world state
+        void framePresented(std::chrono::steady_clock::time_point now);
+
+        // The newest world state, and the one update() took before it if it is still around
+        const WorldSnapshot* snapshot() const { return interpolator_.newest(); }
+        const WorldSnapshot* previousSnapshot() const { return interpolator_.previous(); }
+
+        // The board as it should be drawn this frame, between the buffered states, with our predicted snake
+        // in place of the server's copy. Only while interpolating(), valid until the next update().
+        // Built once per update(), however many times it is asked for.
+        const InterpolatedFrame& interpolated() { return interpolator_.interpolate(); }
+        bool interpolating() const { return interpolator_.enabled(); }
+
+        // How far behind the newest state the board is drawn, 0 draws the newest state as it is
+        void setInterpolationDelay(std::chrono::steady_clock::duration delay) { interpolator_.setDelay(delay); }
+        std::chrono::steady_clock::duration interpolationDelay() const { return interpolator_.delay(); }
+        const SnapshotInterpolator& jitterBuffer() const { return interpolator_; }
+
+        // Our predicted snake while prediction has one, for drawing in place of the server's copy
+        const snakejson::snake* predictedOwnSnake() const;
+
+        GameState state() const { return current_state_; }
+        int score() const { return num_food_eaten_; }
+        const SnakePredictor& predictor() const { return predictor_; }
+        const LatencyStats& inputLatency() const { return input_latency_; }
+        const LatencyHistogram& ackLatency() const { return ack_latency_; }
+        StartupTimes startupTimes() const;
+        ConnectionState connectionState() const { return connection_ ? connection_->state() : ConnectionState::CLOSED; }
+        uint32_t connectionFailures() const { return connection_ ? connection_->failures() : 0; }
+        uint64_t commandsSent() const { return commands_sent_.load(std::memory_order_relaxed); }
+        uint64_t commandsCoalesced() const { return commands_coalesced_.load(std::memory_order_relaxed); }
+        uint64_t commandsDropped() const { return commands_dropped_.load(std::memory_order_relaxed); }
+        FrameProfiler& profiler() { return profiler_; } // The app records its draw stages here as well
+        uint64_t statesTaken() const { return states_taken_; }
+        uint64_t statesSkipped() const { return inbox_.overwritten(); } // Published but replaced before update() took them
+        uint64_t statesSuperseded() const { return states_superseded_.load(std::memory_order_relaxed); }
+        // Every state that arrived but was never shown, because a newer one came before it could be
+        uint64_t statesDropped() const { return statesSkipped() + statesSuperseded(); }
+        double messagesPerRead() const; // How many messages a socket read completed on average, 0 before the first
+        const MatchReplay* replaying() const { return replay_.get(); }
+        double replaySpeed() const { return replay_speed_; }
+    };
+} // namespace snakelinkedlist
+
+namespace networking {
+    // Where we are connecting to
+    const std::string kIPADDRESS("127.0.0.1");
+    const std::string kPORT("49145");
+
+    // Ask the server for the compact binary world state format, it falls back to JSON if the server does not answer
+    const bool kOfferBinaryWire = true;
+
+    // Print the input-to-pixel and input-to-acknowledgement latency summaries after this many samples
+    const int kLatencyReportEvery = 20;
+
+    // Print the world model keyframe/delta summary after this many received states
+    const int kModelReportEvery = 300;
+
+    // Print how well our snake was predicted after this many server states of it
+    const int kPredictionReportEvery = 100;
+
+    // Replays run between real time and this many times faster
+    const double kMinReplaySpeed = 1;
+    const double kMaxReplaySpeed = 100;
+}
+#endif
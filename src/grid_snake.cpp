@@ -0,0 +1,143 @@
+#include "grid_snake.h"
+#include <utility>
+
+using namespace snakelinkedlist;
+
+GridSnake::GridSnake(OccupancyGrid& grid, OccupancyGrid::Owner id, GridCell start) : grid_(&grid), id_(id) {
+    current_direction_ = RIGHT; // Snake starts out moving right
+
+    body_.pushHead(start);
+
+    // Spawning onto a wall or another snake is as fatal as moving onto one
+    dead_ = !grid_->occupy(start, id_);
+}
+
+GridSnake::GridSnake(GridSnake&& other)
+    : current_direction_(other.current_direction_), grid_(other.grid_), id_(other.id_), dead_(other.dead_),
+      body_(std::move(other.body_)) {
+    other.grid_ = nullptr;
+}
+
+GridSnake& GridSnake::operator=(GridSnake&& other) {
+    if (this != &other) {
+        if (grid_) {
+            for (const GridCell& cell : body_) {
+                grid_->release(cell, id_);
+            }
+        }
+        current_direction_ = other.current_direction_;
+        grid_ = other.grid_;
+        id_ = other.id_;
+        dead_ = other.dead_;
+        body_ = std::move(other.body_);
+        other.grid_ = nullptr;
+    }
+    return *this;
+}
+
+GridSnake::~GridSnake() {
+    if (grid_) {
+        for (const GridCell& cell : body_) {
+            grid_->release(cell, id_);
+        }
+    }
+}
+
+const GridCell& GridSnake::getHeadCell() const {
+    return body_.head();
+}
+
+std::size_t GridSnake::getLength() const {
+    return body_.size();
+}
+
+OccupancyGrid::Owner GridSnake::getId() const {
+    return id_;
+}
+
+void GridSnake::update() {
+    if (dead_) {
+        return;
+    }
+
+    // Move the head one body square in the direction the snake is moving
+    GridCell head = body_.head();
+    switch (current_direction_) {
+        case UP:
+            --head.y;
+            break;
+        case DOWN:
+            ++head.y;
+            break;
+        case LEFT:
+            --head.x;
+            break;
+        case RIGHT:
+            ++head.x;
+            break;
+    }
+
+    // The tail retires first, so following right behind your own tail is safe
+    grid_->release(body_.tail(), id_);
+    body_.popTail();
+
+    // Every other segment keeps its cell, so moving is just a new head and one less tail.
+    // Whatever is in the cell the head moves into, a wall or any snake's body, kills the snake.
+    // Two heads moving into the same free cell on the same tick are settled by update order.
+    body_.pushHead(head);
+    dead_ = !grid_->occupy(head, id_);
+}
+
+bool GridSnake::isDead() const {
+    return dead_;
+}
+
+void GridSnake::grow() {
+    // The current position of the new tail is one unit in the opposite direction of the snakes current movement
+    GridCell tail = body_.tail();
+    switch (current_direction_) {
+        case UP:
+            ++tail.y;
+            break;
+        case DOWN:
+            --tail.y;
+            break;
+        case LEFT:
+            ++tail.x;
+            break;
+        case RIGHT:
+            --tail.x;
+            break;
+    }
+
+    // Attach a new tail to the snake. If the cell behind it is taken the tail overlaps whoever is there
+    // until it moves on, it just doesn't claim the cell.
+    body_.pushTail(tail);
+    grid_->occupy(tail, id_);
+}
+
+void GridSnake::rewind(const std::vector<GridCell>& cells, SnakeDirection direction) {
+    for (const GridCell& cell : body_) {
+        grid_->release(cell, id_);
+    }
+    body_.clear();
+
+    for (const GridCell& cell : cells) {
+        body_.pushTail(cell);
+        grid_->occupy(cell, id_);
+    }
+    current_direction_ = direction;
+    dead_ = cells.empty();
+}
+
+int GridSnake::getFoodEaten() const {
+    return static_cast<int>(body_.size()) - 1;
+}
+
+SnakeDirection GridSnake::getDirection() const {
+    return current_direction_;
+}
+
+void GridSnake::setDirection(SnakeDirection newDirection) {
+    current_direction_ = newDirection;
+}
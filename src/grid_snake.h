@@ -0,0 +1,54 @@
+#ifndef GRID_SNAKE_H
+#define GRID_SNAKE_H
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "occupancy_grid.h"
+#include "snakebody.h"
+
+namespace snakelinkedlist {
+
+    // Enum that represents all possible directions that the snake can be moving
+    typedef enum {
+        UP = 0,
+        DOWN,
+        RIGHT,
+        LEFT
+    } SnakeDirection;
+
+    /*
+     A snake as the rules see it: cells on a shared OccupancyGrid, a direction, and whether it is dead.
+     Nothing here knows how the snake is drawn, so the prediction and anything else that only steps snakes
+     can use it without openFrameworks. Snake adds the colors and sizes it is drawn with on top.
+     */
+    class GridSnake {
+    private:
+        SnakeDirection current_direction_; // The current direction of the snake
+        OccupancyGrid* grid_; // The board shared with every other snake, null once the snake has been moved from
+        OccupancyGrid::Owner id_; // What this snake writes into the cells it occupies
+        bool dead_; // The head ran into a wall or a snake, set by update()
+        SnakeBodyRing body_; // The cells of the body, head first. Moving is a head push and a tail pop.
+
+    public:
+        GridSnake(OccupancyGrid& grid, OccupancyGrid::Owner id, GridCell start = GridCell{0, 2}); // Places a length 1 snake on the shared board
+        GridSnake(GridSnake&& other);
+        GridSnake& operator=(GridSnake&& other);
+        GridSnake(const GridSnake&) = delete; // Two copies would fight over the same cells
+        GridSnake& operator=(const GridSnake&) = delete;
+        ~GridSnake(); // Releases the snake's cells
+        const SnakeBodyRing& body() const { return body_; } // The cells of the body, head first
+        const GridCell& getHeadCell() const; // The cell the head of the snake is in
+        std::size_t getLength() const; // Number of body squares, head included
+        OccupancyGrid::Owner getId() const; // The id the snake occupies its cells with
+        bool isDead() const; // Determines if the current state of the snake is dead
+        void update(); // updates the snake one body square in the current direction, a dead snake stays put
+        void grow(); // Adds a tail one square behind the current one, against the direction of travel
+        void rewind(const std::vector<GridCell>& cells, SnakeDirection direction); // Replaces the whole body, head first, with a known good one
+        int getFoodEaten() const; // Gets the number of food items the snake has eaten
+        SnakeDirection getDirection() const; // Gets the Snake's current direction
+        void setDirection(SnakeDirection new_direction); // Sets the Snake's direction
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,408 @@
+#include "json_state_reader.h"
+#include "json.hpp"
+
+using namespace snakelinkedlist;
+
+namespace snakelinkedlist {
+
+    /*
+     The SAX handler behind JsonStateReader::read(). nlohmann calls one of these for every token, and it keeps
+     track of where in the message the token is to know which field it belongs to.
+     Keys the client does not know about are skipped along with whatever value they have.
+     */
+    class JsonStateSax {
+    private:
+        enum class Where { START, ROOT, FOOD, FOOD_CELL, SNAKES, SNAKE, LOCATION, LOCATION_CELL, COLOR, HEAD, DONE };
+
+        // The last key read in the root object or in a snake, which field the value after it goes to
+        enum class Key { NONE, TICK, TYPE, FOOD, SNAKES, ID, LENGTH, ALIVE, DIRECTION, COLOR, LOCATION, HEAD, TAIL, GROWN, DIED, GONE, UNKNOWN };
+
+        JsonStateReader& reader_;
+        Where where_ = Where::START;
+        Key key_ = Key::NONE;
+        int skipping_ = 0; // How deep we are inside the value of an unknown key
+        JsonStateReader::SnakeFields* snake_ = nullptr; // The snake being read
+        std::pair<int, int>* cell_ = nullptr; // The food or body cell being read
+        std::size_t index_ = 0; // Number of values read into the current cell, color or head
+
+        static bool fail(const char* what) {
+            throw JsonStateError(std::string("Malformed world state: ") + what);
+        }
+
+        static Key rootKey(const std::string& key) {
+            if (key == "tick") return Key::TICK;
+            if (key == "type") return Key::TYPE;
+            if (key == "food") return Key::FOOD;
+            if (key == "snakes") return Key::SNAKES;
+            return Key::UNKNOWN;
+        }
+
+        static Key snakeKey(const std::string& key) {
+            if (key == "id") return Key::ID;
+            if (key == "length") return Key::LENGTH;
+            if (key == "alive") return Key::ALIVE;
+            if (key == "direction") return Key::DIRECTION;
+            if (key == "color") return Key::COLOR;
+            if (key == "location") return Key::LOCATION;
+            if (key == "head") return Key::HEAD;
+            if (key == "tail") return Key::TAIL;
+            if (key == "grown") return Key::GROWN;
+            if (key == "died") return Key::DIED;
+            if (key == "gone") return Key::GONE;
+            return Key::UNKNOWN;
+        }
+
+        // Every number ends up as an int but the tick, whatever type the parser read it as
+        template <typename T>
+        bool number(T value) {
+            if (skipping_ > 0) {
+                return true;
+            }
+            switch (where_) {
+                case Where::FOOD_CELL:
+                case Where::LOCATION_CELL:
+                    if (index_ >= 2) return fail("a cell has more than two coordinates");
+                    (index_++ == 0 ? cell_->first : cell_->second) = static_cast<int>(value);
+                    return true;
+                case Where::HEAD:
+                    if (index_ >= 2) return fail("a head has more than two coordinates");
+                    (index_++ == 0 ? snake_->head.first : snake_->head.second) = static_cast<int>(value);
+                    return true;
+                case Where::COLOR:
+                    if (index_ >= 3) return fail("a color has more than three components");
+                    snake_->color[index_++] = static_cast<int>(value);
+                    return true;
+                case Where::ROOT:
+                    if (key_ == Key::TICK) {
+                        if (value < 0) return fail("negative tick");
+                        reader_.has_tick_ = true;
+                        reader_.tick_ = static_cast<uint64_t>(value);
+                        return true;
+                    }
+                    if (key_ == Key::TYPE) {
+                        reader_.is_delta_ = false; // Anything but "delta" is a keyframe
+                        return true;
+                    }
+                    return key_ == Key::UNKNOWN || fail("unexpected number");
+                case Where::SNAKE:
+                    switch (key_) {
+                        case Key::ID: snake_->has_id = true; snake_->id = static_cast<int>(value); return true;
+                        case Key::LENGTH: snake_->has_length = true; snake_->length = static_cast<int>(value); return true;
+                        case Key::TAIL: snake_->tail = static_cast<int>(value); return true;
+                        case Key::UNKNOWN: return true;
+                        default: return fail("unexpected number in a snake");
+                    }
+                default:
+                    return fail("unexpected number");
+            }
+        }
+
+        // A value that is not a number, only valid where it is skipped or was asked for by name
+        bool other(const char* what) {
+            if (skipping_ > 0 || ((where_ == Where::ROOT || where_ == Where::SNAKE) && key_ == Key::UNKNOWN)) {
+                return true;
+            }
+            if (where_ == Where::ROOT && key_ == Key::TYPE) {
+                reader_.is_delta_ = false;
+                return true;
+            }
+            return fail(what);
+        }
+
+    public:
+        explicit JsonStateSax(JsonStateReader& reader) : reader_(reader) {}
+
+        bool null() {
+            return other("unexpected null");
+        }
+
+        bool boolean(bool value) {
+            if (skipping_ == 0 && where_ == Where::SNAKE) {
+                switch (key_) {
+                    case Key::ALIVE: snake_->has_alive = true; snake_->alive = value; return true;
+                    case Key::GROWN: snake_->grown = value; return true;
+                    case Key::DIED: snake_->died = value; return true;
+                    case Key::GONE: snake_->gone = value; return true;
+                    default: break;
+                }
+            }
+            return other("unexpected boolean");
+        }
+
+        bool number_integer(int64_t value) {
+            return number(value);
+        }
+
+        bool number_unsigned(uint64_t value) {
+            return number(value);
+        }
+
+        bool number_float(double value, const std::string&) {
+            return number(value);
+        }
+
+        bool string(std::string& value) {
+            if (skipping_ == 0 && where_ == Where::ROOT && key_ == Key::TYPE) {
+                reader_.is_delta_ = (value == "delta");
+                return true;
+            }
+            if (skipping_ == 0 && where_ == Where::SNAKE && key_ == Key::DIRECTION) {
+                snake_->has_direction = true;
+                snake_->direction.assign(value);
+                return true;
+            }
+            return other("unexpected string");
+        }
+
+        // Only in newer versions of the library, and only ever called for binary formats, never for JSON
+        template <typename Binary>
+        bool binary(Binary&) {
+            return other("unexpected binary value");
+        }
+
+        bool key(std::string& key) {
+            if (skipping_ > 0) {
+                return true;
+            }
+            key_ = (where_ == Where::ROOT) ? rootKey(key) : snakeKey(key);
+            return true;
+        }
+
+        bool start_object(std::size_t) {
+            if (skipping_ > 0) {
+                ++skipping_;
+                return true;
+            }
+            switch (where_) {
+                case Where::START:
+                    where_ = Where::ROOT;
+                    return true;
+                case Where::SNAKES: {
+                    JsonStateReader& r = reader_;
+                    if (r.snake_count_ == r.snakes_.size()) {
+                        r.snakes_.emplace_back();
+                    }
+                    snake_ = &r.snakes_[r.snake_count_++];
+                    snake_->has_id = snake_->has_length = snake_->has_alive = snake_->has_direction = false;
+                    snake_->has_color = snake_->has_location = snake_->has_head = false;
+                    snake_->tail = 0;
+                    snake_->grown = false;
+                    snake_->died = false;
+                    snake_->gone = false;
+                    snake_->direction.clear();
+                    snake_->location.clear();
+                    where_ = Where::SNAKE;
+                    key_ = Key::NONE;
+                    return true;
+                }
+                case Where::ROOT:
+                case Where::SNAKE:
+                    if (key_ == Key::UNKNOWN) {
+                        skipping_ = 1;
+                        return true;
+                    }
+                    return fail("unexpected object");
+                default:
+                    return fail("unexpected object");
+            }
+        }
+
+        bool end_object() {
+            if (skipping_ > 0) {
+                --skipping_;
+                return true;
+            }
+            if (where_ == Where::SNAKE) {
+                where_ = Where::SNAKES;
+                return true;
+            }
+            where_ = Where::DONE;
+            return true;
+        }
+
+        bool start_array(std::size_t) {
+            if (skipping_ > 0) {
+                ++skipping_;
+                return true;
+            }
+            JsonStateReader& r = reader_;
+            switch (where_) {
+                case Where::ROOT:
+                    if (key_ == Key::FOOD) {
+                        r.has_food_ = true;
+                        r.food_.clear();
+                        where_ = Where::FOOD;
+                        return true;
+                    }
+                    if (key_ == Key::SNAKES) {
+                        r.has_snakes_ = true;
+                        r.snake_count_ = 0;
+                        where_ = Where::SNAKES;
+                        return true;
+                    }
+                    break;
+                case Where::SNAKE:
+                    if (key_ == Key::LOCATION) {
+                        snake_->has_location = true;
+                        snake_->location.clear();
+                        where_ = Where::LOCATION;
+                        return true;
+                    }
+                    if (key_ == Key::COLOR) {
+                        snake_->has_color = true;
+                        where_ = Where::COLOR;
+                        index_ = 0;
+                        return true;
+                    }
+                    if (key_ == Key::HEAD) {
+                        snake_->has_head = true;
+                        where_ = Where::HEAD;
+                        index_ = 0;
+                        return true;
+                    }
+                    break;
+                case Where::FOOD:
+                    r.food_.emplace_back(0, 0);
+                    cell_ = &r.food_.back();
+                    where_ = Where::FOOD_CELL;
+                    index_ = 0;
+                    return true;
+                case Where::LOCATION:
+                    snake_->location.emplace_back(0, 0);
+                    cell_ = &snake_->location.back();
+                    where_ = Where::LOCATION_CELL;
+                    index_ = 0;
+                    return true;
+                default:
+                    break;
+            }
+            if ((where_ == Where::ROOT || where_ == Where::SNAKE) && key_ == Key::UNKNOWN) {
+                skipping_ = 1;
+                return true;
+            }
+            return fail("unexpected array");
+        }
+
+        bool end_array() {
+            if (skipping_ > 0) {
+                --skipping_;
+                return true;
+            }
+            switch (where_) {
+                case Where::FOOD_CELL:
+                case Where::LOCATION_CELL:
+                case Where::HEAD:
+                    if (index_ != 2) return fail("a cell needs two coordinates");
+                    where_ = (where_ == Where::FOOD_CELL) ? Where::FOOD : (where_ == Where::HEAD) ? Where::SNAKE : Where::LOCATION;
+                    return true;
+                case Where::COLOR:
+                    if (index_ != 3) return fail("a color needs three components");
+                    where_ = Where::SNAKE;
+                    return true;
+                case Where::FOOD:
+                case Where::SNAKES:
+                    where_ = Where::ROOT;
+                    return true;
+                case Where::LOCATION:
+                    where_ = Where::SNAKE;
+                    return true;
+                default:
+                    return fail("unexpected end of array");
+            }
+        }
+
+        template <typename Exception>
+        bool parse_error(std::size_t, const std::string&, const Exception& e) {
+            throw JsonStateError(e.what());
+        }
+    };
+} // namespace snakelinkedlist
+
+JsonStateReader::Kind JsonStateReader::read(const char* data, std::size_t size, uint64_t fallback_tick) {
+    kind_ = Kind::OTHER;
+    has_tick_ = false;
+    tick_ = 0;
+    is_delta_ = false;
+    has_food_ = false;
+    has_snakes_ = false;
+    snake_count_ = 0;
+
+    JsonStateSax sax(*this);
+    nlohmann::json::sax_parse(data, data + size, &sax);
+    if (!has_snakes_) {
+        return kind_;
+    }
+    if (is_delta_) {
+        finishDelta();
+        kind_ = Kind::DELTA;
+    } else {
+        finishKeyframe(fallback_tick);
+        kind_ = Kind::KEYFRAME;
+    }
+    return kind_;
+}
+
+void JsonStateReader::finishKeyframe(uint64_t fallback_tick) {
+    // The food and the bodies are swapped in rather than copied, the buffers go back and forth between
+    // the reader and the result and none of them are ever freed
+    if (!has_food_) {
+        throw JsonStateError("Malformed world state: keyframe without food");
+    }
+    keyframe_.tick = has_tick_ ? tick_ : fallback_tick;
+    keyframe_.food.swap(food_);
+    keyframe_.has_own_snake = false;
+    keyframe_.own_alive = false;
+    keyframe_.own_length = 0;
+
+    keyframe_.snakes.resize(snake_count_);
+    for (std::size_t i = 0; i < snake_count_; ++i) {
+        SnakeFields& fields = snakes_[i];
+        if (!(fields.has_id && fields.has_length && fields.has_alive && fields.has_direction && fields.has_color
+              && fields.has_location)) {
+            throw JsonStateError("Malformed world state: keyframe snake is missing a field");
+        }
+        snakejson::snake& s = keyframe_.snakes[i];
+        s.id = fields.id;
+        s.length = fields.length;
+        s.alive = fields.alive;
+        s.direction.assign(fields.direction);
+        s.color = fields.color;
+        s.coords.swap(fields.location);
+    }
+}
+
+void JsonStateReader::finishDelta() {
+    if (!has_tick_) {
+        throw JsonStateError("Malformed world state: delta without a tick");
+    }
+    delta_.tick = tick_;
+    delta_.has_food = has_food_;
+    if (has_food_) {
+        delta_.food.swap(food_);
+    }
+
+    delta_.snakes.resize(snake_count_);
+    for (std::size_t i = 0; i < snake_count_; ++i) {
+        SnakeFields& fields = snakes_[i];
+        if (!fields.has_id) {
+            throw JsonStateError("Malformed world state: delta snake without an id");
+        }
+        SnakeDelta& d = delta_.snakes[i];
+        d.id = fields.id;
+        d.has_head = fields.has_head;
+        d.head = fields.head;
+        d.tail = fields.tail;
+        d.grown = fields.grown;
+        d.died = fields.died;
+        d.gone = fields.gone;
+        d.direction.assign(fields.direction);
+        d.has_body = fields.has_location;
+        if (d.has_body) {
+            if (!fields.has_color) {
+                throw JsonStateError("Malformed world state: delta snake with a body but no color");
+            }
+            d.body.swap(fields.location);
+            d.color = fields.color;
+        }
+    }
+}
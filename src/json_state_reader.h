@@ -0,0 +1,89 @@
+#ifndef JSON_STATE_READER_H
+#define JSON_STATE_READER_H
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "world_model.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    // Thrown when a JSON world state is malformed or has a field of the wrong type
+    class JsonStateError : public std::runtime_error {
+    public:
+        explicit JsonStateError(const std::string& what) : std::runtime_error(what) {}
+    };
+
+    /*
+     Reads JSON world states straight into a keyframe or delta with nlohmann's SAX interface.
+     json::parse() builds a DOM, with a node for every number and an array for every cell, and from_json then
+     copies all of it again into the game structs. Here every number goes into its place as the parser reaches it.
+     The keyframe, delta and their buffers are kept from one message to the next, so once they have grown to the
+     size of the board a world state costs no allocations per cell, only the few the parser itself makes.
+     Accepts the same messages as WorldModel::apply(json), keys in any order.
+     */
+    class JsonStateReader {
+    public:
+        enum class Kind {
+            KEYFRAME,
+            DELTA,
+            OTHER // Not a world state (no "snakes"), such as an ack. Nothing was read, parse it as a DOM.
+        };
+
+    private:
+        friend class JsonStateSax;
+
+        // Everything a snake in a keyframe or a delta can have. What the message was only shows once it has
+        // been read, "type" comes after "snakes" in the server's sorted keys.
+        struct SnakeFields {
+            bool has_id, has_length, has_alive, has_direction, has_color, has_location, has_head;
+            int id;
+            int length;
+            bool alive;
+            std::string direction;
+            std::array<int, 3> color;
+            std::vector<std::pair<int, int>> location;
+            std::pair<int, int> head;
+            int tail;
+            bool grown;
+            bool died;
+            bool gone;
+        };
+
+        // Filled by the parser
+        bool has_tick_;
+        uint64_t tick_;
+        bool is_delta_;
+        bool has_food_;
+        std::vector<std::pair<int, int>> food_;
+        bool has_snakes_;
+        std::vector<SnakeFields> snakes_; // Only the first snake_count_ are from this message
+        std::size_t snake_count_;
+
+        // The result, whichever one the message was
+        Kind kind_ = Kind::OTHER;
+        WorldSnapshot keyframe_;
+        WorldDelta delta_;
+
+        void finishKeyframe(uint64_t fallback_tick);
+        void finishDelta();
+
+    public:
+        // Reads one message. Throws JsonStateError if it is a world state but a malformed one.
+        Kind read(const char* data, std::size_t size, uint64_t fallback_tick);
+
+        // What the last read() returned, and the keyframe or delta it read. Valid until the next read().
+        Kind kind() const { return kind_; }
+        const WorldSnapshot& keyframe() const { return keyframe_; }
+        const WorldDelta& delta() const { return delta_; }
+        uint64_t tick() const { return kind_ == Kind::DELTA ? delta_.tick : keyframe_.tick; }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace snakelinkedlist {
+
+    /*
+     Latency distribution with percentiles, safe to record into from any number of threads at once.
+     Buckets are log-linear: every power of two is split into 16 equal buckets, so any value is known to
+     within about 6% from nanoseconds up to hours in 8 KB. Recording is one relaxed atomic increment plus
+     a compare-exchange only when a new maximum is seen; nothing locks and nothing allocates.
+     Reading percentiles while others record gives a consistent enough picture for reporting.
+     */
+    class LatencyHistogram {
+    public:
+        static const int kSubBucketBits = 4;
+        static const int kSubBuckets = 1 << kSubBucketBits;
+        static const int kBuckets = 64 * kSubBuckets;
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> buckets_;
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> total_ns_{0};
+        std::atomic<uint64_t> max_ns_{0};
+
+        static int bucketFor(uint64_t ns) {
+            if (ns < static_cast<uint64_t>(kSubBuckets)) {
+                return static_cast<int>(ns);
+            }
+            int msb = 63 - __builtin_clzll(ns);
+            int major = msb - kSubBucketBits + 1;
+            int sub = static_cast<int>((ns >> (msb - kSubBucketBits)) & (kSubBuckets - 1));
+            return major * kSubBuckets + sub;
+        }
+
+        // Middle of the range of values that land in a bucket
+        static double bucketMiddle(int bucket) {
+            if (bucket < kSubBuckets) {
+                return bucket;
+            }
+            int major = bucket / kSubBuckets;
+            int sub = bucket % kSubBuckets;
+            double low = static_cast<double>(static_cast<uint64_t>(kSubBuckets + sub) << (major - 1));
+            double width = static_cast<double>(uint64_t(1) << (major - 1));
+            return low + width / 2;
+        }
+
+    public:
+        LatencyHistogram() {
+            for (std::atomic<uint64_t>& bucket : buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void add(std::chrono::steady_clock::duration sample) {
+            int64_t signed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(sample).count();
+            uint64_t ns = signed_ns > 0 ? static_cast<uint64_t>(signed_ns) : 0;
+            buckets_[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            total_ns_.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t max = max_ns_.load(std::memory_order_relaxed);
+            while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+            }
+        }
+
+        // Not safe against concurrent add(), for between runs
+        void reset() {
+            for (std::atomic<uint64_t>& bucket : buckets_) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count_.store(0, std::memory_order_relaxed);
+            total_ns_.store(0, std::memory_order_relaxed);
+            max_ns_.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+        double maxMs() const { return max_ns_.load(std::memory_order_relaxed) / 1e6; }
+        double meanMs() const {
+            uint64_t count = this->count();
+            return count ? total_ns_.load(std::memory_order_relaxed) / 1e6 / count : 0;
+        }
+
+        // The value below which a fraction q of the samples fall, e.g. 0.99 for p99
+        double percentileMs(double q) const {
+            uint64_t count = this->count();
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(q * count);
+            if (rank >= count) {
+                rank = count - 1;
+            }
+            uint64_t seen = 0;
+            for (int bucket = 0; bucket < kBuckets; ++bucket) {
+                seen += buckets_[bucket].load(std::memory_order_relaxed);
+                if (seen > rank) {
+                    return std::min(bucketMiddle(bucket) / 1e6, maxMs());
+                }
+            }
+            return maxMs();
+        }
+
+        // Human readable one line summary, e.g. "n=1000 p50=1.20ms p99=3.41ms p999=8.02ms max=9.10ms"
+        std::string summary() const {
+            std::ostringstream out;
+            out.setf(std::ios::fixed);
+            out.precision(2);
+            out << "n=" << count() << " p50=" << percentileMs(0.5) << "ms p99=" << percentileMs(0.99)
+                << "ms p999=" << percentileMs(0.999) << "ms max=" << maxMs() << "ms";
+            return out.str();
+        }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace snakelinkedlist {
+
+    // Running count/mean/min/max of a latency measurement, reported in milliseconds
+    class LatencyStats {
+    private:
+        uint64_t count_ = 0;
+        double total_ms_ = 0;
+        double min_ms_ = 0;
+        double max_ms_ = 0;
+
+    public:
+        void add(std::chrono::steady_clock::duration sample) {
+            double ms = std::chrono::duration<double, std::milli>(sample).count();
+            min_ms_ = (count_ == 0) ? ms : std::min(min_ms_, ms);
+            max_ms_ = (count_ == 0) ? ms : std::max(max_ms_, ms);
+            total_ms_ += ms;
+            ++count_;
+        }
+
+        void reset() { *this = LatencyStats(); }
+
+        uint64_t count() const { return count_; }
+        double meanMs() const { return count_ ? total_ms_ / count_ : 0; }
+        double minMs() const { return min_ms_; }
+        double maxMs() const { return max_ms_; }
+
+        // Human readable one line summary, e.g. "n=10 mean=12.3ms min=8.0ms max=20.1ms"
+        std::string summary() const {
+            std::ostringstream out;
+            out.setf(std::ios::fixed);
+            out.precision(1);
+            out << "n=" << count_ << " mean=" << meanMs() << "ms min=" << min_ms_ << "ms max=" << max_ms_ << "ms";
+            return out.str();
+        }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef LATEST_SLOT_H
+#define LATEST_SLOT_H
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace snakelinkedlist {
+
+    /*
+     Lock-free single-producer/single-consumer handoff that only keeps the newest value.
+     The producer (the io_context thread) swaps a new value into the slot and the
+     consumer (the render thread) swaps nullptr back in to take ownership. Neither side ever blocks.
+     If the producer publishes twice before the consumer looks, the older value is thrown away,
+     which is exactly what we want for world states: only the most recent one is worth drawing.
+     */
+    template <typename T>
+    class LatestSlot {
+    private:
+        std::atomic<T*> slot_{nullptr}; // The value waiting to be picked up, nullptr when empty
+        std::atomic<uint64_t> overwritten_{0}; // How many published values were replaced before being taken
+
+    public:
+        LatestSlot() = default;
+        LatestSlot(const LatestSlot&) = delete;
+        LatestSlot& operator=(const LatestSlot&) = delete;
+        ~LatestSlot() { delete slot_.exchange(nullptr); }
+
+        // Producer side: hands the value over, discarding anything the consumer has not taken yet.
+        // The discarded value is handed back, so it can be reused instead of freed.
+        std::unique_ptr<T> publish(std::unique_ptr<T> value) {
+            T* previous = slot_.exchange(value.release(), std::memory_order_acq_rel);
+            if (previous) {
+                overwritten_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return std::unique_ptr<T>(previous);
+        }
+
+        // Consumer side: takes the newest value if there is one, returns nullptr otherwise
+        std::unique_ptr<T> take() {
+            return std::unique_ptr<T>(slot_.exchange(nullptr, std::memory_order_acq_rel));
+        }
+
+        uint64_t overwritten() const { return overwritten_.load(std::memory_order_relaxed); }
+    };
+} // namespace snakelinkedlist
+
+#endif
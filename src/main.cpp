@@ -1,12 +1,93 @@
-#include "ofMain.h"
-#include "ofApp.h"
-#include <boost/asio.hpp>
-
-int main() {
-    ofSetupOpenGL(1200, 675, OF_WINDOW); // setup the GL context
-    ofSetFrameRate(5); // An appropriate framerate that moves the snake at a good speed
-    // Due to the simple nature of our objects rendering things this slow should not cause visual discomfort or lage
-    
-    // this kicks off the running of my app
-    ofRunApp(new snakelinkedlist::snakeGame());
-}
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/*
+ Usage: Snake-MaxProfit [--headless] [--seconds n] [--autopilot] [--record file] [--replay file [--speed x] [--seek tick]]
+                        [--timings-csv file] [--arena WxH] [--interp-delay-ms n] [--render batched|immediate|dirty]
+                        [--share name]
+ --headless runs the whole client loop without a window or a GL context, as fast as it will go
+ --seconds n exits after n seconds
+ --autopilot steers at random and respawns, so nobody has to be at the keyboard
+ --record file writes every world state received to file
+ --replay file plays a recording instead of connecting, at 1 to 100 times real time, starting at a tick
+ --timings-csv file writes how long each frame stage took to file on exit
+ --arena WxH is the size of the server's board in cells, 48x27 by default. The camera follows our snake around
+   boards bigger than the window.
+ --interp-delay-ms n draws the board n ms behind the newest world state, sliding the snakes between the states
+   either side of that, 250 by default. 0 draws the newest state as it is. , and . change it while running.
+ --render picks how the board is drawn: one mesh (the default), one rectangle per cell, or a framebuffer in which
+   only the cells that changed are painted. F2 switches between them while running.
+ --share name publishes every world state in shared memory called name, for spectators, recorders and bots on
+   the same machine to read without a connection of their own (tools/shared_world_reader)
+ */
+int main(int argc, char* argv[]) {
+    snakelinkedlist::LaunchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--headless") {
+            options.headless = true;
+        } else if (flag == "--autopilot") {
+            options.autopilot = true;
+        } else if (flag == "--seconds" && i + 1 < argc) {
+            options.run_seconds = std::atof(argv[++i]);
+        } else if (flag == "--record" && i + 1 < argc) {
+            options.record_path = argv[++i];
+        } else if (flag == "--share" && i + 1 < argc) {
+            options.share_name = argv[++i];
+        } else if (flag == "--replay" && i + 1 < argc) {
+            options.replay_path = argv[++i];
+        } else if (flag == "--speed" && i + 1 < argc) {
+            options.replay_speed = std::atof(argv[++i]);
+        } else if (flag == "--timings-csv" && i + 1 < argc) {
+            options.timings_csv_path = argv[++i];
+        } else if (flag == "--arena" && i + 1 < argc) {
+            std::string size = argv[++i];
+            std::size_t x = size.find('x');
+            if (x == std::string::npos || std::atoi(size.c_str()) <= 0 || std::atoi(size.c_str() + x + 1) <= 0) {
+                std::cerr << "--arena wants a size like 1000x1000, not " << size << std::endl;
+                return 1;
+            }
+            options.arena_width = std::atoi(size.c_str());
+            options.arena_height = std::atoi(size.c_str() + x + 1);
+        } else if (flag == "--interp-delay-ms" && i + 1 < argc) {
+            options.interpolation_delay_ms = std::max(0.0, std::atof(argv[++i]));
+        } else if (flag == "--render" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "batched") {
+                options.render_mode = snakelinkedlist::RenderMode::BATCHED;
+            } else if (mode == "immediate") {
+                options.render_mode = snakelinkedlist::RenderMode::IMMEDIATE;
+            } else if (mode == "dirty") {
+                options.render_mode = snakelinkedlist::RenderMode::DIRTY_CELLS;
+            } else {
+                std::cerr << "--render wants batched, immediate or dirty, not " << mode << std::endl;
+                return 1;
+            }
+        } else if (flag == "--seek" && i + 1 < argc) {
+            options.has_replay_seek = true;
+            options.replay_seek = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.headless) {
+        // Same board size as the window, without the window
+        ofSetupOpenGL(std::make_shared<ofAppNoWindow>(), 1200, 675, OF_WINDOW);
+        ofSetFrameRate(0); // Uncapped, update() runs back to back
+    } else {
+        ofSetupOpenGL(1200, 675, OF_WINDOW); // setup the GL context
+        ofSetFrameRate(60); // World states are picked up as soon as they arrive, so render well above the server tick
+        // Frames in between server ticks slide the snakes between the last two states, see snapshot_interpolator.h
+    }
+
+    // this kicks off the running of my app
+    ofRunApp(new snakelinkedlist::snakeGame(options));
+}
@@ -0,0 +1,288 @@
+#include "match_recording.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "wire_codec.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    // Records waiting for the writer beyond this are dropped, a disk that slow would never catch up anyway
+    const std::size_t kMaxPendingBytes = 64 * 1024 * 1024;
+
+    void putU32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void putU64(std::string& out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    uint32_t getU32(const char* in) {
+        uint32_t value = 0;
+        for (int i = 3; i >= 0; --i) {
+            value = (value << 8) | static_cast<uint8_t>(in[i]);
+        }
+        return value;
+    }
+
+    uint64_t getU64(const char* in) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) {
+            value = (value << 8) | static_cast<uint8_t>(in[i]);
+        }
+        return value;
+    }
+} // namespace
+
+MatchRecorder::MatchRecorder(const std::string& path, uint32_t own_id)
+    : file_(std::fopen(path.c_str(), "wb")), started_at_(std::chrono::steady_clock::now()) {
+    if (!file_) {
+        throw RecordingError("Could not create recording " + path + ": " + std::strerror(errno));
+    }
+    std::string header(kRecordingMagic, kRecordingMagicLength);
+    putU32(header, own_id);
+    putU32(header, 0);
+    std::fwrite(header.data(), 1, header.size(), file_);
+    writer_ = std::thread([this]() { this->writeLoop(); });
+}
+
+MatchRecorder::~MatchRecorder() {
+    close();
+}
+
+void MatchRecorder::append(uint64_t tick, uint8_t flags, std::chrono::steady_clock::time_point received_at,
+                           const char* data, std::size_t size) {
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(received_at - started_at_).count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) {
+        return;
+    }
+    if (pending_.size() + kRecordHeaderLength + size > kMaxPendingBytes) {
+        ++dropped_;
+        return;
+    }
+    bool idle = pending_.empty();
+    index_.push_back(IndexEntry{tick, end_offset_});
+    putU64(pending_, tick);
+    putU64(pending_, static_cast<uint64_t>(std::max<int64_t>(0, time)));
+    putU32(pending_, static_cast<uint32_t>(size));
+    pending_.push_back(static_cast<char>(flags));
+    pending_.append(3, '\0');
+    pending_.append(data, size);
+    end_offset_ += kRecordHeaderLength + size;
+    if (idle) {
+        wake_.notify_one();
+    }
+}
+
+void MatchRecorder::writeLoop() {
+    std::string writing;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this]() { return closing_ || !pending_.empty(); });
+        if (pending_.empty() && closing_) {
+            return;
+        }
+        // Swap the buffers so append() can carry on while this batch is written
+        writing.swap(pending_);
+        lock.unlock();
+        std::fwrite(writing.data(), 1, writing.size(), file_);
+        std::fflush(file_); // A crash loses at most the batch being written
+        writing.clear();
+        lock.lock();
+    }
+}
+
+void MatchRecorder::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) {
+            return;
+        }
+        closing_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+
+    // Everything is on disk, the index goes after the last record
+    std::string trailer;
+    trailer.reserve(index_.size() * 16 + kRecordingFooterLength);
+    for (const IndexEntry& entry : index_) {
+        putU64(trailer, entry.tick);
+        putU64(trailer, entry.offset);
+    }
+    trailer.append(kRecordingIndexMagic, kRecordingMagicLength);
+    putU64(trailer, end_offset_);
+    putU64(trailer, index_.size());
+    std::fwrite(trailer.data(), 1, trailer.size(), file_);
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+uint64_t MatchRecorder::recorded() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+uint64_t MatchRecorder::dropped() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+MatchReplay::MatchReplay(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw RecordingError("Could not open recording " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < kRecordingHeaderLength) {
+        ::close(fd);
+        throw RecordingError(path + " is too short to be a recording");
+    }
+    mapped_size_ = static_cast<std::size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file open
+    if (mapped == MAP_FAILED) {
+        throw RecordingError("Could not map recording " + path + ": " + std::strerror(errno));
+    }
+    mapped_ = static_cast<const char*>(mapped);
+
+    if (std::memcmp(mapped_, kRecordingMagic, kRecordingMagicLength) != 0) {
+        ::munmap(const_cast<char*>(mapped_), mapped_size_);
+        throw RecordingError(path + " is not a match recording");
+    }
+    own_id_ = getU32(mapped_ + kRecordingMagicLength);
+    buildIndex();
+}
+
+MatchReplay::~MatchReplay() {
+    ::munmap(const_cast<char*>(mapped_), mapped_size_);
+}
+
+void MatchReplay::buildIndex() {
+    // A cleanly closed recording ends with its index
+    std::size_t records_end = mapped_size_;
+    if (mapped_size_ >= kRecordingHeaderLength + kRecordingFooterLength) {
+        const char* footer = mapped_ + mapped_size_ - kRecordingFooterLength;
+        uint64_t index_offset = getU64(footer + kRecordingMagicLength);
+        uint64_t count = getU64(footer + kRecordingMagicLength + 8);
+        if (std::memcmp(footer, kRecordingIndexMagic, kRecordingMagicLength) == 0
+            && index_offset >= kRecordingHeaderLength && count <= mapped_size_ / 16
+            && index_offset + count * 16 + kRecordingFooterLength == mapped_size_) {
+            // Every record the index points at, header and body, has to lie before the index itself
+            offsets_.reserve(count);
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t offset = getU64(mapped_ + index_offset + i * 16 + 8);
+                if (offset < kRecordingHeaderLength || offset > index_offset
+                    || index_offset - offset < kRecordHeaderLength
+                    || index_offset - offset - kRecordHeaderLength < getU32(mapped_ + offset + 16)) {
+                    break;
+                }
+                offsets_.push_back(offset);
+            }
+            if (offsets_.size() == count) {
+                return;
+            }
+            std::cerr << "Recording index entry " << offsets_.size() << " points outside the records" << std::endl;
+            offsets_.clear();
+            records_end = index_offset;
+        }
+    }
+
+    // Otherwise the client stopped without closing it, or the index is damaged.
+    // Walk the records up to the last complete one.
+    std::size_t offset = kRecordingHeaderLength;
+    while (offset + kRecordHeaderLength <= records_end) {
+        std::size_t size = getU32(mapped_ + offset + 16);
+        if (offset + kRecordHeaderLength + size > records_end) {
+            break;
+        }
+        offsets_.push_back(offset);
+        offset += kRecordHeaderLength + size;
+    }
+    std::cerr << "Recording has no usable index, recovered " << offsets_.size() << " records" << std::endl;
+}
+
+MatchReplay::Record MatchReplay::record(std::size_t index) const {
+    const char* header = mapped_ + offsets_[index];
+    Record record;
+    record.tick = getU64(header);
+    record.time = std::chrono::nanoseconds(static_cast<int64_t>(getU64(header + 8)));
+    record.size = getU32(header + 16);
+    record.flags = static_cast<uint8_t>(header[20]);
+    record.data = header + kRecordHeaderLength;
+    return record;
+}
+
+bool MatchReplay::applyRecord(std::size_t index) {
+    Record r = record(index);
+    try {
+        if (r.flags & kRecordBinary) {
+            return model_.applyWire(r.data, r.size);
+        }
+        // Only world states are recorded, so there is never anything else to parse as a DOM here
+        return json_reader_.read(r.data, r.size, r.tick) != JsonStateReader::Kind::OTHER && model_.apply(json_reader_);
+    } catch (std::exception& e) {
+        // Same as the live client, a state that does not decode is skipped
+        std::cerr << "Recorded state for tick " << r.tick << ": " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::unique_ptr<WorldSnapshot> MatchReplay::seek(uint64_t tick) {
+    if (offsets_.empty()) {
+        return nullptr;
+    }
+    // Ticks only go up within one server run, so the records are sorted by tick
+    std::size_t target = std::upper_bound(offsets_.begin(), offsets_.end(), tick,
+                                          [this](uint64_t t, uint64_t offset) { return t < getU64(mapped_ + offset); })
+        - offsets_.begin();
+    target = target > 0 ? target - 1 : 0;
+
+    std::size_t from = target;
+    while (from > 0 && !(record(from).flags & kRecordKeyframe)) {
+        --from;
+    }
+    model_ = WorldModel();
+    for (std::size_t i = from; i <= target; ++i) {
+        applyRecord(i);
+    }
+    next_ = target + 1;
+    return model_.synced() ? model_.snapshot(own_id_) : nullptr;
+}
+
+std::unique_ptr<WorldSnapshot> MatchReplay::advanceTo(std::chrono::nanoseconds position) {
+    bool changed = false;
+    while (next_ < offsets_.size() && record(next_).time <= position) {
+        if (applyRecord(next_)) {
+            changed = true;
+        }
+        ++next_;
+    }
+    return changed ? model_.snapshot(own_id_) : nullptr;
+}
+
+std::chrono::nanoseconds MatchReplay::position() const {
+    return next_ > 0 ? record(next_ - 1).time : std::chrono::nanoseconds(0);
+}
+
+uint64_t MatchReplay::firstTick() const {
+    return offsets_.empty() ? 0 : record(0).tick;
+}
+
+uint64_t MatchReplay::lastTick() const {
+    return offsets_.empty() ? 0 : record(offsets_.size() - 1).tick;
+}
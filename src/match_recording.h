@@ -0,0 +1,154 @@
+#ifndef MATCH_RECORDING_H
+#define MATCH_RECORDING_H
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json_state_reader.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    /*
+     A match recording is every world state the client received, exactly as it came off the wire, so a replay
+     goes through the same decoding and rendering as the live game.
+       header   "SNAKREC1", u32 own snake id, u32 reserved
+       records  u64 tick, u64 nanoseconds since recording started, u32 body size, u8 flags, 3 bytes padding, body
+       index    u64 tick, u64 file offset of the record, one per record          (written when the recording is closed)
+       footer   "SNAKIDX1", u64 file offset of the index, u64 number of records  (written when the recording is closed)
+     The file is only ever appended to. If the client dies before closing it the index is missing, and the
+     replay rebuilds it by walking the records up to the last complete one. It does the same if an index entry
+     points outside the records. Integers are little endian.
+     */
+    const char kRecordingMagic[] = "SNAKREC1";
+    const char kRecordingIndexMagic[] = "SNAKIDX1";
+    const std::size_t kRecordingMagicLength = 8;
+    const std::size_t kRecordingHeaderLength = 16;
+    const std::size_t kRecordHeaderLength = 24;
+    const std::size_t kRecordingFooterLength = 24;
+    const uint8_t kRecordKeyframe = 1; // The record replaces the whole world, a replay can start from it
+    const uint8_t kRecordBinary = 2; // The body is in the binary wire format rather than JSON
+
+    // Thrown when a recording cannot be created, opened or is not a recording at all
+    class RecordingError : public std::runtime_error {
+    public:
+        explicit RecordingError(const std::string& what) : std::runtime_error(what) {}
+    };
+
+    /*
+     Appends received world states to a recording file.
+     append() only copies the message into a buffer, a writer thread of its own does the file I/O, so neither
+     the io thread nor the render thread ever waits on the disk. If the disk falls too far behind, messages are
+     dropped and counted instead of buffering without bound.
+     */
+    class MatchRecorder {
+    private:
+        struct IndexEntry {
+            uint64_t tick;
+            uint64_t offset;
+        };
+
+        std::FILE* file_;
+        std::chrono::steady_clock::time_point started_at_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::string pending_; // Records appended but not yet written, guarded by mutex_
+        std::vector<IndexEntry> index_; // Guarded by mutex_
+        uint64_t end_offset_ = kRecordingHeaderLength; // File offset of the next record appended, guarded by mutex_
+        uint64_t dropped_ = 0; // Guarded by mutex_
+        bool closing_ = false; // Guarded by mutex_
+        std::thread writer_;
+
+        void writeLoop();
+
+    public:
+        // Creates or truncates the file and starts the writer thread. Throws RecordingError.
+        MatchRecorder(const std::string& path, uint32_t own_id);
+        ~MatchRecorder(); // Closes the recording
+
+        MatchRecorder(const MatchRecorder&) = delete;
+        MatchRecorder& operator=(const MatchRecorder&) = delete;
+
+        // Queues one received world state. Safe to call from any thread.
+        void append(uint64_t tick, uint8_t flags, std::chrono::steady_clock::time_point received_at,
+                    const char* data, std::size_t size);
+
+        // Writes everything still queued and the tick index, and closes the file. Safe to call more than once.
+        void close();
+
+        uint64_t recorded();
+        uint64_t dropped();
+    };
+
+    /*
+     Plays a recording back through a WorldModel.
+     The file is memory mapped, so opening a long recording costs nothing up front and seeking reads only the
+     records it needs: from the closest keyframe at or before the tick to the tick itself.
+     Not thread safe, the replay is meant to be driven from the thread that calls GameClient::update().
+     */
+    class MatchReplay {
+    private:
+        struct Record {
+            uint64_t tick;
+            std::chrono::nanoseconds time; // Since the recording started
+            uint8_t flags;
+            const char* data;
+            std::size_t size;
+        };
+
+        const char* mapped_ = nullptr;
+        std::size_t mapped_size_ = 0;
+        uint32_t own_id_ = 0;
+        std::vector<uint64_t> offsets_; // File offset of every record, in recording order
+
+        WorldModel model_;
+        JsonStateReader json_reader_;
+        std::size_t next_ = 0; // The record advanceTo() applies next
+
+        Record record(std::size_t index) const;
+        void buildIndex();
+        bool applyRecord(std::size_t index);
+
+    public:
+        // Maps the recording and loads or rebuilds its tick index. Throws RecordingError.
+        explicit MatchReplay(const std::string& path);
+        ~MatchReplay();
+
+        MatchReplay(const MatchReplay&) = delete;
+        MatchReplay& operator=(const MatchReplay&) = delete;
+
+        /*
+         Rebuilds the world as it was at the last recorded state with a tick no later than the one asked for,
+         starting from the closest keyframe before it. Ticks before the first record land on the first record.
+         Returns null if the recording is empty or has no keyframe before that point.
+         */
+        std::unique_ptr<WorldSnapshot> seek(uint64_t tick);
+
+        // Applies every record received up to position into the recording.
+        // Returns a snapshot of the world if any of them changed it, null otherwise.
+        std::unique_ptr<WorldSnapshot> advanceTo(std::chrono::nanoseconds position);
+
+        // Where in the recording the last applied state arrived, what advanceTo() continues from
+        std::chrono::nanoseconds position() const;
+
+        bool finished() const { return next_ >= offsets_.size(); }
+        std::size_t records() const { return offsets_.size(); }
+        uint64_t firstTick() const;
+        uint64_t lastTick() const;
+        uint32_t ownId() const { return own_id_; }
+        const WorldModel& model() const { return model_; }
+    };
+} // namespace snakelinkedlist
+
+#endif
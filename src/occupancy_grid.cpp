@@ -0,0 +1,67 @@
+#include <algorithm>
+#include "occupancy_grid.h"
+
+namespace snakelinkedlist {
+
+    const OccupancyGrid::Owner OccupancyGrid::kEmpty;
+    const OccupancyGrid::Owner OccupancyGrid::kWall;
+
+    OccupancyGrid::OccupancyGrid(int width, int height, bool track_free_cells)
+        : width_(std::max(width, 0)), height_(std::max(height, 0)),
+          owners_(static_cast<std::size_t>(width_) * height_, kEmpty) {
+        if (track_free_cells) {
+            free_ = std::make_unique<FreeCellSet>(width_, height_);
+        }
+    }
+
+    bool OccupancyGrid::occupy(const GridCell& cell, Owner owner) {
+        if (!contains(cell)) {
+            return false;
+        }
+        Owner& slot = owners_[index(cell)];
+        if (slot != kEmpty) {
+            return false;
+        }
+        slot = owner;
+        ++occupied_;
+        if (free_) {
+            free_->remove(cell);
+        }
+        return true;
+    }
+
+    void OccupancyGrid::release(const GridCell& cell, Owner owner) {
+        if (!contains(cell)) {
+            return;
+        }
+        Owner& slot = owners_[index(cell)];
+        if (slot == owner && slot != kEmpty) {
+            slot = kEmpty;
+            --occupied_;
+            if (free_) {
+                free_->insert(cell);
+            }
+        }
+    }
+
+    void OccupancyGrid::clear() {
+        std::fill(owners_.begin(), owners_.end(), kEmpty);
+        occupied_ = 0;
+        if (free_) {
+            free_->fill();
+        }
+    }
+
+    void OccupancyGrid::reserve(const GridCell& cell) {
+        if (free_ && contains(cell)) {
+            free_->remove(cell);
+        }
+    }
+
+    void OccupancyGrid::unreserve(const GridCell& cell) {
+        if (free_ && contains(cell) && owners_[index(cell)] == kEmpty) {
+            free_->insert(cell);
+        }
+    }
+
+} // namespace snakelinkedlist
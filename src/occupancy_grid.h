@@ -0,0 +1,89 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "free_cell_set.h"
+#include "snakebody.h"
+
+namespace snakelinkedlist {
+
+    /*
+     Which snake, if any, is in each cell of the board.
+     Every snake on the board shares one grid and keeps it current as it moves: the cell its head enters is
+     claimed and the cell its tail leaves is released. Asking whether a cell is safe is then a single lookup
+     no matter how many snakes there are or how long they get. Cells off the board read as kWall, so walls
+     need no separate check.
+     A grid that places food or spawns snakes can also track its free cells in a FreeCellSet, kept in sync by
+     occupy() and release() themselves, so randomFreeCell() is O(1) and always valid however full the board is.
+     */
+    class OccupancyGrid {
+    public:
+        typedef std::uint16_t Owner; // Id of the snake in a cell
+
+        static const Owner kEmpty = 0; // Nobody is in the cell
+        static const Owner kWall = 0xFFFF; // The cell is off the board, also the largest id a snake can't use
+
+    private:
+        int width_;
+        int height_;
+        std::vector<Owner> owners_; // Row major, width_ * height_ cells
+        std::size_t occupied_ = 0; // Number of cells that are not kEmpty
+        std::unique_ptr<FreeCellSet> free_; // Empty cells that are not reserved, only if asked for
+
+        std::size_t index(const GridCell& cell) const {
+            return static_cast<std::size_t>(cell.y) * width_ + cell.x;
+        }
+
+    public:
+        // A board of width by height cells, all empty. Tracking free cells costs 8 more bytes per cell and a
+        // little time in occupy() and release(), so only grids that need randomFreeCell() should ask for it.
+        OccupancyGrid(int width, int height, bool track_free_cells = false);
+
+        int width() const { return width_; }
+        int height() const { return height_; }
+        std::size_t occupied() const { return occupied_; }
+
+        // One unsigned compare per axis covers both the negative and the too-large side
+        bool contains(const GridCell& cell) const {
+            return static_cast<unsigned>(cell.x) < static_cast<unsigned>(width_)
+                && static_cast<unsigned>(cell.y) < static_cast<unsigned>(height_);
+        }
+
+        // Who is in the cell, kWall if it is off the board
+        Owner owner(const GridCell& cell) const {
+            return contains(cell) ? owners_[index(cell)] : kWall;
+        }
+
+        bool isFree(const GridCell& cell) const { return owner(cell) == kEmpty; }
+
+        // Claims the cell for owner if it is on the board and free, returns whether it did
+        bool occupy(const GridCell& cell, Owner owner);
+
+        // Frees the cell if owner still holds it, so a snake can never release a cell someone else claimed
+        void release(const GridCell& cell, Owner owner);
+
+        void clear(); // Empties every cell, and forgets every reservation
+
+        // Keeps an empty cell out of randomFreeCell() without making it a wall, which is what a food pellet
+        // needs: snakes can still move into it. Does nothing unless free cells are tracked.
+        void reserve(const GridCell& cell);
+        // Makes a reserved cell available again, if nobody occupies it
+        void unreserve(const GridCell& cell);
+
+        // Writes a uniformly random empty, unreserved cell to cell in O(1). Returns false if there is none,
+        // or if free cells are not tracked.
+        template <typename Generator>
+        bool randomFreeCell(Generator& generator, GridCell& cell) const {
+            return free_ && free_->random(generator, cell);
+        }
+
+        // Empty, unreserved cells, 0 unless free cells are tracked
+        std::size_t freeCells() const { return free_ ? free_->size() : 0; }
+    };
+
+} // namespace snakelinkedlist
+#endif
@@ -1,245 +1,521 @@
-#include "ofApp.h"
-#include <iostream>
-#include <cstdio>
-#include <thread>
-#include <chrono>
-#include "ofxTCPClient.h"
-
-using namespace snakelinkedlist;
-using nlohmann::json;
-
-void snakejson::from_json(const json& j, snakejson::snake& s) {
-    j.at("id").get_to(s.id);
-    j.at("length").get_to(s.length);
-    j.at("alive").get_to(s.alive);
-    j.at("direction").get_to(s.direction);
-    j.at("color").get_to(s.color);
-    j.at("location").get_to(s.coords);
-}
-
-// Setup method
-void snakeGame::setup(){
-//    ofxTCPClient client;
-//    bool connected = client.setup("127.0.0.1", 49145);
-//    std::cout << "YES WE ARE CONNECTED" << std::endl;
-    ofSetWindowTitle("Snake126");
-    
-    srand(static_cast<unsigned>(time(0))); // Seed random with current time
-    // SETUP THE NETWORKING HERE AND GET THE ID OF OUR SNAKE
-    
-    try {
-        io_context_ = std::make_unique<boost::asio::io_context>();
-        boost::asio::ip::tcp::resolver resolver(*io_context_);
-        auto endpoints = resolver.resolve(networking::kIPADDRESS.c_str(), networking::kPORT.c_str());
-        client_ = std::make_unique<chat_client>(*io_context_, endpoints);
-        thread_ = std::make_unique<std::thread>([this](){ this->io_context_->run(); });
-        std::this_thread::sleep_for(std::chrono::milliseconds(3000));
-        
-        json json_to_parse = client_->get_recent_json();
-        
-        if (json_to_parse.find("Error") != json_to_parse.end()) {
-            std::cout << "Reconnecting..." << std::endl;
-            client_->close();
-            thread_->join();
-            
-            io_context_.release();
-            client_.release();
-            thread_.release();
-            
-            io_context_ = std::make_unique<boost::asio::io_context>();
-            boost::asio::ip::tcp::resolver resolver(*io_context_);
-            auto endpoints = resolver.resolve(networking::kIPADDRESS.c_str(), networking::kPORT.c_str());
-            client_ = std::make_unique<chat_client>(*io_context_, endpoints);
-            thread_ = std::make_unique<std::thread>([this](){ this->io_context_->run(); });
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
-        
-    } catch (std::exception& e) {
-        std::cerr << e.what() << std::endl;
-    }
-    id_ = 5;
-}
-
-/*
- Update function called before every draw
- If the function should update when it is called it will:
- 1. Check to see if the game is in progress, if it is paused or over it should not update.
- 2. Check to see if the current head of the snake intersects the food pellet. If so:
- * The snake should grow by length 1 in its current direction
- * The food should be moved to a new random location
- 3. Update the snake in the current direction it is moving
- 4. Check to see if the snakes new position has resulted in its death and the end of the game
- */
-void snakeGame::update() {
-    
-    // Start the timer for ensuring we have the best shot to get non gibberish from server
-    std::chrono::milliseconds d = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_);
-    std::this_thread::sleep_for(std::chrono::milliseconds(200) - d);
-    
-    auto start_ = std::chrono::high_resolution_clock::now();
-    
-    // Receives json from the server
-    json json_to_parse = client_->get_recent_json();
-    
-    if (!json_to_parse.is_null()) {
-        try {
-            
-            // This is necessary because if the json cannot be parsed we have to
-            // Keep displaying something on the screen, if this fails it wont
-            // call clear and we'll still have stuff displayed on our screen
-            auto temp = json_to_parse["food"].get<std::vector<std::pair<int, int>>>();
-            food_loc_.clear();
-            food_loc_ = temp;
-            
-            // Get snake locations and info
-            snake_vec_.clear();
-            for (json j : json_to_parse["snakes"]) {
-                snakejson::snake s = j.get<snakejson::snake>();
-                snake_vec_.push_back(s);
-            }
-            
-            // Get this snake and put it into our fields
-            for (int i = 0; i < snake_vec_.size(); ++i) {
-                if (snake_vec_.at(i).id == id_) {
-                    // This is our snake
-                    num_food_eaten_ = snake_vec_.at(i).length;
-                    alive_ = snake_vec_.at(i).alive;
-                    if (alive_) {
-                        current_state_ = GameState::IN_PROGRESS;
-                    } else {
-                        current_state_ = GameState::FINISHED;
-                    }
-                }
-            }
-        } catch (std::exception& e) {
-            std::cerr << e.what() << std::endl;
-        }
-    }
-    
-    // The time between the entire gameloop
-    auto finish_ = std::chrono::high_resolution_clock::now();
-    elapsed_ = finish_ - start_;
-}
-
-/*
- Draws the current state of the game with the following logic
- 1. If the game is paused draw the pause screen
- 2. If the game is finished draw the game over screen and final score
- 3. Draw the current position of the food and of the snake
- */
-void snakeGame::draw(){
-    // Wipes the background and then puts the snakes and food back onto it
-    ofColor background_color;
-    background_color.set(255, 255, 255);
-    ofClear(background_color);
-    if (current_state_ == GameState::FINISHED) {
-        drawGameOver();
-    }
-    drawFood();
-    drawSnakes();
-}
-
-/*
- Function that handles actions based on user key presses
- 1. if key == F12, toggle fullscreen
- 3. if game is in progress handle WASD action
- 4. if key == r and game is over reset it
- 
- WASD logic:
- Let dir be the direction that corresponds to a key
- if current direction is not dir (Prevents key spamming to rapidly update the snake)
- and current_direction is not opposite of dir (Prevents the snake turning and eating itself)
- Update direction of snake and force a game update (see ofApp.h for why)
- */
-void snakeGame::keyPressed(int key){
-    //    if (key == OF_KEY_F12) {
-    //        ofToggleFullscreen();
-    //        return;
-    //    }
-    
-    int upper_key = toupper(key); // Standardize on upper case
-    
-    if (current_state_ == GameState::IN_PROGRESS) {
-        
-        // If current direction has changed to a valid new one, force an immediate update and skip the next frame update
-        if (upper_key == 'W' && should_update_) {
-            should_update_ = false;
-            json_to_send_["id"] = id_;
-            json_to_send_["action"] = std::string("W");
-            send_json(json_to_send_);
-            json_to_send_.clear();
-
-        } else if (upper_key == 'A' && should_update_) {
-            should_update_ = false;
-            json_to_send_["id"] = id_;
-            json_to_send_["action"] = std::string("A");
-            send_json(json_to_send_);
-            json_to_send_.clear();
-            
-        } else if (upper_key == 'S' && should_update_) {
-            should_update_ = false;
-            json_to_send_["id"] = id_;
-            json_to_send_["action"] = std::string("S");
-            send_json(json_to_send_);
-            json_to_send_.clear();
-            
-        } else if (upper_key == 'D' && should_update_) {
-            should_update_ = false;
-            json_to_send_["id"] = id_;
-            json_to_send_["action"] = std::string("D");
-            send_json(json_to_send_);
-            json_to_send_.clear();
-        }
-    } else if (upper_key == 'R' && current_state_ == GameState::FINISHED && should_update_) {
-        should_update_ = false;
-        json_to_send_["id"] = id_;
-        json_to_send_["action"] = std::string("R");
-        send_json(json_to_send_);
-        json_to_send_.clear();
-    }
-}
-
-void snakeGame::windowResized(int w, int h){
-    // Do nothing here
-//    game_food_.resize(w, h);
-//    game_snake_.resize(w, h);
-}
-
-void snakeGame::drawFood() {
-    for (std::pair<int, int> coords : food_loc_) {
-        ofSetColor(ofColor(255,0,0));
-        ofDrawRectangle(coords.first * 25, coords.second * 25, 25, 25);
-    }
-}
-
-void snakeGame::drawSnakes() {
-    for (snakejson::snake s : snake_vec_) {
-        // Set color here
-        int red = s.color.at(0);
-        int green = s.color.at(1);
-        int blue = s.color.at(2);
-        
-        ofSetColor(ofColor(red, green, blue));
-        for (std::pair<int, int> coord : s.coords) {
-            ofDrawRectangle(coord.first * 25, coord.second * 25, 25, 25);
-        }
-    }
-}
-
-void snakeGame::drawGameOver() {
-    string total_food = std::to_string(num_food_eaten_);
-    string lose_message = "You Lost! Final Score: " + total_food;
-    ofSetColor(0, 0, 0);
-    ofDrawBitmapString(lose_message, ofGetWindowWidth() / 2, ofGetWindowHeight() / 2);
-}
-
-void snakeGame::send_json(json json_to_send) {
-    client_->send_json(json_to_send);
-    // Allows the client to send keystrokes again
-    should_update_ = true;
-}
-
-json snakeGame::receive_json() {
-    return client_->get_recent_json();
-}
-
+#include "ofApp.h"
+#include <iostream>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+
+using namespace snakelinkedlist;
+
+const char* snakelinkedlist::renderModeName(RenderMode mode) {
+    switch (mode) {
+        case RenderMode::BATCHED: return "batched";
+        case RenderMode::IMMEDIATE: return "immediate";
+        case RenderMode::DIRTY_CELLS: return "dirty cells";
+    }
+    return "?";
+}
+
+snakeGame::snakeGame(const LaunchOptions& options)
+    : options_(options), render_mode_(options.render_mode), camera_(options.arena_width, options.arena_height, 1200, 675) {
+}
+
+// Setup method
+void snakeGame::setup(){
+    ofSetWindowTitle("Snake126");
+    
+    srand(static_cast<unsigned>(time(0))); // Seed random with current time
+    
+    id_ = 5;
+    client_ = std::make_unique<GameClient>(id_, options_.arena_width, options_.arena_height);
+    client_->setInterpolationDelay(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(options_.interpolation_delay_ms)));
+    camera_.resize(ofGetWindowWidth(), ofGetWindowHeight());
+    
+    if (!options_.headless) {
+        setupFrameTimings();
+    }
+    
+    started_at_ = std::chrono::steady_clock::now();
+    last_report_ = started_at_;
+    next_autopilot_turn_ = started_at_;
+    autopilot_generator_.seed(static_cast<unsigned>(rand()));
+    
+    try {
+        if (!options_.share_name.empty()) {
+            client_->share(options_.share_name);
+        }
+        if (!options_.replay_path.empty()) {
+            client_->replay(options_.replay_path, options_.replay_speed);
+            if (options_.has_replay_seek) {
+                client_->seekReplay(options_.replay_seek, std::chrono::steady_clock::now());
+            }
+            return;
+        }
+        if (!options_.record_path.empty()) {
+            client_->record(options_.record_path);
+        }
+        client_->connect(networking::kIPADDRESS, networking::kPORT);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/*
+ Update function called before every draw
+ 1. Let the client pick up the newest world state and move our predicted snake, see GameClient::update()
+ 2. Move the camera towards our snake and tell the server which part of the board we need to hear about
+ 3. Rebuild the board mesh if anything on it changed or the camera sees past the cells the mesh has.
+    While interpolating, snakes slide between server states and the mesh changes every frame.
+    The dirty cell renderer paints only the cells that changed into its framebuffer instead.
+    Headless runs skip drawing entirely.
+ 4. Steer on autopilot and stop once the requested run time is up
+ */
+void snakeGame::update() {
+    auto now = std::chrono::steady_clock::now();
+    double frame_seconds = 0;
+    if (updates_ > 0) {
+        client_->profiler().add(FrameStage::FRAME, now - frame_start_);
+        frame_seconds = std::chrono::duration<double>(now - frame_start_).count();
+    }
+    frame_start_ = now;
+    bool changed = client_->update(now);
+    ++updates_;
+    followOwnSnake(frame_seconds);
+    CellRect visible = camera_.visibleCells();
+    updateInterest(visible);
+    
+    if (options_.headless) {
+        // Nothing gets drawn, so a state counts as presented as soon as the client has it
+        client_->framePresented(now);
+        reportHeadless(now);
+    } else {
+        // Half a screen to spare on every side, so the camera can pan a while before the next rebuild
+        CellRect margin = visible.grown(std::max(visible.right - visible.left, visible.bottom - visible.top) / 2);
+        if (client_->snapshot() && render_mode_ == RenderMode::DIRTY_CELLS) {
+            // Paints only the cells that changed, and nothing at all if none did
+            auto prep_start = std::chrono::steady_clock::now();
+            const CellRect& region = dirty_renderer_.region().contains(visible) ? dirty_renderer_.region() : margin;
+            if (dirty_renderer_.update(*client_->snapshot(), client_->previousSnapshot(), region, client_->predictedOwnSnake())) {
+                client_->profiler().add(FrameStage::DRAW_PREP, std::chrono::steady_clock::now() - prep_start);
+            }
+        } else if (client_->snapshot() && (changed || mesh_stale_ || !board_renderer_.region().contains(visible))) {
+            auto prep_start = std::chrono::steady_clock::now();
+            if (client_->interpolating()) {
+                board_renderer_.rebuild(client_->interpolated(), margin);
+            } else {
+                board_renderer_.rebuild(*client_->snapshot(), margin, client_->predictedOwnSnake());
+            }
+            mesh_stale_ = false;
+            client_->profiler().add(FrameStage::DRAW_PREP, std::chrono::steady_clock::now() - prep_start);
+        }
+        if (show_frame_timings_) {
+            refreshFrameTimings(now);
+        }
+    }
+    
+    if (options_.autopilot) {
+        steerAutopilot(now);
+    }
+    if (options_.run_seconds > 0
+        && std::chrono::duration<double>(now - started_at_).count() >= options_.run_seconds) {
+        ofExit();
+    }
+}
+
+/*
+ Draws the current state of the game with the following logic
+ 1. If the game is paused draw the pause screen
+ 2. If the game is finished draw the game over screen and final score
+ 3. Draw the current position of the food and of the snake, as one batched mesh, one rectangle per cell
+    in immediate mode or the dirty cell renderer's framebuffer, whichever F2 last picked
+ 4. Until the first world state arrives, and while reconnecting, say what the connection is doing
+ */
+void snakeGame::draw(){
+    if (options_.headless) {
+        return;
+    }
+    auto draw_start = std::chrono::steady_clock::now();
+    render_stats_.draw_calls = 0;
+    render_stats_.cells = 0;
+    render_stats_.board_cells = 0;
+    
+    // Wipes the background and then puts the snakes and food back onto it
+    ofColor background_color;
+    background_color.set(255, 255, 255);
+    ofClear(background_color);
+    if (client_->state() == GameState::FINISHED) {
+        drawGameOver();
+    }
+    if (render_mode_ == RenderMode::BATCHED) {
+        render_stats_.draw_calls += board_renderer_.draw(camera_);
+        render_stats_.cells = board_renderer_.cells();
+        render_stats_.board_cells = board_renderer_.boardCells();
+    } else if (render_mode_ == RenderMode::DIRTY_CELLS) {
+        // cells counts what the last change painted into the framebuffer, the frame itself is one quad
+        render_stats_.draw_calls += dirty_renderer_.draw(camera_);
+        render_stats_.cells = dirty_renderer_.cellsPainted();
+        render_stats_.board_cells = dirty_renderer_.boardCells();
+    } else {
+        drawFood();
+        drawSnakes();
+    }
+    drawConnectionStatus();
+    client_->framePresented(std::chrono::steady_clock::now());
+    auto draw_time = std::chrono::steady_clock::now() - draw_start;
+    client_->profiler().add(FrameStage::DRAW, draw_time);
+    
+    // Smooth the draw time a little so the number on screen is readable
+    double draw_ms = std::chrono::duration<double, std::milli>(draw_time).count();
+    render_stats_.draw_ms = 0.9 * render_stats_.draw_ms + 0.1 * draw_ms;
+    render_stats_.build_ms = render_mode_ == RenderMode::DIRTY_CELLS ? dirty_renderer_.paintMs() : board_renderer_.buildMs();
+    if (show_render_stats_) {
+        drawRenderStats();
+    }
+    if (show_frame_timings_) {
+        timings_panel_.draw();
+    }
+}
+
+/*
+ Function that handles actions based on user key presses
+ 1. if key == F12, toggle fullscreen
+ 2. if key == F1 toggle the rendering counters, if key == F2 go from batched to immediate to dirty cell rendering,
+    if key == F3 toggle the frame timings overlay, if key == F4 write the frame timings to CSV
+ 3. if key == [ or ] zoom out or in, the mouse wheel does the same, if key == , or . shorten or lengthen the
+    interpolation delay, down to 0 which draws the newest world state as it is
+ 4. if a recording is being replayed, the arrow keys seek and + and - double or halve the speed
+ 5. if game is in progress handle WASD action, sequence numbered for the predictor
+ 
+ WASD logic:
+ The client queues the direction with a sequence number for the io thread to send, and the predicted snake
+ takes the turn on its next step. Pressing the same key again before that step sends nothing.
+ Like the server, the prediction ignores a turn straight back into the snake's own neck.
+ */
+void snakeGame::keyPressed(int key){
+    //    if (key == OF_KEY_F12) {
+    //        ofToggleFullscreen();
+    //        return;
+    //    }
+    if (key == OF_KEY_F1) {
+        show_render_stats_ = !show_render_stats_;
+        return;
+    }
+    if (key == OF_KEY_F2) {
+        if (render_mode_ == RenderMode::BATCHED) {
+            render_mode_ = RenderMode::IMMEDIATE;
+        } else if (render_mode_ == RenderMode::IMMEDIATE) {
+            render_mode_ = RenderMode::DIRTY_CELLS;
+            dirty_renderer_.invalidate(); // The states it last painted may be long gone
+        } else {
+            render_mode_ = RenderMode::BATCHED;
+            mesh_stale_ = true;
+        }
+        return;
+    }
+    if (key == OF_KEY_F3) {
+        show_frame_timings_ = !show_frame_timings_;
+        return;
+    }
+    if (key == OF_KEY_F4) {
+        dumpFrameTimings();
+        return;
+    }
+    if (key == '[' || key == ']') {
+        camera_.zoom(key == ']' ? networking::kZoomStep : 1 / networking::kZoomStep);
+        return;
+    }
+    if (key == ',' || key == '.') {
+        auto delay = client_->interpolationDelay();
+        client_->setInterpolationDelay(key == '.' ? delay + networking::kInterpolationDelayStep
+                                       : std::max(std::chrono::steady_clock::duration::zero(), delay - networking::kInterpolationDelayStep));
+        std::cout << "Interpolation: " << client_->jitterBuffer().summary() << std::endl;
+        return;
+    }
+    
+    if (client_->replaying()) {
+        // A replay is not steered, the arrow keys seek and + and - change the speed
+        auto now = std::chrono::steady_clock::now();
+        uint64_t tick = client_->snapshot() ? client_->snapshot()->tick : 0;
+        if (key == OF_KEY_LEFT) {
+            client_->seekReplay(tick > networking::kReplaySeekStep ? tick - networking::kReplaySeekStep : 0, now);
+        } else if (key == OF_KEY_RIGHT) {
+            client_->seekReplay(tick + networking::kReplaySeekStep, now);
+        } else if (key == '+' || key == '=') {
+            client_->setReplaySpeed(client_->replaySpeed() * 2, now);
+        } else if (key == '-') {
+            client_->setReplaySpeed(client_->replaySpeed() / 2, now);
+        }
+        return;
+    }
+    
+    int upper_key = toupper(key); // Standardize on upper case
+    
+    // The client only sends turns while the game is in progress and respawns once it is over.
+    // The predicted snake turns on its next step instead of a round trip later.
+    if (upper_key == 'W' || upper_key == 'A' || upper_key == 'S' || upper_key == 'D') {
+        client_->steer(static_cast<char>(upper_key), std::chrono::steady_clock::now());
+    } else if (upper_key == 'R') {
+        client_->respawn();
+    }
+}
+
+void snakeGame::windowResized(int w, int h){
+    camera_.resize(w, h);
+}
+
+void snakeGame::mouseScrolled(int x, int y, float scrollX, float scrollY) {
+    if (scrollY != 0) {
+        camera_.zoom(scrollY > 0 ? networking::kZoomStep : 1 / networking::kZoomStep);
+    }
+}
+
+void snakeGame::followOwnSnake(double seconds) {
+    const snakejson::snake* own = client_->predictedOwnSnake();
+    if (!own && client_->snapshot()) {
+        for (const snakejson::snake& s : client_->snapshot()->snakes) {
+            if (s.id == static_cast<int>(id_) && s.alive) {
+                own = &s;
+                break;
+            }
+        }
+    }
+    // Without a snake of ours, such as while dead, the camera stays where it was
+    if (own && !own->coords.empty()) {
+        camera_.follow(own->coords.front(), seconds);
+    }
+}
+
+void snakeGame::updateInterest(const CellRect& visible) {
+    if (client_->replaying()) {
+        return;
+    }
+    // The mesh keeps half a screen around the view and the subscription a whole one, so the cells the mesh
+    // needs have always been subscribed to, and the camera moves a while before either has to change
+    int screen = std::max(visible.right - visible.left, visible.bottom - visible.top);
+    const CellRect* interest = client_->interest();
+    if (!interest || !interest->contains(visible.grown(screen / 2))) {
+        client_->setInterest(visible.grown(screen));
+    }
+}
+
+void snakeGame::drawFood() {
+    const WorldSnapshot* snapshot = client_->snapshot();
+    if (!snapshot) {
+        return;
+    }
+    // While interpolating the pellets come from the state the snakes are sliding towards
+    const std::vector<std::pair<int, int>>* food = &snapshot->food;
+    if (client_->interpolating() && client_->interpolated().food) {
+        food = client_->interpolated().food;
+    }
+    CellRect visible = camera_.visibleCells();
+    float cell_size = camera_.cellSize();
+    ofSetColor(ofColor(255,0,0));
+    for (const std::pair<int, int>& coords : *food) {
+        if (visible.contains(coords)) {
+            std::pair<float, float> corner = camera_.worldToScreen(coords);
+            ofDrawRectangle(corner.first, corner.second, cell_size, cell_size);
+            ++render_stats_.draw_calls;
+            ++render_stats_.cells;
+        }
+    }
+    render_stats_.board_cells += food->size();
+}
+
+void snakeGame::drawSnakes() {
+    const WorldSnapshot* snapshot = client_->snapshot();
+    if (!snapshot) {
+        return;
+    }
+    CellRect visible = camera_.visibleCells();
+    float cell_size = camera_.cellSize();
+    if (client_->interpolating()) {
+        const InterpolatedFrame& frame = client_->interpolated();
+        for (std::size_t i = 0; i < frame.snake_count; ++i) {
+            const InterpolatedSnake& s = frame.snakes[i];
+            ofSetColor(ofColor(s.color[0], s.color[1], s.color[2]));
+            for (const std::pair<float, float>& corner : s.coords) {
+                // Segments between cells are drawn if either cell they overlap is visible
+                if (corner.first > visible.left - 1 && corner.first < visible.right
+                    && corner.second > visible.top - 1 && corner.second < visible.bottom) {
+                    ofDrawRectangle(camera_.offsetX() + corner.first * cell_size, camera_.offsetY() + corner.second * cell_size,
+                                    cell_size, cell_size);
+                    ++render_stats_.draw_calls;
+                    ++render_stats_.cells;
+                }
+            }
+            render_stats_.board_cells += s.coords.size();
+        }
+        return;
+    }
+    const snakejson::snake* predicted = client_->predictedOwnSnake();
+    for (const snakejson::snake& s : snapshot->snakes) {
+        const std::vector<std::pair<int, int>>& coords = (predicted && predicted->id == s.id) ? predicted->coords : s.coords;
+        
+        // Set color here
+        int red = s.color.at(0);
+        int green = s.color.at(1);
+        int blue = s.color.at(2);
+        
+        ofSetColor(ofColor(red, green, blue));
+        for (const std::pair<int, int>& coord : coords) {
+            if (visible.contains(coord)) {
+                std::pair<float, float> corner = camera_.worldToScreen(coord);
+                ofDrawRectangle(corner.first, corner.second, cell_size, cell_size);
+                ++render_stats_.draw_calls;
+                ++render_stats_.cells;
+            }
+        }
+        render_stats_.board_cells += coords.size();
+    }
+}
+
+void snakeGame::drawRenderStats() {
+    char line[192];
+    std::snprintf(line, sizeof(line), "%s: %d draw calls, %zu of %zu cells, %.0f px cells, mesh build %.2f ms, draw %.2f ms, %.0f fps",
+                  renderModeName(render_mode_), render_stats_.draw_calls, render_stats_.cells,
+                  render_stats_.board_cells, camera_.cellSize(), render_stats_.build_ms, render_stats_.draw_ms, ofGetFrameRate());
+    ofSetColor(0, 0, 0);
+    ofDrawBitmapString(line, 10, 20);
+    ofDrawBitmapString("prediction: " + client_->predictor().summary(), 10, 36);
+    ofDrawBitmapString("interpolation: " + client_->jitterBuffer().summary(), 10, 52);
+    std::snprintf(line, sizeof(line), "stream: %.2f messages per read, %llu stale states dropped (%llu in the same read, %llu between frames)",
+                  client_->messagesPerRead(), static_cast<unsigned long long>(client_->statesDropped()),
+                  static_cast<unsigned long long>(client_->statesSuperseded()),
+                  static_cast<unsigned long long>(client_->statesSkipped()));
+    ofDrawBitmapString(line, 10, 68);
+    if (render_mode_ == RenderMode::DIRTY_CELLS) {
+        std::snprintf(line, sizeof(line), "framebuffer: %llu partial and %llu full repaints, the last %zu cells in %.2f ms",
+                      static_cast<unsigned long long>(dirty_renderer_.partialRepaints()),
+                      static_cast<unsigned long long>(dirty_renderer_.fullRepaints()), dirty_renderer_.cellsPainted(),
+                      dirty_renderer_.paintMs());
+        ofDrawBitmapString(line, 10, 84);
+    }
+}
+
+void snakeGame::setupFrameTimings() {
+    ofxGuiSetDefaultWidth(420);
+    timings_panel_.setup("Frame timings: p50 / p99 / p999 / max ms");
+    timings_panel_.setPosition(10, 50);
+    for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+        timings_panel_.add(timings_labels_[i].setup(frameStageName(static_cast<FrameStage>(i)), ""));
+    }
+    timings_panel_.add(ack_latency_label_.setup("input ack", ""));
+    timings_panel_.add(dump_timings_button_.setup("Write CSV (F4)"));
+    timings_panel_.add(reset_timings_button_.setup("Reset"));
+    dump_timings_button_.addListener(this, &snakeGame::dumpFrameTimings);
+    reset_timings_button_.addListener(this, &snakeGame::resetFrameTimings);
+}
+
+void snakeGame::refreshFrameTimings(std::chrono::steady_clock::time_point now) {
+    if (now < next_timings_refresh_) {
+        return;
+    }
+    next_timings_refresh_ = now + networking::kFrameTimingsRefreshEvery;
+    auto format = [](const LatencyHistogram& histogram) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%.2f / %.2f / %.2f / %.2f (n=%llu)", histogram.percentileMs(0.5),
+                      histogram.percentileMs(0.99), histogram.percentileMs(0.999), histogram.maxMs(),
+                      static_cast<unsigned long long>(histogram.count()));
+        return std::string(line);
+    };
+    const FrameProfiler& profiler = client_->profiler();
+    for (std::size_t i = 0; i < kFrameStageCount; ++i) {
+        timings_labels_[i] = format(profiler.stage(static_cast<FrameStage>(i)));
+    }
+    ack_latency_label_ = format(client_->ackLatency());
+}
+
+void snakeGame::dumpFrameTimings() {
+    std::string path = ofToDataPath("frame_timings_" + ofGetTimestampString("%Y%m%d-%H%M%S") + ".csv");
+    if (client_->profiler().writeCsv(path)) {
+        std::cout << "Frame timings written to " << path << std::endl;
+    } else {
+        std::cerr << "Could not write frame timings to " << path << std::endl;
+    }
+}
+
+void snakeGame::resetFrameTimings() {
+    client_->profiler().reset();
+}
+
+void snakeGame::drawConnectionStatus() {
+    ConnectionState state = client_->connectionState();
+    bool waiting_for_state = !client_->snapshot();
+    if (client_->replaying() || (state == ConnectionState::CONNECTED && !waiting_for_state)) {
+        return;
+    }
+    std::string status;
+    if (state == ConnectionState::CONNECTED) {
+        status = "Connected, waiting for the first world state";
+    } else {
+        status = std::string(waiting_for_state ? "Connecting to " : "Reconnecting to ") + networking::kIPADDRESS + ":"
+            + networking::kPORT + " (" + connectionStateName(state);
+        if (client_->connectionFailures() > 0) {
+            status += ", attempt " + std::to_string(client_->connectionFailures() + 1);
+        }
+        status += ")";
+    }
+    ofSetColor(0, 0, 0);
+    if (waiting_for_state) {
+        ofDrawBitmapString(status, ofGetWindowWidth() / 2 - 4 * static_cast<int>(status.size()), ofGetWindowHeight() / 2);
+    } else {
+        ofDrawBitmapString(status, 10, ofGetWindowHeight() - 10);
+    }
+}
+
+void snakeGame::drawGameOver() {
+    string total_food = std::to_string(client_->score());
+    string lose_message = "You Lost! Final Score: " + total_food;
+    ofSetColor(0, 0, 0);
+    ofDrawBitmapString(lose_message, ofGetWindowWidth() / 2, ofGetWindowHeight() / 2);
+}
+
+void snakeGame::exit() {
+    if (!options_.timings_csv_path.empty()) {
+        client_->profiler().writeCsv(options_.timings_csv_path);
+    }
+    if (options_.headless) {
+        reportHeadless(std::chrono::steady_clock::now(), true);
+        std::cout << "Prediction: " << client_->predictor().summary() << std::endl;
+        std::cout << "Interpolation: " << client_->jitterBuffer().summary() << std::endl;
+        std::cout << "Input latency: " << client_->inputLatency().summary() << std::endl;
+        StartupTimes startup = client_->startupTimes();
+        std::cout << "Startup: connected after " << startup.connected_ms << " ms, first world state after "
+                  << startup.first_state_ms << " ms, first frame after " << startup.first_frame_ms << " ms" << std::endl;
+        std::cout << "Input-to-ack latency: " << client_->ackLatency().summary() << " (" << client_->commandsSent()
+                  << " sent, " << client_->commandsCoalesced() << " coalesced, " << client_->commandsDropped()
+                  << " dropped)" << std::endl;
+    }
+    client_->stop();
+}
+
+void snakeGame::steerAutopilot(std::chrono::steady_clock::time_point now) {
+    // Uncapped headless loops run thousands of updates a second, one key press per interval is plenty
+    if (now < next_autopilot_turn_) {
+        return;
+    }
+    next_autopilot_turn_ = now + networking::kAutopilotTurnEvery;
+    if (client_->state() == GameState::FINISHED) {
+        client_->respawn();
+    } else {
+        client_->steer("WASD"[autopilot_generator_() % 4], now);
+    }
+}
+
+void snakeGame::reportHeadless(std::chrono::steady_clock::time_point now, bool force) {
+    if (!force && now - last_report_ < networking::kHeadlessReportEvery) {
+        return;
+    }
+    double seconds = std::chrono::duration<double>(now - last_report_).count();
+    if (seconds <= 0) {
+        return;
+    }
+    std::printf("Headless: %.0f updates/s, %.1f states/s, %llu stale states dropped (%llu in the same read), %.2f messages per read\n",
+                (updates_ - updates_at_report_) / seconds, (client_->statesTaken() - states_at_report_) / seconds,
+                static_cast<unsigned long long>(client_->statesDropped()),
+                static_cast<unsigned long long>(client_->statesSuperseded()), client_->messagesPerRead());
+    updates_at_report_ = updates_;
+    states_at_report_ = client_->statesTaken();
+    last_report_ = now;
+}
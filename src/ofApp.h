@@ -1,116 +1,156 @@
-#ifndef OFAPP_H
-#define OFAPP_H
-#pragma once
-#include <ctime>
-#include <cstdlib>
-#include <utility>
-#include <vector>
-#include <unordered_map>
-#include <boost/asio.hpp>
-#include "chat_client.hpp"
-#include <thread>
-#include <memory>
-
-#include "json.hpp"
-#include "ofMain.h"
-
-namespace snakelinkedlist {
-    
-    namespace snakejson {
-        
-        // Used to define how we will parse out the snake from JSON
-        struct snake {
-            int id;
-            int length;
-            bool alive;
-            std::string direction;
-            std::array<int, 3> color;
-            std::vector<std::pair<int, int>> coords;
-        };
-        
-        // Allows the snakes to be parsed out into snake structs easily
-        void from_json(const nlohmann::json& j, snakejson::snake& s);
-    }
-    
-    // Enum to represent the current state of the game
-    enum class GameState {
-        IN_PROGRESS = 0,
-        FINISHED
-    };
-    
-    class snakeGame : public ofBaseApp {
-    private:
-        
-        std::vector<std::pair<int, int>> food_loc_;
-        std::vector<snakejson::snake> snake_vec_;
-        
-        snakejson::snake our_snake_;
-        
-        int current_size_;
-        bool alive_;
-        ofColor color_;
-        uint32_t id_;
-        int num_food_eaten_;
-        
-        // The json we wish to send to the server
-        nlohmann::json json_to_send_;
-        
-        // Start us off as alive
-        GameState current_state_ = GameState::IN_PROGRESS; // The current state of the game, used to determine possible actions
-        
-//        bool should_update_ = true;     // A flag boolean used in the update() function. Due to the frame dependent animation we've
-        // written, and the relatively low framerate, a bug exists where users can prefire direction
-        // changes faster than a frame update. Our solution is to force a call to update on direction
-        // changes and then not update on the next frame to prevent the snake from skipping across the screen.
-        
-        
-        // Private helper methods to render various aspects of the game on screen.
-        void drawFood();
-        void drawSnakes();
-        void drawGameOver();
-        
-        // Resets the game objects to their original state.
-        void reset();
-        
-        // sends the JSON to the server through the chat_client
-        void send_json(nlohmann::json json_to_send);
-        
-        // Gets the most recent JSON from the server
-        nlohmann::json receive_json();
-        
-        // Creates unique pointers for the networking things so we can refer to them
-        std::unique_ptr<boost::asio::io_context> io_context_;
-        std::unique_ptr<chat_client> client_;
-        std::unique_ptr<thread> thread_;
-        
-        // Allows us to use the keyboard and the stuff will be sent
-        bool should_update_ = true;
-        
-        // Used to time the duration between when we're receiving the json
-        // to ensure the we can read the server while the sockets are still on
-        std::chrono::duration<double> elapsed_;
-        std::chrono::high_resolution_clock::time_point start_;
-        std::chrono::high_resolution_clock::time_point finish_;
-        
-        
-    public:
-        // Function used for one time setup
-        void setup();
-        
-        // Main event loop functions called on every frame
-        void update();
-        void draw();
-        
-        // Event driven functions, called on appropriate user action
-        void keyPressed(int key);
-        void windowResized(int w, int h);
-    };
-} // namespace snakelinkedlist
-
-namespace networking {
-    // Where we are connecting to
-    const std::string kIPADDRESS("127.0.0.1");
-    const std::string kPORT("49145");
-    
-}
-#endif
+#ifndef OFAPP_H
+#define OFAPP_H
+#pragma once
+#include <ctime>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <string>
+#include <array>
+
+#include "ofMain.h"
+#include "ofxGui.h"
+#include "game_client.h"
+#include "board_renderer.h"
+#include "dirty_cell_renderer.h"
+
+namespace snakelinkedlist {
+    
+    // How the board is drawn, F2 goes through them in this order
+    enum class RenderMode {
+        BATCHED, // One mesh for the whole board, see BoardRenderer
+        IMMEDIATE, // One rectangle per cell, for comparison
+        DIRTY_CELLS // A persistent framebuffer in which only changed cells are painted, see DirtyCellRenderer
+    };
+    
+    const char* renderModeName(RenderMode mode);
+    
+    // How main() was asked to run the game
+    struct LaunchOptions {
+        bool headless = false; // No window and no drawing, update() runs as fast as it can
+        double run_seconds = 0; // Exit after this long, 0 runs until closed
+        bool autopilot = false; // Steer at random and respawn on our own, for runs without a keyboard
+        std::string record_path; // Record every world state received to this file
+        std::string replay_path; // Play this recording instead of connecting to a server
+        std::string share_name; // Publish every world state to other local processes in shared memory of this name
+        double replay_speed = 1; // 1 to 100 times real time
+        bool has_replay_seek = false;
+        uint64_t replay_seek = 0; // Tick to start the replay at
+        std::string timings_csv_path; // Write the frame stage timings here on exit
+        int arena_width = 48; // Size of the server's board in cells, the default fills the window at the default zoom
+        int arena_height = 27;
+        RenderMode render_mode = RenderMode::BATCHED;
+        double interpolation_delay_ms = 250; // How far behind the newest world state the board is drawn, 0 turns interpolation off
+    };
+    
+    class snakeGame : public ofBaseApp {
+    private:
+        LaunchOptions options_;
+        
+        // The connection, world model and our predicted snake. Everything that is not drawing lives there.
+        std::unique_ptr<GameClient> client_;
+        
+        // Draws the client's snapshot as a single mesh, rebuilt whenever it changes, which is every frame
+        // while snakes slide between two interpolated states
+        BoardRenderer board_renderer_;
+        // Keeps the board in a framebuffer and paints only the cells that changed, rebuilt when the state changes
+        DirtyCellRenderer dirty_renderer_;
+        RenderMode render_mode_ = RenderMode::BATCHED; // F2 switches between the renderers for comparison
+        bool mesh_stale_ = false; // The board mesh was not kept up to date while the dirty cell renderer was in use
+        bool show_render_stats_ = false; // F1 shows draw calls and frame time in the corner
+        RenderStats render_stats_;
+        
+        // Follows our snake around arenas bigger than the window, [ and ] or the mouse wheel zoom
+        Camera camera_;
+        
+        // F3 shows where each frame's time goes, one row of percentiles per FrameStage
+        bool show_frame_timings_ = false;
+        ofxPanel timings_panel_;
+        std::array<ofxLabel, kFrameStageCount> timings_labels_;
+        ofxLabel ack_latency_label_; // Key press to the server's acknowledgement, next to the frame stages
+        ofxButton dump_timings_button_;
+        ofxButton reset_timings_button_;
+        std::chrono::steady_clock::time_point next_timings_refresh_;
+        std::chrono::steady_clock::time_point frame_start_; // Start of the previous update(), for the frame stage
+        
+        uint32_t id_;
+        
+        std::chrono::steady_clock::time_point started_at_;
+        std::chrono::steady_clock::time_point next_autopilot_turn_;
+        std::mt19937 autopilot_generator_;
+        
+        // Headless loop counters, reported every few seconds and on exit
+        uint64_t updates_ = 0;
+        uint64_t updates_at_report_ = 0;
+        uint64_t states_at_report_ = 0;
+        std::chrono::steady_clock::time_point last_report_;
+        
+        // Private helper methods to render various aspects of the game on screen.
+        void drawFood();
+        void drawSnakes();
+        void drawGameOver();
+        void drawConnectionStatus(); // Connecting and reconnecting, in place of or on top of the board
+        void drawRenderStats();
+        
+        // Moves the camera towards our snake's head, seconds after the last frame
+        void followOwnSnake(double seconds);
+        
+        // Subscribes to a screen's margin around what the camera sees once it gets near the edge of the last subscription
+        void updateInterest(const CellRect& visible);
+        
+        // Builds the frame timings overlay, and copies the histograms into it every now and then
+        void setupFrameTimings();
+        void refreshFrameTimings(std::chrono::steady_clock::time_point now);
+        
+        // Writes the frame stage histograms to a timestamped CSV file in the data folder, or clears them
+        void dumpFrameTimings();
+        void resetFrameTimings();
+        
+        // Presses a random direction now and then and asks for a new snake when ours dies
+        void steerAutopilot(std::chrono::steady_clock::time_point now);
+        
+        // Prints how fast the headless loop is going, every few seconds unless forced
+        void reportHeadless(std::chrono::steady_clock::time_point now, bool force = false);
+        
+    public:
+        explicit snakeGame(const LaunchOptions& options = LaunchOptions());
+        
+        // Function used for one time setup
+        void setup();
+        
+        // Main event loop functions called on every frame
+        void update();
+        void draw();
+        void exit();
+        
+        // Event driven functions, called on appropriate user action
+        void keyPressed(int key);
+        void windowResized(int w, int h);
+        void mouseScrolled(int x, int y, float scrollX, float scrollY);
+    };
+} // namespace snakelinkedlist
+
+namespace networking {
+    // Print the headless loop rate this often
+    const std::chrono::seconds kHeadlessReportEvery(5);
+    
+    // Autopilot presses a direction key this often
+    const std::chrono::milliseconds kAutopilotTurnEvery(500);
+    
+    // The frame timings overlay copies the histograms this often, they change too quickly to read every frame
+    const std::chrono::milliseconds kFrameTimingsRefreshEvery(250);
+    
+    // The arrow keys move a replay this many ticks back or forward
+    const uint64_t kReplaySeekStep = 50;
+    
+    // One press of [ or ] and one notch of the mouse wheel zoom by this much
+    const float kZoomStep = 1.25f;
+    
+    // One press of , or . shortens or lengthens the interpolation delay by this much
+    const std::chrono::milliseconds kInterpolationDelayStep(25);
+}
+#endif
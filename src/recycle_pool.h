@@ -0,0 +1,63 @@
+#ifndef RECYCLE_POOL_H
+#define RECYCLE_POOL_H
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace snakelinkedlist {
+
+    /*
+     Keeps a few retired objects around so the next one does not have to be allocated.
+     Meant for large objects that cycle between threads, like world snapshots going from the io thread to the
+     render thread and back: the render thread recycles the snapshot it stops showing and the io thread fills
+     it in again, reusing every buffer inside it. Holding at most Capacity objects, in a fixed array, means the
+     pool itself never allocates. The lock is only held to move a pointer in or out.
+     */
+    template <typename T, std::size_t Capacity = 4>
+    class RecyclePool {
+    private:
+        std::mutex mutex_;
+        std::array<std::unique_ptr<T>, Capacity> free_;
+        std::size_t free_count_ = 0; // Guarded by mutex_
+        uint64_t created_ = 0; // Guarded by mutex_
+
+    public:
+        RecyclePool() = default;
+        RecyclePool(const RecyclePool&) = delete;
+        RecyclePool& operator=(const RecyclePool&) = delete;
+
+        // A recycled object with its old contents, or a new one if none are left
+        std::unique_ptr<T> acquire() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (free_count_ > 0) {
+                    return std::move(free_[--free_count_]);
+                }
+                ++created_;
+            }
+            return std::unique_ptr<T>(new T());
+        }
+
+        // Takes an object back for reuse. Null is ignored, and so is anything beyond Capacity, which is freed.
+        void recycle(std::unique_ptr<T> value) {
+            if (!value) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_count_ < Capacity) {
+                free_[free_count_++] = std::move(value);
+            }
+        }
+
+        // How many objects acquire() had to allocate, stops going up once the pool is warm
+        uint64_t created() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return created_;
+        }
+    };
+} // namespace snakelinkedlist
+
+#endif
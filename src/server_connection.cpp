@@ -0,0 +1,220 @@
+#include "server_connection.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace snakelinkedlist;
+using boost::asio::ip::tcp;
+
+const std::size_t ServerConnection::kHeaderLength;
+const std::size_t ServerConnection::kMaxBodyLength;
+const std::size_t ServerConnection::kLongHeaderLength;
+
+const char* snakelinkedlist::connectionStateName(ConnectionState state) {
+    switch (state) {
+        case ConnectionState::RESOLVING: return "resolving";
+        case ConnectionState::CONNECTING: return "connecting";
+        case ConnectionState::HANDSHAKING: return "handshaking";
+        case ConnectionState::CONNECTED: return "connected";
+        case ConnectionState::WAITING: return "waiting to retry";
+        case ConnectionState::CLOSED: return "closed";
+        default: return "?";
+    }
+}
+
+ServerConnection::ServerConnection(boost::asio::io_context& io_context, const std::string& host, const std::string& port,
+                                   MessageHandler on_message, ConnectHandler on_connected, BatchHandler on_batch)
+    : strand_(io_context), socket_(io_context), resolver_(io_context), retry_timer_(io_context), host_(host), port_(port),
+      on_message_(std::move(on_message)), on_connected_(std::move(on_connected)), on_batch_(std::move(on_batch)),
+      jitter_(std::random_device()()) {
+}
+
+ServerConnection::ServerConnection(boost::asio::io_context& io_context, const tcp::resolver::results_type& endpoints,
+                                   MessageHandler on_message, ConnectHandler on_connected, BatchHandler on_batch)
+    : strand_(io_context), socket_(io_context), resolver_(io_context), retry_timer_(io_context), endpoints_(endpoints),
+      on_message_(std::move(on_message)), on_connected_(std::move(on_connected)), on_batch_(std::move(on_batch)),
+      jitter_(std::random_device()()) {
+}
+
+void ServerConnection::start() {
+    boost::asio::post(strand_, [this]() { doResolve(); });
+}
+
+void ServerConnection::send(const nlohmann::json& message) {
+    std::string body = message.dump();
+    std::string framed;
+    if (!frameMessage(body, long_frames_.load(), framed)) {
+        std::cerr << "Message of " << body.size() << " bytes is too long to send" << std::endl;
+        return;
+    }
+
+    boost::asio::post(strand_, [this, framed]() {
+        // Whatever is sent while we are not connected would reach a server that knows nothing of it
+        ConnectionState state = state_.load();
+        if (state != ConnectionState::HANDSHAKING && state != ConnectionState::CONNECTED) {
+            return;
+        }
+        bool idle = writes_.empty();
+        writes_.push_back(framed);
+        if (idle) {
+            writeNext(session_);
+        }
+    });
+}
+
+void ServerConnection::reconnect() {
+    boost::asio::post(strand_, [this]() {
+        ConnectionState state = state_.load();
+        if (state != ConnectionState::CLOSED && state != ConnectionState::WAITING) {
+            retryLater("the server asked us to reconnect");
+        }
+    });
+}
+
+void ServerConnection::close() {
+    boost::asio::post(strand_, [this]() {
+        state_.store(ConnectionState::CLOSED);
+        ++session_;
+        boost::system::error_code ignored;
+        retry_timer_.cancel(ignored);
+        resolver_.cancel();
+        socket_.close(ignored);
+        writes_.clear();
+    });
+}
+
+void ServerConnection::retryLater(const std::string& reason) {
+    ++session_;
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    writes_.clear();
+    state_.store(ConnectionState::WAITING);
+    uint32_t failures = failures_.fetch_add(1) + 1;
+
+    // Somewhere between half and all of the current backoff, which doubles for the next failure
+    std::uniform_int_distribution<long long> pick(backoff_.count() / 2, backoff_.count());
+    std::chrono::milliseconds delay(pick(jitter_));
+    backoff_ = std::min(backoff_ * 2, kReconnectMaxDelay);
+    std::cerr << "Server connection: " << reason << ", retrying in " << delay.count() << " ms (attempt "
+              << failures + 1 << ")" << std::endl;
+
+    uint64_t session = session_;
+    retry_timer_.expires_after(delay);
+    retry_timer_.async_wait(boost::asio::bind_executor(strand_, [this, session](const boost::system::error_code& error) {
+        if (error || session != session_) {
+            return;
+        }
+        doResolve();
+    }));
+}
+
+void ServerConnection::doResolve() {
+    if (host_.empty()) {
+        doConnect();
+        return;
+    }
+    state_.store(ConnectionState::RESOLVING);
+    uint64_t session = session_;
+    resolver_.async_resolve(host_, port_, boost::asio::bind_executor(strand_,
+        [this, session](const boost::system::error_code& error, const tcp::resolver::results_type& endpoints) {
+            if (session != session_) {
+                return;
+            }
+            if (error) {
+                retryLater("could not resolve " + host_ + ": " + error.message());
+                return;
+            }
+            endpoints_ = endpoints;
+            doConnect();
+        }));
+}
+
+void ServerConnection::doConnect() {
+    state_.store(ConnectionState::CONNECTING);
+    uint64_t session = session_;
+    boost::asio::async_connect(socket_, endpoints_, boost::asio::bind_executor(strand_,
+        [this, session](const boost::system::error_code& error, const tcp::endpoint&) {
+            if (session != session_) {
+                return;
+            }
+            if (error) {
+                retryLater("could not connect: " + error.message());
+                return;
+            }
+            state_.store(ConnectionState::HANDSHAKING);
+            decoder_.reset(); // Whatever was left of a message from the last connection never arrives
+            long_frames_.store(false); // Until this server answers our HELLO
+            if (on_connected_) {
+                on_connected_();
+            }
+            read(session);
+        }));
+}
+
+void ServerConnection::read(uint64_t session) {
+    std::pair<char*, std::size_t> space = decoder_.prepare();
+    socket_.async_read_some(boost::asio::buffer(space.first, space.second), boost::asio::bind_executor(strand_,
+                            [this, session](const boost::system::error_code& error, std::size_t size) {
+                                if (session != session_) {
+                                    return;
+                                }
+                                if (error) {
+                                    retryLater("lost the connection: " + error.message());
+                                    return;
+                                }
+                                decoder_.commit(size);
+                                reads_.fetch_add(1, std::memory_order_relaxed);
+                                if (deliver(session)) {
+                                    read(session);
+                                }
+                            }));
+}
+
+bool ServerConnection::deliver(uint64_t session) {
+    const char* data;
+    std::size_t size;
+    bool delivered = false;
+    for (;;) {
+        FrameDecoder::Result result = decoder_.next(data, size);
+        if (result == FrameDecoder::Result::BAD_HEADER) {
+            retryLater("bad message header from the server");
+            return false;
+        }
+        if (result == FrameDecoder::Result::INCOMPLETE) {
+            break;
+        }
+        // The server is talking to us, the next failure starts the backoff over
+        if (state_.load() == ConnectionState::HANDSHAKING) {
+            state_.store(ConnectionState::CONNECTED);
+            failures_.store(0);
+            backoff_ = kReconnectInitialDelay;
+        }
+        messages_.fetch_add(1, std::memory_order_relaxed);
+        delivered = true;
+        on_message_(data, size);
+        if (session != session_) {
+            return false;
+        }
+    }
+    if (delivered && on_batch_) {
+        on_batch_();
+    }
+    return session == session_;
+}
+
+void ServerConnection::writeNext(uint64_t session) {
+    boost::asio::async_write(socket_, boost::asio::buffer(writes_.front()), boost::asio::bind_executor(strand_,
+                             [this, session](const boost::system::error_code& error, std::size_t) {
+                                 if (session != session_) {
+                                     return;
+                                 }
+                                 if (error) {
+                                     retryLater("lost the connection: " + error.message());
+                                     return;
+                                 }
+                                 writes_.pop_front();
+                                 if (!writes_.empty()) {
+                                     writeNext(session);
+                                 }
+                             }));
+}
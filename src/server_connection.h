@@ -0,0 +1,133 @@
+#ifndef SERVER_CONNECTION_H
+#define SERVER_CONNECTION_H
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <string>
+
+#include <boost/asio.hpp>
+#include "frame_decoder.h"
+#include "json.hpp"
+
+namespace snakelinkedlist {
+
+    // The first retry after losing the connection comes after about kReconnectInitialDelay, every failure in a row
+    // doubles the delay up to kReconnectMaxDelay. Each actual delay is picked at random between half and all of
+    // that, so many clients dropped at once do not all come back in the same instant.
+    const std::chrono::milliseconds kReconnectInitialDelay(100);
+    const std::chrono::milliseconds kReconnectMaxDelay(5000);
+
+    enum class ConnectionState {
+        RESOLVING = 0, // Looking up the server's address
+        CONNECTING, // Waiting for the TCP connection
+        HANDSHAKING, // Connected, waiting for the server's first message
+        CONNECTED, // The server has sent something, messages are flowing
+        WAITING, // Could not connect or lost the connection, waiting out the backoff before trying again
+        CLOSED // close() was called, nothing happens any more
+    };
+
+    const char* connectionStateName(ConnectionState state);
+
+    /*
+     Our connection to the game server.
+     Messages are framed like chat_message.hpp: a 4 character decimal body length followed by the body.
+     Unlike chat_client, which only kept the most recent JSON around for us to poll, every complete message
+     is handed to a callback on the io_context thread as raw bytes, so world states can be decoded as soon
+     as they arrive and can be binary as well as JSON. Each read takes whatever the socket has, and a
+     FrameDecoder splits it into messages where they lie. Once every message a read completed has been
+     handed out, the batch callback runs, so a client that only cares about the newest state can skip the
+     work for the ones the same read superseded.
+     Every handler runs on the connection's own strand, so one io_context can be run by several threads
+     and serve many connections at once. The callbacks for one connection never run concurrently.
+     Nothing blocks: the address is resolved asynchronously, and whenever connecting fails or the connection
+     drops it goes back through RESOLVING and CONNECTING after a backoff, until close() is called.
+     */
+    class ServerConnection {
+    public:
+        typedef std::function<void(const char* data, std::size_t size)> MessageHandler;
+        typedef std::function<void()> ConnectHandler;
+        typedef std::function<void()> BatchHandler;
+
+        static const std::size_t kHeaderLength = FrameDecoder::kHeaderLength;
+        static const std::size_t kMaxBodyLength = FrameDecoder::kMaxBodyLength;
+        static const std::size_t kLongHeaderLength = FrameDecoder::kLongHeaderLength;
+
+    private:
+        boost::asio::io_context::strand strand_; // Serializes this connection's handlers
+        boost::asio::ip::tcp::socket socket_;
+        boost::asio::ip::tcp::resolver resolver_;
+        boost::asio::steady_timer retry_timer_;
+        std::string host_; // Empty if we were given the endpoints, which are then never resolved again
+        std::string port_;
+        boost::asio::ip::tcp::resolver::results_type endpoints_;
+        MessageHandler on_message_; // Called on the io thread for every complete message
+        ConnectHandler on_connected_; // Called on the io thread once the socket is connected
+        BatchHandler on_batch_; // Called on the io thread after the messages of each read, may be empty
+
+        FrameDecoder decoder_; // Strand only
+        std::deque<std::string> writes_; // Framed messages waiting to be written, io thread only
+
+        std::atomic<ConnectionState> state_{ConnectionState::RESOLVING};
+        std::atomic<uint32_t> failures_{0}; // Connection attempts that failed in a row, or dropped before any message
+        std::chrono::milliseconds backoff_ = kReconnectInitialDelay; // Strand only
+        std::minstd_rand jitter_; // Strand only
+        std::atomic<uint64_t> messages_{0};
+        std::atomic<uint64_t> reads_{0};
+        std::atomic<bool> long_frames_{false}; // The server reads long headers, until the next connect
+
+        // Goes up every time the socket is given up on. Handlers carry the session they were started in
+        // and do nothing once it is over, so an aborted read does not tear down the connection after it.
+        uint64_t session_ = 0;
+
+        void doResolve();
+        void doConnect();
+        void read(uint64_t session);
+        // Hands out every whole message the last read completed, returns false if the connection was given up
+        bool deliver(uint64_t session);
+        void writeNext(uint64_t session);
+
+        // Closes the socket and schedules the next attempt after the backoff, strand only
+        void retryLater(const std::string& reason);
+
+    public:
+        // Resolves host and port again before every attempt
+        ServerConnection(boost::asio::io_context& io_context, const std::string& host, const std::string& port,
+                         MessageHandler on_message, ConnectHandler on_connected, BatchHandler on_batch = nullptr);
+
+        // Connects to endpoints resolved up front, for the load generator's thousands of connections
+        ServerConnection(boost::asio::io_context& io_context,
+                         const boost::asio::ip::tcp::resolver::results_type& endpoints,
+                         MessageHandler on_message, ConnectHandler on_connected, BatchHandler on_batch = nullptr);
+
+        // Starts connecting. The handlers may run on another thread before this returns, so call it once
+        // whatever they use, including the pointer to this connection, is in place.
+        // on_connected runs again after every reconnect.
+        void start();
+
+        // Sends a message to the server. Safe to call from any thread.
+        void send(const nlohmann::json& message);
+
+        // The server answered our HELLO offer of kFrameLongName, messages longer than kMaxBodyLength can go to
+        // it with a long header. Safe to call from any thread. Every new connection starts without.
+        void allowLongFrames() { long_frames_.store(true); }
+
+        // Drops the current socket and connects again after the backoff. Safe to call from any thread.
+        void reconnect();
+
+        // Closes the socket and stops reconnecting, which lets io_context::run() return once nothing else is pending
+        void close();
+
+        // Safe to call from any thread
+        ConnectionState state() const { return state_.load(std::memory_order_relaxed); }
+        uint32_t failures() const { return failures_.load(std::memory_order_relaxed); }
+        uint64_t messagesReceived() const { return messages_.load(std::memory_order_relaxed); }
+        uint64_t reads() const { return reads_.load(std::memory_order_relaxed); } // Reads that returned any bytes
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,122 @@
+#include "shared_world.h"
+#include <cstring>
+#include <new>
+#include <sstream>
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include "wire_codec.h"
+
+using namespace snakelinkedlist;
+namespace ipc = boost::interprocess;
+
+namespace {
+    const std::size_t kCacheLine = 64;
+
+    std::size_t slotStride(std::size_t slot_bytes) {
+        return (sizeof(SharedSlotHeader) + slot_bytes + kCacheLine - 1) / kCacheLine * kCacheLine;
+    }
+
+    int64_t steadyNanos(std::chrono::steady_clock::time_point at) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count();
+    }
+} // namespace
+
+SharedWorldWriter::SharedWorldWriter(const std::string& name, uint32_t own_id, std::size_t slots, std::size_t slot_bytes)
+    : name_(name), stride_(slotStride(slot_bytes)) {
+    if (slots == 0) {
+        throw SharedWorldError("A shared world needs at least one slot");
+    }
+    try {
+        // Whatever a client that crashed left behind under this name goes, readers of it have to attach again
+        ipc::shared_memory_object::remove(name.c_str());
+        ipc::shared_memory_object memory(ipc::create_only, name.c_str(), ipc::read_write);
+        memory.truncate(static_cast<ipc::offset_t>(kCacheLine + slots * stride_));
+        region_ = ipc::mapped_region(memory, ipc::read_write);
+    } catch (ipc::interprocess_exception& e) {
+        throw SharedWorldError("Cannot create shared world " + name + ": " + e.what());
+    }
+
+    char* base = static_cast<char*>(region_.get_address());
+    header_ = new (base) SharedWorldHeader;
+    header_->ready.store(0, std::memory_order_relaxed);
+    std::memcpy(header_->magic, kSharedWorldMagic, kSharedWorldMagicLength);
+    header_->slots = static_cast<uint32_t>(slots);
+    header_->own_id = own_id;
+    header_->slot_bytes = slot_bytes;
+    header_->published.store(0, std::memory_order_relaxed);
+    slots_ = base + kCacheLine;
+    for (std::size_t i = 0; i < slots; ++i) {
+        SharedSlotHeader* slot = new (slots_ + i * stride_) SharedSlotHeader;
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->size = 0;
+    }
+    header_->ready.store(kSharedWorldReady, std::memory_order_release);
+}
+
+SharedWorldWriter::~SharedWorldWriter() {
+    ipc::shared_memory_object::remove(name_.c_str());
+}
+
+bool SharedWorldWriter::publish(const WorldSnapshot& snapshot) {
+    auto start = std::chrono::steady_clock::now();
+    encoded_.clear();
+    encodeKeyframe(snapshot, encoded_);
+    if (encoded_.size() > header_->slot_bytes) {
+        ++too_large_;
+        return false;
+    }
+
+    SharedSlotHeader& slot = *reinterpret_cast<SharedSlotHeader*>(slots_ + (published_ % header_->slots) * stride_);
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // The odd sequence is seen before anything below
+    slot.tick = snapshot.tick;
+    slot.published_ns = steadyNanos(std::chrono::steady_clock::now());
+    slot.size = encoded_.size();
+    std::memcpy(reinterpret_cast<char*>(&slot) + sizeof(SharedSlotHeader), encoded_.data(), encoded_.size());
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+
+    header_->published.store(++published_, std::memory_order_release);
+    publish_time_ += std::chrono::steady_clock::now() - start;
+    return true;
+}
+
+std::string SharedWorldWriter::summary() const {
+    std::ostringstream out;
+    out << published_ << " world states to " << name_ << " (" << too_large_ << " too large), "
+        << (published_ ? std::chrono::duration<double, std::micro>(publish_time_).count() / published_ : 0)
+        << " us each";
+    return out.str();
+}
+
+SharedWorldReader::SharedWorldReader(const std::string& name) {
+    try {
+        ipc::shared_memory_object memory(ipc::open_only, name.c_str(), ipc::read_only);
+        region_ = ipc::mapped_region(memory, ipc::read_only);
+    } catch (ipc::interprocess_exception& e) {
+        throw SharedWorldError("Cannot open shared world " + name + ": " + e.what());
+    }
+
+    const char* base = static_cast<const char*>(region_.get_address());
+    if (region_.get_size() < kCacheLine) {
+        throw SharedWorldError(name + " is not a shared world");
+    }
+    header_ = reinterpret_cast<const SharedWorldHeader*>(base);
+    if (header_->ready.load(std::memory_order_acquire) != kSharedWorldReady) {
+        throw SharedWorldError(name + " is not a shared world, or its writer has not finished creating it");
+    }
+    if (std::memcmp(header_->magic, kSharedWorldMagic, kSharedWorldMagicLength) != 0) {
+        throw SharedWorldError(name + " is not a shared world");
+    }
+    stride_ = slotStride(header_->slot_bytes);
+    if (header_->slots == 0 || region_.get_size() < kCacheLine + header_->slots * stride_) {
+        throw SharedWorldError(name + " is smaller than its header says");
+    }
+    slots_ = base + kCacheLine;
+}
+
+SharedWorldReader::Result SharedWorldReader::readLatest(WorldSnapshot& snapshot) {
+    return readLatest([&snapshot](const char* data, std::size_t size, uint64_t, int64_t) {
+        decodeKeyframe(data, size, snapshot);
+    });
+}
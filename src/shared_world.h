@@ -0,0 +1,194 @@
+#ifndef SHARED_WORLD_H
+#define SHARED_WORLD_H
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <boost/interprocess/mapped_region.hpp>
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    /*
+     Fans the client's world states out to other processes on the same machine, so spectator displays,
+     recorders and bots can share one connection and one parse instead of each talking to the server.
+     The client writes every state it publishes into a named shared memory ring, and any number of readers
+     map it read-only and pick up the newest state whenever they like. Nobody ever waits on anybody:
+       header   "SNAKSHM1", u32 ready, u32 slots, u32 own snake id, u64 bytes per slot, u64 states published so far
+       slots    u64 sequence, u64 tick, i64 steady clock nanoseconds when published, u64 size, body
+     The writer sets ready last, with a release store, and readers only trust the rest after loading it.
+     Each body is a keyframe in the binary wire format (wire_codec.h). The newest state is in slot
+     (published - 1) % slots. Every slot is a seqlock: the sequence is odd while the writer is in it, and a
+     reader that sees the same even sequence before and after looking knows nobody wrote while it did.
+     Readers decode straight out of the shared memory. Only a reader so slow that the writer goes around the
+     whole ring while it decodes one state has to try again.
+     Slots start on a cache line of their own and are reused in turn, so the writer is not in the slot a
+     reader of the newest state is in until slots more states have been published.
+     */
+    const char kSharedWorldMagic[] = "SNAKSHM1";
+    const std::size_t kSharedWorldMagicLength = 8;
+    const std::size_t kSharedWorldSlots = 8;
+    const std::size_t kSharedWorldSlotBytes = 1 << 20; // Enough for a 1000x1000 board with a few thousand snakes
+    const int kSharedWorldReadAttempts = 3;
+    const uint32_t kSharedWorldReady = 1;
+
+    // Atomics in shared memory are only atomic between processes if they are lock free. The macros are per
+    // builtin type, so check the one uint64_t and uint32_t actually are.
+    static_assert((sizeof(uint64_t) == sizeof(long) ? ATOMIC_LONG_LOCK_FREE : ATOMIC_LLONG_LOCK_FREE) == 2,
+                  "Seqlock sequences in shared memory must be lock free");
+    static_assert((sizeof(uint32_t) == sizeof(int) ? ATOMIC_INT_LOCK_FREE : ATOMIC_LONG_LOCK_FREE) == 2,
+                  "The ready flag in shared memory must be lock free");
+
+    // Thrown when the shared memory cannot be created or opened, or is not a shared world
+    class SharedWorldError : public std::runtime_error {
+    public:
+        explicit SharedWorldError(const std::string& what) : std::runtime_error(what) {}
+    };
+
+    struct SharedWorldHeader {
+        char magic[kSharedWorldMagicLength];
+        std::atomic<uint32_t> ready; // kSharedWorldReady once everything else is written, a reader that sees it can trust the rest
+        uint32_t slots;
+        uint32_t own_id; // The publishing client's snake
+        uint64_t slot_bytes;
+        std::atomic<uint64_t> published;
+    };
+
+    struct SharedSlotHeader {
+        std::atomic<uint64_t> sequence;
+        uint64_t tick;
+        int64_t published_ns;
+        uint64_t size;
+    };
+
+    /*
+     The one process that publishes, the client. The shared memory is created with the given name, replacing
+     one left behind by a client that crashed, and removed again when the writer is destroyed. Readers that
+     still have it mapped keep what they have but see nothing new, they have to attach again.
+     */
+    class SharedWorldWriter {
+    private:
+        std::string name_;
+        boost::interprocess::mapped_region region_;
+        SharedWorldHeader* header_;
+        char* slots_;
+        std::size_t stride_;
+        std::string encoded_; // Reused from one state to the next
+
+        uint64_t published_ = 0;
+        uint64_t too_large_ = 0;
+        std::chrono::steady_clock::duration publish_time_{0};
+
+    public:
+        // Throws SharedWorldError
+        SharedWorldWriter(const std::string& name, uint32_t own_id, std::size_t slots = kSharedWorldSlots,
+                          std::size_t slot_bytes = kSharedWorldSlotBytes);
+        ~SharedWorldWriter();
+
+        SharedWorldWriter(const SharedWorldWriter&) = delete;
+        SharedWorldWriter& operator=(const SharedWorldWriter&) = delete;
+
+        // Writes snapshot into the next slot. Returns false, and publishes nothing, if it does not fit a slot.
+        bool publish(const WorldSnapshot& snapshot);
+
+        const std::string& name() const { return name_; }
+        uint64_t published() const { return published_; }
+        uint64_t tooLarge() const { return too_large_; }
+        std::string summary() const;
+    };
+
+    /*
+     A process that reads what the client publishes. Maps the shared memory read-only, so a reader can't
+     disturb the client or the other readers.
+     */
+    class SharedWorldReader {
+    public:
+        enum class Result {
+            STATE, // The newest state was read
+            NOTHING_NEW, // Nothing has been published since the last read
+            TORN // The writer kept overwriting the state while it was read, try again later
+        };
+
+    private:
+        boost::interprocess::mapped_region region_;
+        const SharedWorldHeader* header_;
+        const char* slots_;
+        std::size_t stride_;
+
+        uint64_t last_ = 0; // header_->published when the last state was read
+        uint64_t read_ = 0;
+        uint64_t missed_ = 0; // Published states that were never read, a newer one was there first
+        uint64_t torn_ = 0;
+
+        const SharedSlotHeader& slot(uint64_t index) const {
+            return *reinterpret_cast<const SharedSlotHeader*>(slots_ + (index % header_->slots) * stride_);
+        }
+
+    public:
+        // Throws SharedWorldError if there is no shared world of that name, or it is not ready yet
+        explicit SharedWorldReader(const std::string& name);
+
+        /*
+         Calls f(data, size, tick, published_ns) with the newest state's body where it lies in shared memory.
+         f may be called more than once if the writer got in the way, and what it got only counts if this
+         returns STATE, so it should only fill in something the caller looks at afterwards. If f throws while
+         the state was being overwritten the read is retried, otherwise the exception is passed on.
+         */
+        template <typename F>
+        Result readLatest(F&& f);
+
+        // Decodes the newest state into snapshot, which is only whole if this returns STATE. Throws
+        // WireFormatError if the state is not a keyframe.
+        Result readLatest(WorldSnapshot& snapshot);
+
+        uint32_t ownId() const { return header_->own_id; }
+        uint64_t published() const { return header_->published.load(std::memory_order_acquire); }
+        uint64_t read() const { return read_; }
+        uint64_t missed() const { return missed_; }
+        uint64_t torn() const { return torn_; }
+    };
+
+    template <typename F>
+    SharedWorldReader::Result SharedWorldReader::readLatest(F&& f) {
+        for (int attempt = 0; attempt < kSharedWorldReadAttempts; ++attempt) {
+            uint64_t published = header_->published.load(std::memory_order_acquire);
+            if (published == last_) {
+                return Result::NOTHING_NEW;
+            }
+            const SharedSlotHeader& newest = slot(published - 1);
+            uint64_t before = newest.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // Only if the writer went around the ring since published was read
+            }
+            const char* body = reinterpret_cast<const char*>(&newest) + sizeof(SharedSlotHeader);
+            bool valid;
+            try {
+                f(body, static_cast<std::size_t>(std::min<uint64_t>(newest.size, header_->slot_bytes)), newest.tick,
+                  newest.published_ns);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                valid = newest.sequence.load(std::memory_order_relaxed) == before;
+            } catch (...) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (newest.sequence.load(std::memory_order_relaxed) == before) {
+                    throw;
+                }
+                valid = false;
+            }
+            if (valid) {
+                missed_ += read_ > 0 ? published - last_ - 1 : 0; // What came before attaching doesn't count
+                last_ = published;
+                ++read_;
+                return Result::STATE;
+            }
+        }
+        ++torn_;
+        return Result::TORN;
+    }
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include "sim_engine.h"
+
+namespace snakelinkedlist {
+
+    namespace {
+
+        GridCell stepFrom(const GridCell& cell, char direction) {
+            switch (direction) {
+                case 'W': return GridCell{cell.x, cell.y - 1};
+                case 'S': return GridCell{cell.x, cell.y + 1};
+                case 'A': return GridCell{cell.x - 1, cell.y};
+                default: return GridCell{cell.x + 1, cell.y};
+            }
+        }
+
+        bool opposite(char a, char b) {
+            return (a == 'W' && b == 'S') || (a == 'S' && b == 'W') || (a == 'A' && b == 'D') || (a == 'D' && b == 'A');
+        }
+
+        bool isDirection(char action) {
+            return action == 'W' || action == 'A' || action == 'S' || action == 'D';
+        }
+
+        std::pair<int, int> toPair(const GridCell& cell) {
+            return std::make_pair(cell.x, cell.y);
+        }
+
+        // FNV-1a, one 64 bit value at a time
+        void mix(uint64_t& hash, uint64_t value) {
+            for (int byte = 0; byte < 8; ++byte) {
+                hash ^= (value >> (byte * 8)) & 0xFF;
+                hash *= 1099511628211ULL;
+            }
+        }
+    } // namespace
+
+    snakejson::snake toSchema(const SimSnake& s) {
+        snakejson::snake out;
+        out.id = s.id;
+        out.length = s.length;
+        out.alive = s.alive;
+        out.direction = std::string(1, s.direction);
+        out.color = s.color;
+        out.coords.reserve(s.body.size());
+        for (const GridCell& cell : s.body) {
+            out.coords.push_back(toPair(cell));
+        }
+        return out;
+    }
+
+    SimEngine::SimEngine(const SimOptions& options)
+        : options_(options), generator_(options.seed),
+          grid_(std::max(options.width, 0), std::max(options.height, 0), true) {
+        options_.width = grid_.width();
+        options_.height = grid_.height();
+        options_.snakes = std::min(std::max(options_.snakes, 0), static_cast<int>(OccupancyGrid::kWall) - 1);
+        options_.food = std::max(options_.food, 0);
+        food_at_.assign(static_cast<std::size_t>(options_.width) * options_.height, -1);
+
+        std::uniform_int_distribution<> channel(0, 255);
+        snakes_.resize(options_.snakes);
+        for (int id = 1; id <= options_.snakes; ++id) {
+            SimSnake& s = snakes_[id - 1];
+            s.id = id;
+            s.color = {{channel(generator_), channel(generator_), channel(generator_)}};
+        }
+        for (SimSnake& s : snakes_) {
+            spawn(s);
+        }
+        addFood();
+        delta_entry_.assign(snakes_.size() + 1, -1);
+    }
+
+    void SimEngine::command(int id, char action) {
+        if (id < 1 || id > static_cast<int>(snakes_.size())) {
+            return;
+        }
+        SimSnake& s = snakes_[id - 1];
+        s.steered = true;
+        if (action == 'R' && !s.alive) {
+            s.respawn_requested = true;
+        } else if (s.alive && isDirection(action) && !opposite(action, s.direction)) {
+            s.direction = action;
+        }
+    }
+
+    bool SimEngine::placeFood(std::size_t pellet) {
+        GridCell cell;
+        if (!grid_.randomFreeCell(generator_, cell)) {
+            return false;
+        }
+        grid_.reserve(cell);
+        food_[pellet] = toPair(cell);
+        food_at_[cellIndex(cell)] = static_cast<int>(pellet);
+        return true;
+    }
+
+    void SimEngine::addFood() {
+        while (static_cast<int>(food_.size()) < options_.food) {
+            food_.emplace_back();
+            if (!placeFood(food_.size() - 1)) {
+                food_.pop_back();
+                return;
+            }
+            delta_.has_food = true;
+        }
+    }
+
+    // The last pellet takes the removed one's place
+    void SimEngine::removeFood(std::size_t pellet) {
+        std::size_t last = food_.size() - 1;
+        if (pellet != last) {
+            food_[pellet] = food_[last];
+            food_at_[cellIndex(GridCell{food_[pellet].first, food_[pellet].second})] = static_cast<int>(pellet);
+        }
+        food_.pop_back();
+    }
+
+    void SimEngine::spawn(SimSnake& s) {
+        GridCell start;
+        if (!grid_.randomFreeCell(generator_, start)) {
+            // No room on the board, try again later
+            s.alive = false;
+            s.respawn_in = options_.respawn_ticks;
+            return;
+        }
+        s.body.clear();
+        s.body.pushHead(start);
+        grid_.occupy(start, static_cast<OccupancyGrid::Owner>(s.id));
+        s.direction = "WASD"[generator_() % 4];
+        s.alive = true;
+        s.length = 1;
+        s.respawn_requested = false;
+
+        SnakeDelta entry;
+        entry.id = s.id;
+        entry.direction = std::string(1, s.direction);
+        entry.has_body = true;
+        entry.color = s.color;
+        entry.body.push_back(toPair(start));
+        delta_.snakes.push_back(entry);
+    }
+
+    void SimEngine::step(SimSnake& s) {
+        // Snakes nobody steers wander, turning now and then
+        if (!s.steered && generator_() % 8 == 0) {
+            char turn = "WASD"[generator_() % 4];
+            if (!opposite(turn, s.direction)) {
+                s.direction = turn;
+            }
+        }
+
+        SnakeDelta entry;
+        entry.id = s.id;
+        entry.direction = std::string(1, s.direction);
+        GridCell head = stepFrom(s.body.head(), s.direction);
+        // Off the board reads as a wall, so claiming the cell checks walls and every snake at once
+        if (!grid_.occupy(head, static_cast<OccupancyGrid::Owner>(s.id))) {
+            for (const GridCell& cell : s.body) {
+                grid_.release(cell, static_cast<OccupancyGrid::Owner>(s.id));
+            }
+            s.alive = false;
+            s.respawn_in = options_.respawn_ticks;
+            entry.died = true;
+            delta_.snakes.push_back(entry);
+            return;
+        }
+
+        s.body.pushHead(head);
+        entry.has_head = true;
+        entry.head = toPair(head);
+        int& pellet = food_at_[cellIndex(head)];
+        if (pellet >= 0) {
+            // The pellet's cell is the head's now. A new pellet goes elsewhere, if there is anywhere.
+            std::size_t eaten = static_cast<std::size_t>(pellet);
+            pellet = -1;
+            if (!placeFood(eaten)) {
+                removeFood(eaten);
+            }
+            entry.grown = true;
+            ++s.length;
+            delta_.has_food = true;
+        } else {
+            grid_.release(s.body.tail(), static_cast<OccupancyGrid::Owner>(s.id));
+            s.body.popTail();
+            entry.tail = 1;
+        }
+        delta_.snakes.push_back(entry);
+    }
+
+    void SimEngine::tick() {
+        ++tick_;
+        // Cleared rather than replaced, so a running world stops allocating for its delta
+        delta_.tick = tick_;
+        delta_.has_food = false;
+        delta_.food.clear();
+        delta_.snakes.clear();
+
+        for (SimSnake& s : snakes_) {
+            if (s.alive) {
+                step(s);
+            } else if (s.steered ? s.respawn_requested : --s.respawn_in <= 0) {
+                // Steered snakes wait for their client to press R, the rest come back on their own
+                spawn(s);
+            }
+        }
+        // Pellets that found no room when they were eaten come back once some has opened up
+        addFood();
+        if (delta_.has_food) {
+            delta_.food = food_;
+        }
+
+        std::fill(delta_entry_.begin(), delta_entry_.end(), -1);
+        for (std::size_t i = 0; i < delta_.snakes.size(); ++i) {
+            delta_entry_[delta_.snakes[i].id] = static_cast<int>(i);
+        }
+    }
+
+    WorldSnapshot SimEngine::keyframe() const {
+        WorldSnapshot keyframe;
+        keyframe.tick = tick_;
+        keyframe.food = food_;
+        keyframe.snakes.reserve(snakes_.size());
+        for (const SimSnake& s : snakes_) {
+            keyframe.snakes.push_back(toSchema(s));
+        }
+        return keyframe;
+    }
+
+    uint64_t SimEngine::checksum() const {
+        uint64_t hash = 14695981039346656037ULL;
+        mix(hash, tick_);
+        for (const SimSnake& s : snakes_) {
+            mix(hash, static_cast<uint64_t>(s.id) << 32 | static_cast<uint64_t>(s.length) << 8 | (s.alive ? 1 : 0));
+            mix(hash, static_cast<uint64_t>(s.direction));
+            for (const GridCell& cell : s.body) {
+                mix(hash, static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) << 32 | static_cast<uint32_t>(cell.y));
+            }
+        }
+        for (const std::pair<int, int>& pellet : food_) {
+            mix(hash, static_cast<uint64_t>(static_cast<uint32_t>(pellet.first)) << 32 | static_cast<uint32_t>(pellet.second));
+        }
+        return hash;
+    }
+
+} // namespace snakelinkedlist
@@ -0,0 +1,102 @@
+#ifndef SIM_ENGINE_H
+#define SIM_ENGINE_H
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "occupancy_grid.h"
+#include "snakebody.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    struct SimOptions {
+        int width = 48;
+        int height = 27;
+        int snakes = 8; // Ids 1 to snakes, at most OccupancyGrid::kWall - 1
+        int food = 5; // Pellets kept on the board while there is room for them
+        int respawn_ticks = 10; // How long a snake nobody steers stays dead
+        unsigned seed = 1;
+    };
+
+    // One snake of the simulation, in the terms of the world schema
+    struct SimSnake {
+        int id = 0;
+        std::array<int, 3> color;
+        SnakeBodyRing body; // Head first
+        char direction = 'D'; // W, A, S or D
+        bool alive = false;
+        int length = 1;
+        int respawn_in = 0;
+        bool respawn_requested = false;
+        bool steered = false; // Somebody sent a command for this snake, stop moving it randomly
+    };
+
+    /*
+     A snake world that runs without a server, a window or a clock, for standing in for the server and for tests.
+     Time is a tick count and nothing else: tick() moves every live snake one cell, however fast it is called.
+     Every random choice comes from one generator seeded from SimOptions::seed, and snakes always move in id
+     order, so the same seed and the same commands before the same ticks give the same world every run, on
+     the same standard library. checksum() makes two runs easy to compare.
+     Bodies are SnakeBodyRings on one OccupancyGrid that tracks its free cells, so a step is O(1) per snake and
+     placing food or respawning is O(1) however crowded the board is. Each tick is recorded as a WorldDelta,
+     and keyframe() gives the whole world, both in the schema the client reads.
+     */
+    class SimEngine {
+    private:
+        SimOptions options_;
+        std::mt19937 generator_;
+        std::vector<SimSnake> snakes_; // snakes_[id - 1]
+        std::vector<std::pair<int, int>> food_;
+        std::vector<int> food_at_; // By row major cell, index of the pellet in food_ or -1
+        OccupancyGrid grid_; // Which live snake is in each cell, and which cells are free for spawns and food
+        uint64_t tick_ = 0;
+
+        WorldDelta delta_; // Everything that changed during the last tick
+        std::vector<int> delta_entry_; // Index of each snake's entry in delta_ by id, -1 if it has none
+
+        std::size_t cellIndex(const GridCell& cell) const {
+            return static_cast<std::size_t>(cell.y) * options_.width + cell.x;
+        }
+
+        bool placeFood(std::size_t pellet); // Moves food_[pellet] to a free cell, false if there is none
+        void addFood(); // Puts pellets on the board until there are options_.food or no room
+        void removeFood(std::size_t pellet);
+        void spawn(SimSnake& s);
+        void step(SimSnake& s);
+
+    public:
+        explicit SimEngine(const SimOptions& options);
+
+        // Steers snake id with W, A, S or D, or asks for it to respawn with R. Takes effect on the next tick.
+        // Unknown ids and actions are ignored.
+        void command(int id, char action);
+
+        void tick(); // Advances the world by one step
+
+        uint64_t tickNumber() const { return tick_; }
+        const SimOptions& options() const { return options_; }
+        const std::vector<SimSnake>& snakes() const { return snakes_; }
+        const std::vector<std::pair<int, int>>& food() const { return food_; }
+
+        const WorldDelta& delta() const { return delta_; } // What the last tick changed
+        // What changed about one snake in the last tick, nullptr if nothing did
+        const SnakeDelta* deltaFor(int id) const {
+            int entry = (id >= 0 && static_cast<std::size_t>(id) < delta_entry_.size()) ? delta_entry_[id] : -1;
+            return entry < 0 ? nullptr : &delta_.snakes[entry];
+        }
+
+        WorldSnapshot keyframe() const; // The whole world as it is now
+        uint64_t checksum() const; // Hash of the tick, every body, direction and pellet
+    };
+
+    // The snake as the world schema has it
+    snakejson::snake toSchema(const SimSnake& s);
+
+} // namespace snakelinkedlist
+#endif
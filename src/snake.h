@@ -1,66 +1,59 @@
-#ifndef SNAKE_H
-#define SNAKE_H
-#pragma once
-#include <list>
-#include "ofMain.h"
-#include "snakebody.h"
-
-
-namespace snakelinkedlist {
-    
-    // Enum that represents all possible directions that the snake can be moving
-    typedef enum {
-        UP = 0,
-        DOWN,
-        RIGHT,
-        LEFT
-    } SnakeDirection;
-    
-    /*
-     Node that represents a segment of the snake body.
-     This is due to the limitations of ll
-     1. We can only place a specific type of node in the ll
-     2. ll provides no convenient way to update the data in a list
-     We could expose the internal structure of the list but
-     the underlying data and implementation of a data structure
-     is meant to be private and exposing it is a critical sin.
-     A linked list that had an iterator interface would remedy this issue
-     */
-    struct SnakeBody { // TODO replace with templated ll
-        SnakeBody* next;
-        ofVec2f position;
-        ofColor color;
-    };
-    
-    class Snake {
-    private:
-        SnakeDirection current_direction_; // The current direction of the snake
-        ofVec2f screen_dims_; // The current screen dimensions (needed to calculate values on resize()
-        static const float kbody_size_modifier_; // The proportion of the screen width a body square is
-        ofVec2f body_size_; // the size of a snake body piece based on kbody_size_modifier_
-        SnakeBody* head_; // The head of the linked list, we are forced to do this because snakebody
-        // does not support all of the data we must keep track of
-        
-        std::list<int> snake_body; // our linked list implementation, we might as well use it to keep track of score
-        // But ideally it should store all of the information of our snake once it is improved
-        
-    public:
-        SnakeBody* getHead() const; //TODO remove this once iterators are added (publicly exposes snakes internal structure :'()
-        Snake(); // Default constructor, initializes and places length 1 snake
-        Snake& operator=(const Snake& other); // copy constructor
-        ~Snake(); // destructor
-        ofVec2f getBodySize() const; // gets the size of a body segment, used for rendering
-        bool isDead() const; // Determines if the current state of the snake is dead
-        void update(); // updates the snake one body square in the current direction
-        void eatFood(ofColor new_body_color); // the snake has eaten a food while travelling in a certain direction.
-        void resize(int w, int h); // Resizes the snake to a new width and height
-        int getFoodEaten() const; // Gets the number of food items the snake has eaten
-        SnakeDirection getDirection() const; // Gets the Snake's current direction
-        void setDirection(SnakeDirection new_direction); // Sets the Snake's direction
-        //    static ofColor kColor_(0, 100, 0);
-    };
-} // namespace snakelinkedlist
-
-
-
-#endif
+#ifndef SNAKE_H
+#define SNAKE_H
+#pragma once
+#include <vector>
+#include "ofMain.h"
+#include "grid_snake.h"
+
+
+namespace snakelinkedlist {
+
+    /*
+     One segment of the snake body as seen from outside the snake.
+     The body itself lives in a SnakeBodyRing of grid cells, segments are built on the fly by the iterator
+     so nothing about how the body is stored leaks out of the class.
+     */
+    struct SnakeSegment {
+        GridCell cell; // Where the segment is on the board
+        ofVec2f position; // Top left corner of the segment on screen, in pixels
+        ofColor color;
+    };
+
+    // A GridSnake with what it takes to draw it: the size of a body square on screen and a color per segment
+    class Snake : public GridSnake {
+    private:
+        ofVec2f screen_dims_; // The current screen dimensions (needed to calculate values on resize()
+        static const float kbody_size_modifier_; // The proportion of the screen width a body square is
+        ofVec2f body_size_; // the size of a snake body piece based on kbody_size_modifier_
+        std::vector<ofColor> colors_; // Color of each segment counted from the head, colors stay put while cells move
+
+    public:
+        // Walks the snake from head to tail, yielding a SnakeSegment for each body square
+        class const_iterator {
+        private:
+            const Snake* snake_;
+            std::size_t index_;
+
+        public:
+            const_iterator(const Snake* snake, std::size_t index) : snake_(snake), index_(index) {}
+            SnakeSegment operator*() const;
+            const_iterator& operator++() { ++index_; return *this; }
+            friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) { return lhs.index_ != rhs.index_; }
+        };
+
+        Snake(OccupancyGrid& grid, OccupancyGrid::Owner id, GridCell start = GridCell{0, 2}); // Places a length 1 snake on the shared board, call resize() before drawing it
+        Snake(Snake&& other) = default;
+        Snake& operator=(Snake&& other) = default;
+        const_iterator begin() const; // Iterator at the head of the snake
+        const_iterator end() const; // Iterator one past the tail of the snake
+        ofVec2f getBodySize() const; // gets the size of a body segment, used for rendering
+        void eatFood(ofColor new_body_color); // the snake has eaten a food while travelling in a certain direction.
+        void resize(int w, int h); // Resizes the snake to a new width and height
+        void rewind(const std::vector<GridCell>& cells, SnakeDirection direction); // Replaces the whole body, head first, with a known good one
+        //    static ofColor kColor_(0, 100, 0);
+    };
+} // namespace snakelinkedlist
+
+
+
+#endif
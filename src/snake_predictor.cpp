@@ -0,0 +1,232 @@
+#include "snake_predictor.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    // Snake ids from the server are 32 bit, the grid only has room for 16 bit owners
+    OccupancyGrid::Owner ownerFor(uint32_t id) {
+        return static_cast<OccupancyGrid::Owner>(std::max<uint32_t>(1, std::min<uint32_t>(id, OccupancyGrid::kWall - 1)));
+    }
+
+    bool toDirection(char action, SnakeDirection& direction) {
+        switch (action) {
+            case 'W': direction = UP; return true;
+            case 'S': direction = DOWN; return true;
+            case 'A': direction = LEFT; return true;
+            case 'D': direction = RIGHT; return true;
+            default: return false;
+        }
+    }
+
+    char toAction(SnakeDirection direction) {
+        switch (direction) {
+            case UP: return 'W';
+            case DOWN: return 'S';
+            case LEFT: return 'A';
+            default: return 'D';
+        }
+    }
+
+    // The server ignores a turn straight back into the snake's own neck, so the prediction does too
+    bool opposite(SnakeDirection a, SnakeDirection b) {
+        return (a == UP && b == DOWN) || (a == DOWN && b == UP) || (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT);
+    }
+} // namespace
+
+SnakePredictor::SnakePredictor(int board_width, int board_height, uint32_t own_id)
+    : own_id_(own_id), grid_(board_width, board_height), snake_(grid_, ownerFor(own_id), GridCell{0, 0}) {
+    stats_.tick_interval_ms = std::chrono::duration<double, std::milli>(tick_interval_).count();
+}
+
+void SnakePredictor::pressed(char action, uint64_t seq, std::chrono::steady_clock::time_point now) {
+    PendingInput input;
+    input.seq = seq;
+    input.action = action;
+    input.tick = predicted_tick_;
+    input.pressed_at = now;
+    pending_.push_back(input);
+}
+
+bool SnakePredictor::redundant(char action) const {
+    return !pending_.empty() && pending_.back().action == action && pending_.back().tick == predicted_tick_;
+}
+
+void SnakePredictor::reconcile(const WorldSnapshot& snapshot) {
+    // Measure how often the server ticks, prediction steps at the same rate
+    if (has_base_ && snapshot.tick > base_tick_ && snapshot.received_at > base_received_at_) {
+        auto sample = (snapshot.received_at - base_received_at_) / static_cast<int>(snapshot.tick - base_tick_);
+        tick_interval_ = std::max<std::chrono::steady_clock::duration>((tick_interval_ * 4 + sample) / 5,
+                                                                       std::chrono::milliseconds(1));
+        stats_.tick_interval_ms = std::chrono::duration<double, std::milli>(tick_interval_).count();
+    }
+    has_base_ = true;
+    base_tick_ = snapshot.tick;
+    base_received_at_ = snapshot.received_at;
+
+    // The newest acknowledged input tells us the round trip, if we still remember when it was pressed
+    for (const PendingInput& input : pending_) {
+        if (input.seq == snapshot.acked_input && snapshot.acked_at >= input.pressed_at) {
+            auto sample = snapshot.acked_at - input.pressed_at;
+            round_trip_ = (round_trip_ == std::chrono::steady_clock::duration::zero()) ? sample : (round_trip_ * 4 + sample) / 5;
+            stats_.round_trip_ms = std::chrono::duration<double, std::milli>(round_trip_).count();
+            break;
+        }
+    }
+
+    // Inputs that were applied before the rewind and will be applied again by the replay
+    std::size_t dropped = 0;
+    while (dropped < pending_.size()
+           && (pending_[dropped].seq <= snapshot.acked_input
+               || snapshot.received_at - pending_[dropped].pressed_at > kInputAckTimeout)) {
+        ++dropped;
+    }
+    if (next_input_ > dropped) {
+        stats_.replayed_inputs += next_input_ - dropped;
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + dropped);
+
+    const snakejson::snake* own = nullptr;
+    for (const snakejson::snake& s : snapshot.snakes) {
+        if (static_cast<uint32_t>(s.id) == own_id_) {
+            own = &s;
+            break;
+        }
+    }
+    if (!own || !own->alive || own->coords.empty()) {
+        // Nothing to predict until we respawn, and nothing sent before then steered this snake
+        active_ = false;
+        pending_.clear();
+        history_size_ = 0;
+        next_input_ = 0;
+        predicted_tick_ = snapshot.tick;
+        return;
+    }
+
+    if (active_) {
+        scorePrediction(snapshot.tick, *own);
+    }
+    history_size_ = 0;
+    ++stats_.reconciles;
+
+    // Rewind to the server's snake, the next advance() replays whatever the server has not seen yet.
+    // Everybody else's cells from the last state go first, so rewinding never runs into a stale one.
+    for (const std::pair<GridCell, OccupancyGrid::Owner>& cell : others_) {
+        grid_.release(cell.first, cell.second);
+    }
+    others_.clear();
+    base_body_.clear();
+    for (const std::pair<int, int>& coord : own->coords) {
+        base_body_.push_back(GridCell{coord.first, coord.second});
+    }
+    SnakeDirection direction = snake_.getDirection();
+    if (!own->direction.empty()) {
+        toDirection(own->direction[0], direction);
+    }
+    snake_.rewind(base_body_, direction);
+
+    // Everybody else stays where the server last put them
+    for (const snakejson::snake& s : snapshot.snakes) {
+        if (&s == own || !s.alive) {
+            continue;
+        }
+        OccupancyGrid::Owner owner = ownerFor(static_cast<uint32_t>(s.id));
+        for (const std::pair<int, int>& coord : s.coords) {
+            GridCell cell{coord.first, coord.second};
+            if (grid_.occupy(cell, owner)) {
+                others_.emplace_back(cell, owner);
+            }
+        }
+    }
+    predicted_tick_ = snapshot.tick;
+    next_input_ = 0;
+    active_ = true;
+
+    predicted_ = *own;
+}
+
+bool SnakePredictor::advance(std::chrono::steady_clock::time_point now) {
+    if (!active_ || now < base_received_at_) {
+        return false;
+    }
+    // The tick the server will be on when an input sent now gets there
+    uint64_t lead = static_cast<uint64_t>((now - base_received_at_ + round_trip_) / tick_interval_);
+    uint64_t target = base_tick_ + std::min<uint64_t>(lead, kMaxPredictedTicks);
+    if (predicted_tick_ >= target) {
+        return false;
+    }
+    while (predicted_tick_ < target) {
+        step();
+    }
+    updatePredicted();
+    return true;
+}
+
+void SnakePredictor::step() {
+    // Inputs pressed while this tick was on screen steer the move to the next one, in the order they were pressed
+    while (next_input_ < pending_.size() && pending_[next_input_].tick <= predicted_tick_) {
+        SnakeDirection direction;
+        if (toDirection(pending_[next_input_].action, direction) && !opposite(direction, snake_.getDirection())) {
+            snake_.setDirection(direction);
+        }
+        ++next_input_;
+    }
+
+    snake_.update();
+    ++predicted_tick_;
+
+    if (history_size_ == history_.size()) {
+        history_.emplace_back();
+    }
+    std::pair<uint64_t, std::vector<std::pair<int, int>>>& entry = history_[history_size_++];
+    entry.first = predicted_tick_;
+    entry.second.clear();
+    for (const GridCell& cell : snake_.body()) {
+        entry.second.emplace_back(cell.x, cell.y);
+    }
+}
+
+void SnakePredictor::updatePredicted() {
+    if (history_size_ == 0) {
+        return;
+    }
+    predicted_.coords = history_[history_size_ - 1].second;
+    predicted_.length = static_cast<int>(predicted_.coords.size());
+    predicted_.direction = std::string(1, toAction(snake_.getDirection()));
+}
+
+void SnakePredictor::scorePrediction(uint64_t tick, const snakejson::snake& actual) {
+    for (std::size_t i = 0; i < history_size_; ++i) {
+        const auto& entry = history_[i];
+        if (entry.first != tick) {
+            continue;
+        }
+        const std::vector<std::pair<int, int>>& predicted = entry.second;
+        ++stats_.compared;
+        if (predicted != actual.coords) {
+            ++stats_.corrections;
+        }
+        if (!predicted.empty() && !actual.coords.empty()) {
+            int error = std::abs(predicted[0].first - actual.coords[0].first)
+                + std::abs(predicted[0].second - actual.coords[0].second);
+            stats_.head_error_total += error;
+            stats_.max_head_error = std::max(stats_.max_head_error, error);
+        }
+        return;
+    }
+}
+
+std::string SnakePredictor::summary() const {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    double corrected = stats_.compared ? 100.0 * stats_.corrections / stats_.compared : 0;
+    double mean_error = stats_.compared ? static_cast<double>(stats_.head_error_total) / stats_.compared : 0;
+    out << "n=" << stats_.compared << " corrected=" << corrected << "% head error mean=" << mean_error
+        << " max=" << stats_.max_head_error << " cells, " << stats_.replayed_inputs << " inputs replayed, tick="
+        << stats_.tick_interval_ms << "ms rtt=" << stats_.round_trip_ms << "ms";
+    return out.str();
+}
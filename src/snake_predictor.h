@@ -0,0 +1,109 @@
+#ifndef SNAKE_PREDICTOR_H
+#define SNAKE_PREDICTOR_H
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grid_snake.h"
+#include "occupancy_grid.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    const int kMaxPredictedTicks = 5; // Never run further ahead of the last server state than this
+    const std::chrono::milliseconds kDefaultTickInterval(200); // Assumed server tick until we have measured it
+    const std::chrono::milliseconds kInputAckTimeout(1000); // Servers that never ack have applied an input by then
+
+    // How well prediction matched the server, counted per authoritative state of our own snake
+    struct PredictionStats {
+        uint64_t reconciles = 0; // Authoritative states we rewound to
+        uint64_t compared = 0; // States for whose tick we had a prediction to compare with
+        uint64_t corrections = 0; // Compared states where the predicted body was wrong
+        uint64_t head_error_total = 0; // Sum over compared states of the predicted head's distance from the real one, in cells
+        int max_head_error = 0;
+        uint64_t replayed_inputs = 0; // Unacknowledged inputs applied again after a rewind
+        double tick_interval_ms = 0; // Measured time between server ticks
+        double round_trip_ms = 0; // Measured time from a key press to its acknowledgement
+    };
+
+    /*
+     Predicts our own snake between server states so steering shows up without waiting for a round trip.
+     The prediction is a GridSnake stepped with GridSnake::update() and steered with setDirection() at the
+     rate the server ticks, on its own occupancy grid holding everybody else as of the last server state.
+     It runs one round trip ahead of the last state, at the tick the server will be on when an input sent
+     now reaches it, so a turn shows up on screen at the tick the server is going to apply it.
+     Every direction key gets a sequence number that goes to the server with it. When a server state
+     arrives we rewind the snake to it and replay, in order, the inputs the server had not yet acknowledged.
+     Whatever the replay can't know about, food in particular, is corrected by the next state.
+     Servers that never acknowledge leave the round trip unmeasured, and the prediction then only fills the
+     gaps between states. Render thread only.
+     */
+    class SnakePredictor {
+    private:
+        struct PendingInput {
+            uint64_t seq;
+            char action; // W, A, S or D
+            uint64_t tick; // Predicted tick on screen when the key was pressed, the input steers the step after it
+            std::chrono::steady_clock::time_point pressed_at;
+        };
+
+        uint32_t own_id_;
+        OccupancyGrid grid_; // Other snakes as of the last server state, plus our predicted one
+        // The cells other snakes were given in grid_ at the last state. The next state frees just these
+        // instead of clearing the whole board, which on a big board would cost far more than the snakes do.
+        std::vector<std::pair<GridCell, OccupancyGrid::Owner>> others_;
+        GridSnake snake_;
+
+        bool active_ = false; // We have a live authoritative snake of ours to predict from
+        bool has_base_ = false; // At least one authoritative state has arrived
+        uint64_t base_tick_ = 0; // Tick of the last authoritative state
+        std::chrono::steady_clock::time_point base_received_at_;
+        std::vector<GridCell> base_body_; // Our body in the last authoritative state, kept to reuse its capacity
+        uint64_t predicted_tick_ = 0; // Tick snake_ is at
+        std::size_t next_input_ = 0; // First pending input the current replay has not applied yet
+
+        std::deque<PendingInput> pending_; // Inputs the server has not acknowledged, oldest first
+        std::chrono::steady_clock::duration tick_interval_ = kDefaultTickInterval;
+        std::chrono::steady_clock::duration round_trip_ = std::chrono::steady_clock::duration::zero(); // How far ahead we run
+
+        // What we predicted for each tick after the last authoritative one, to score the next one against.
+        // Only the first history_size_ entries are in use, the rest keep their buffers for the next steps.
+        std::vector<std::pair<uint64_t, std::vector<std::pair<int, int>>>> history_;
+        std::size_t history_size_ = 0;
+
+        snakejson::snake predicted_; // Our snake as it should be drawn
+        PredictionStats stats_;
+
+        void step(); // Applies the inputs due before the next tick and moves the snake one cell
+        void scorePrediction(uint64_t tick, const snakejson::snake& actual);
+        void updatePredicted();
+
+    public:
+        // board_width and board_height are in cells, own_id is the snake we steer
+        SnakePredictor(int board_width, int board_height, uint32_t own_id);
+
+        // Records a direction key press sent to the server with sequence number seq
+        void pressed(char action, uint64_t seq, std::chrono::steady_clock::time_point now);
+
+        // Whether a press of action would only repeat the last unacknowledged one, at the same predicted tick.
+        // The server would apply both before the same step, so the second one changes nothing.
+        bool redundant(char action) const;
+
+        // Rewinds to a new authoritative state, dropping the inputs it already reflects
+        void reconcile(const WorldSnapshot& snapshot);
+
+        // Steps forward to the tick the server should be on by now, returns whether the predicted snake moved
+        bool advance(std::chrono::steady_clock::time_point now);
+
+        bool active() const { return active_; }
+        const snakejson::snake& predicted() const { return predicted_; }
+        const PredictionStats& stats() const { return stats_; }
+        std::string summary() const;
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -1,18 +1,48 @@
-#include "snakebody.h"
-
-namespace snakelinkedlist {
-    
-    std::ostream& operator<<(std::ostream& os, const SnakeBodySegment& list) {
-        os << list.data_;
-        return os;
-    }
-    
-    bool operator==(const SnakeBodySegment& lhs, const SnakeBodySegment& rhs) {
-        return (lhs.data_ == rhs.data_);
-    }
-    
-    bool operator!=(const SnakeBodySegment& lhs, const SnakeBodySegment& rhs) {
-        return !(lhs == rhs);
-    }
-    
-} // namespace snakelinkedlist
+#include "snakebody.h"
+
+namespace snakelinkedlist {
+
+    SnakeBodyRing::SnakeBodyRing(std::size_t capacity) {
+        std::size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        cells_.resize(rounded);
+    }
+
+    void SnakeBodyRing::grow() {
+        std::vector<GridCell> bigger(cells_.size() * 2);
+        for (std::size_t i = 0; i < size_; ++i) {
+            bigger[i] = (*this)[i];
+        }
+        cells_.swap(bigger);
+        head_ = 0;
+    }
+
+    void SnakeBodyRing::pushHead(const GridCell& cell) {
+        if (size_ == cells_.size()) {
+            grow();
+        }
+        head_ = (head_ - 1) & mask();
+        cells_[head_] = cell;
+        ++size_;
+    }
+
+    void SnakeBodyRing::pushTail(const GridCell& cell) {
+        if (size_ == cells_.size()) {
+            grow();
+        }
+        cells_[(head_ + size_) & mask()] = cell;
+        ++size_;
+    }
+
+    void SnakeBodyRing::popTail() {
+        --size_;
+    }
+
+    void SnakeBodyRing::clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+} // namespace snakelinkedlist
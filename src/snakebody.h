@@ -1,22 +1,77 @@
-#ifndef SNAKEBODY_H
-#define SNAKEBODY_H
-#pragma once
-
-#include <iostream>
-#include <vector>
-
-namespace snakelinkedlist {
-    
-    // Internal List Nodes
-    class SnakeBodySegment {
-        int data_;
-    public:
-        SnakeBodySegment() : data_(0) {};
-        SnakeBodySegment(const int v) : data_(v) {};
-        friend std::ostream& operator<<(std::ostream& os, const SnakeBodySegment& list);
-        friend bool operator==(const SnakeBodySegment& lhs, const SnakeBodySegment& rhs);
-        friend bool operator!=(const SnakeBodySegment& lhs, const SnakeBodySegment& rhs);
-    };
-    
-} // namespace snakelinkedlist
-#endif
+#ifndef SNAKEBODY_H
+#define SNAKEBODY_H
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace snakelinkedlist {
+
+    // A square on the game board, in cells rather than pixels
+    struct GridCell {
+        int x;
+        int y;
+
+        friend bool operator==(const GridCell& lhs, const GridCell& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y; }
+        friend bool operator!=(const GridCell& lhs, const GridCell& rhs) { return !(lhs == rhs); }
+    };
+
+    /*
+     The cells of a snake's body stored contiguously as a ring buffer, head first.
+     Moving the snake is a head push plus a tail pop and growing it is a tail push, all O(1) no matter
+     how long the snake is. The capacity is always a power of two so wrapping an index is a mask,
+     and it doubles when the ring fills up, so pushes are amortized O(1) and never allocate in steady state.
+     */
+    class SnakeBodyRing {
+    private:
+        std::vector<GridCell> cells_; // Storage, cells_.size() is the capacity
+        std::size_t head_ = 0; // Index of the head cell in cells_
+        std::size_t size_ = 0; // Number of cells in the body
+
+        std::size_t mask() const { return cells_.size() - 1; }
+        void grow(); // Doubles the capacity, unwrapping the ring so the head ends up at index 0
+
+    public:
+        // Walks the body from head to tail
+        class const_iterator {
+        private:
+            const SnakeBodyRing* ring_;
+            std::size_t index_; // 0 is the head
+
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef GridCell value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const GridCell* pointer;
+            typedef const GridCell& reference;
+
+            const_iterator(const SnakeBodyRing* ring, std::size_t index) : ring_(ring), index_(index) {}
+            reference operator*() const { return (*ring_)[index_]; }
+            pointer operator->() const { return &(*ring_)[index_]; }
+            const_iterator& operator++() { ++index_; return *this; }
+            const_iterator operator++(int) { const_iterator old = *this; ++index_; return old; }
+            friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) { return lhs.index_ == rhs.index_; }
+            friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) { return lhs.index_ != rhs.index_; }
+        };
+
+        explicit SnakeBodyRing(std::size_t capacity = 16);
+
+        void pushHead(const GridCell& cell); // Adds a new head in front of the current one
+        void pushTail(const GridCell& cell); // Adds a new tail behind the current one
+        void popTail(); // Removes the tail, the body must not be empty
+        void clear();
+
+        const GridCell& head() const { return cells_[head_]; }
+        const GridCell& tail() const { return cells_[(head_ + size_ - 1) & mask()]; }
+        const GridCell& operator[](std::size_t i) const { return cells_[(head_ + i) & mask()]; } // 0 is the head
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        std::size_t capacity() const { return cells_.size(); }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, size_); }
+    };
+
+} // namespace snakelinkedlist
+#endif
@@ -0,0 +1,182 @@
+#include "snapshot_interpolator.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace snakelinkedlist;
+
+namespace {
+    // Start of a segment's slide, or its end if it moved further than a cell and should just appear there
+    std::pair<float, float> slide(const std::pair<int, int>& from, const std::pair<int, int>& to, float fraction) {
+        if (std::abs(to.first - from.first) + std::abs(to.second - from.second) > 1) {
+            return std::make_pair(static_cast<float>(to.first), static_cast<float>(to.second));
+        }
+        return std::make_pair(from.first + (to.first - from.first) * fraction,
+                              from.second + (to.second - from.second) * fraction);
+    }
+
+    // Fills out with body sliding from from towards to. A body that grew has its new tail come out of the old one.
+    void slideBody(const std::vector<std::pair<int, int>>& from, const std::vector<std::pair<int, int>>& to, float fraction,
+                   std::vector<std::pair<float, float>>& out) {
+        out.resize(to.size());
+        for (std::size_t i = 0; i < to.size(); ++i) {
+            if (from.empty()) {
+                out[i] = std::make_pair(static_cast<float>(to[i].first), static_cast<float>(to[i].second));
+            } else {
+                out[i] = slide(from[std::min(i, from.size() - 1)], to[i], fraction);
+            }
+        }
+    }
+} // namespace
+
+SnapshotInterpolator::SnapshotInterpolator(Clock::duration delay) {
+    setDelay(delay);
+}
+
+void SnapshotInterpolator::setDelay(Clock::duration delay) {
+    delay_ = std::max(Clock::duration::zero(), std::min<Clock::duration>(delay, kMaxInterpolationDelay));
+}
+
+std::unique_ptr<WorldSnapshot> SnapshotInterpolator::push(std::unique_ptr<WorldSnapshot> state) {
+    if (!state) {
+        return nullptr;
+    }
+    ++stats_.states;
+    frame_current_ = false;
+    std::unique_ptr<WorldSnapshot> evicted;
+    std::size_t capacity = enabled() ? kJitterBufferStates : 2;
+    while (count_ >= capacity) {
+        // Playout is still short of the second oldest state, so it was sliding away from the oldest one
+        if (enabled() && count_ >= 2 && playout_ < states_[1]->received_at) {
+            ++stats_.overruns;
+        }
+        evicted = std::move(states_[0]);
+        // It will come back filled in with another state, maybe at the same address
+        if (evicted.get() == indexed_) {
+            indexed_ = nullptr;
+        }
+        std::move(states_.begin() + 1, states_.begin() + count_, states_.begin());
+        --count_;
+    }
+    states_[count_++] = std::move(state);
+    return evicted;
+}
+
+void SnapshotInterpolator::trackOwn(const snakejson::snake* own, Clock::duration own_step, Clock::time_point now) {
+    if (!own || own->coords.empty()) {
+        has_own_ = false;
+        own_fraction_ = 1;
+        return;
+    }
+    if (!has_own_ || own->id != own_id_) {
+        own_from_ = own->coords;
+        own_to_ = own->coords;
+        own_stepped_at_ = now;
+    } else if (own->coords != own_to_) {
+        own_from_.swap(own_to_);
+        own_to_ = own->coords;
+        own_stepped_at_ = now;
+    }
+    has_own_ = true;
+    own_id_ = own->id;
+    double step = std::chrono::duration<double>(own_step).count();
+    double since = std::chrono::duration<double>(now - own_stepped_at_).count();
+    own_fraction_ = step > 0 ? static_cast<float>(std::min(1.0, since / step)) : 1;
+}
+
+bool SnapshotInterpolator::advance(Clock::time_point now, const snakejson::snake* own, Clock::duration own_step) {
+    frame_current_ = false;
+    float own_before = own_fraction_;
+    trackOwn(own, own_step, now);
+    bool own_moved = has_own_ && own_fraction_ != own_before;
+    if (count_ == 0 || !enabled()) {
+        return own_moved;
+    }
+
+    // The newest state received before playout, or the oldest if playout hasn't reached any yet
+    playout_ = now - delay_;
+    from_ = 0;
+    while (from_ + 1 < count_ && states_[from_ + 1]->received_at <= playout_) {
+        ++from_;
+    }
+    if (from_ + 1 == count_) {
+        // Nothing newer to slide towards. Past the newest state that is an underrun, before it we are only
+        // waiting for the first states to fill the buffer.
+        if (!starved_ && states_[from_]->received_at <= playout_) {
+            ++stats_.underruns;
+            starved_ = true;
+        }
+        fraction_ = 0;
+    } else {
+        starved_ = false;
+        Clock::time_point from_at = states_[from_]->received_at;
+        Clock::time_point to_at = states_[from_ + 1]->received_at;
+        double span = std::chrono::duration<double>(to_at - from_at).count();
+        double into = std::chrono::duration<double>(playout_ - from_at).count();
+        fraction_ = span > 0 ? static_cast<float>(std::max(0.0, std::min(1.0, into / span))) : 1;
+    }
+
+    bool moved = states_[from_].get() != shown_from_ || fraction_ != shown_fraction_;
+    shown_from_ = states_[from_].get();
+    shown_fraction_ = fraction_;
+    return moved || own_moved;
+}
+
+InterpolatedSnake& SnapshotInterpolator::nextSnake() {
+    if (frame_.snake_count == frame_.snakes.size()) {
+        frame_.snakes.emplace_back();
+    }
+    return frame_.snakes[frame_.snake_count++];
+}
+
+const InterpolatedFrame& SnapshotInterpolator::interpolate() {
+    if (frame_current_) {
+        return frame_;
+    }
+    frame_current_ = true;
+    frame_.snake_count = 0;
+    frame_.food = nullptr;
+    if (count_ == 0) {
+        return frame_;
+    }
+    // Held or not interpolating: the state playout is at, as it is
+    bool sliding = enabled() && !starved_ && from_ + 1 < count_;
+    const WorldSnapshot& from = *states_[enabled() ? from_ : count_ - 1];
+    const WorldSnapshot& to = sliding ? *states_[from_ + 1] : from;
+    frame_.food = &to.food;
+
+    if (sliding && indexed_ != &from) {
+        from_index_.build(from.snakes);
+        indexed_ = &from;
+    }
+
+    for (const snakejson::snake& s : to.snakes) {
+        InterpolatedSnake& out = nextSnake();
+        out.id = s.id;
+        out.color = s.color;
+        if (has_own_ && s.id == own_id_) {
+            slideBody(own_from_, own_to_, own_fraction_, out.coords);
+            continue;
+        }
+        std::size_t older = sliding ? from_index_.find(s.id) : SnakeIndex::kNotFound;
+        if (older != SnakeIndex::kNotFound) {
+            slideBody(from.snakes[older].coords, s.coords, fraction_, out.coords);
+        } else {
+            slideBody(s.coords, s.coords, 0, out.coords);
+        }
+    }
+    return frame_;
+}
+
+std::string SnapshotInterpolator::summary() const {
+    char line[160];
+    if (!enabled()) {
+        std::snprintf(line, sizeof(line), "off, %llu states", static_cast<unsigned long long>(stats_.states));
+    } else {
+        std::snprintf(line, sizeof(line), "%.0f ms behind, %zu of %zu states buffered, %llu underruns, %llu overruns in %llu states",
+                      std::chrono::duration<double, std::milli>(delay_).count(), count_, kJitterBufferStates,
+                      static_cast<unsigned long long>(stats_.underruns), static_cast<unsigned long long>(stats_.overruns),
+                      static_cast<unsigned long long>(stats_.states));
+    }
+    return line;
+}
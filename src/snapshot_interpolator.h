@@ -0,0 +1,124 @@
+#ifndef SNAPSHOT_INTERPOLATOR_H
+#define SNAPSHOT_INTERPOLATOR_H
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    const std::size_t kJitterBufferStates = 3; // Server states kept to interpolate between
+    const std::chrono::milliseconds kDefaultInterpolationDelay(250); // One 5 Hz tick plus some room for jitter
+    const std::chrono::milliseconds kMaxInterpolationDelay(500);
+
+    // One snake as it should be drawn this frame, each segment's top left corner in cells, head first
+    struct InterpolatedSnake {
+        int id = 0;
+        std::array<int, 3> color;
+        std::vector<std::pair<float, float>> coords;
+    };
+
+    // Everything that moves, somewhere between two server states
+    struct InterpolatedFrame {
+        const std::vector<std::pair<int, int>>* food = nullptr; // The newer state's food, pellets don't slide
+        // Only the first snake_count entries are in use, the rest keep their buffers for the next frame
+        std::vector<InterpolatedSnake> snakes;
+        std::size_t snake_count = 0;
+    };
+
+    struct JitterStats {
+        uint64_t states = 0; // States pushed into the buffer
+        uint64_t underruns = 0; // Times playout caught up with the newest state and had to hold it
+        uint64_t overruns = 0; // States pushed out of a full buffer before playout was done with them
+    };
+
+    /*
+     Keeps the last few server states and plays them back delay behind real time, so the board can be drawn
+     at display refresh instead of jumping a cell every server tick. Playout is at now - delay on the clock
+     the states were received by: between two states every segment slides from where it was in the older one
+     to where it is in the newer one. A snake moves one cell per tick and every segment takes the place of
+     the one in front of it, so segment i slides along the body, and a segment that moved further than one
+     cell (a respawn, a skipped state, a snake coming into view) just appears where it is.
+     The delay trades latency against smoothness. Once playout catches up with the newest state it holds
+     it until the next one arrives, which is an underrun, and a full buffer pushing out a state playout
+     still needs is an overrun. A delay shorter than a tick underruns every tick and one a little over a tick
+     rides out most jitter, while one longer than the buffer spans (two ticks with three states) overruns,
+     and shows other snakes further in the past anyway. A delay of zero turns interpolation off, and only
+     the newest state and the one before it are kept, for renderers that paint the difference between them.
+     Our own snake is predicted ahead of the server rather than played back behind it. It is passed in
+     separately and slides from one predicted step to the next over a step's time, starting the moment
+     the step is taken, so smoothing it adds nothing to how soon a key press shows up.
+     Update thread only.
+     */
+    class SnapshotInterpolator {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        std::array<std::unique_ptr<WorldSnapshot>, kJitterBufferStates> states_; // Oldest first, first count_ in use
+        std::size_t count_ = 0;
+        Clock::duration delay_;
+
+        Clock::time_point playout_; // now - delay_ at the last advance()
+        // Where playout is: between states_[from_] and the state after it, fraction_ of the way
+        std::size_t from_ = 0;
+        float fraction_ = 0;
+        bool starved_ = false; // Holding the newest state until another arrives
+        const WorldSnapshot* shown_from_ = nullptr; // What the last advance() showed, to tell whether anything moved
+        float shown_fraction_ = 0;
+
+        // Our predicted snake's last two positions and when it took the step between them
+        int own_id_ = -1;
+        std::vector<std::pair<int, int>> own_from_;
+        std::vector<std::pair<int, int>> own_to_;
+        Clock::time_point own_stepped_at_;
+        float own_fraction_ = 1;
+        bool has_own_ = false;
+
+        SnakeIndex from_index_; // The older state's snakes by id
+        const WorldSnapshot* indexed_ = nullptr; // The state from_index_ was built for
+        InterpolatedFrame frame_;
+        bool frame_current_ = false; // frame_ is up to date with the last push() and advance()
+        JitterStats stats_;
+
+        void trackOwn(const snakejson::snake* own, Clock::duration own_step, Clock::time_point now);
+        InterpolatedSnake& nextSnake();
+
+    public:
+        explicit SnapshotInterpolator(Clock::duration delay = kDefaultInterpolationDelay);
+
+        SnapshotInterpolator(const SnapshotInterpolator&) = delete;
+        SnapshotInterpolator& operator=(const SnapshotInterpolator&) = delete;
+
+        // Adds the newest state. Returns the state pushed out to make room, if any, for recycling.
+        std::unique_ptr<WorldSnapshot> push(std::unique_ptr<WorldSnapshot> state);
+
+        // Moves playout to now - delay, and our own snake along its last step, which takes own_step.
+        // own is drawn in place of the snake with the same id and must stay alive until the next advance().
+        // Returns whether anything drawn moved since the last call.
+        bool advance(Clock::time_point now, const snakejson::snake* own, Clock::duration own_step);
+
+        // The board at the playout time of the last advance(), valid until the next push() or advance().
+        // Built on the first call after either, later calls return the same frame.
+        const InterpolatedFrame& interpolate();
+
+        // 0 turns interpolation off, anything above kMaxInterpolationDelay is clamped to it
+        void setDelay(Clock::duration delay);
+        Clock::duration delay() const { return delay_; }
+        bool enabled() const { return delay_ > Clock::duration::zero(); }
+
+        const WorldSnapshot* newest() const { return count_ ? states_[count_ - 1].get() : nullptr; }
+        const WorldSnapshot* previous() const { return count_ > 1 ? states_[count_ - 2].get() : nullptr; } // The one before newest()
+        std::size_t buffered() const { return count_; }
+        const JitterStats& stats() const { return stats_; }
+        std::string summary() const;
+    };
+} // namespace snakelinkedlist
+
+#endif
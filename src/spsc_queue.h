@@ -0,0 +1,52 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace snakelinkedlist {
+
+    /*
+     Lock-free single-producer/single-consumer FIFO of at most Capacity values, in a fixed ring.
+     Unlike LatestSlot every value is kept, in order, which is what commands to the server need.
+     The producer only writes tail_ and the consumer only writes head_, each reads the other's with acquire,
+     so neither side ever blocks or allocates. When the ring is full push() fails instead of waiting.
+     */
+    template <typename T, std::size_t Capacity>
+    class SpscQueue {
+    private:
+        std::array<T, Capacity> ring_;
+        std::atomic<std::size_t> head_{0}; // Next value to pop, only the consumer moves it
+        std::atomic<std::size_t> tail_{0}; // Next free entry, only the producer moves it
+
+    public:
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Producer side: appends a value, returns false if the queue is full
+        bool push(const T& value) {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            ring_[tail % Capacity] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side: takes the oldest value, returns false if the queue is empty
+        bool pop(T& value) {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = ring_[head % Capacity];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,302 @@
+#include "wire_codec.h"
+#include <algorithm>
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    const char kMagic0 = 'S';
+    const char kMagic1 = 'N';
+    const std::size_t kFixedHeaderLength = 4; // Magic, version and type, the tick varint follows
+
+    // Flag bits for snakes in a keyframe
+    const uint8_t kSnakeAlive = 1 << 0;
+
+    // Flag bits for a delta and its entries
+    const uint8_t kDeltaHasFood = 1 << 0;
+    const uint8_t kEntryHasHead = 1 << 0;
+    const uint8_t kEntryGrown = 1 << 1;
+    const uint8_t kEntryDied = 1 << 2;
+    const uint8_t kEntryHasBody = 1 << 3;
+    const uint8_t kEntryHasDirection = 1 << 4;
+    const uint8_t kEntryGone = 1 << 5;
+
+    class Writer {
+    private:
+        std::string& out_;
+
+    public:
+        explicit Writer(std::string& out) : out_(out) {}
+
+        void u8(uint8_t value) { out_.push_back(static_cast<char>(value)); }
+
+        void u32(uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                u8(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        void varint(uint64_t value) {
+            while (value >= 0x80) {
+                u8(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            u8(static_cast<uint8_t>(value));
+        }
+
+        void zigzag(int64_t value) { varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
+        void string(const std::string& value) {
+            varint(value.size());
+            out_.append(value);
+        }
+
+        void color(const std::array<int, 3>& rgb) {
+            for (int channel : rgb) {
+                u8(static_cast<uint8_t>(std::min(255, std::max(0, channel))));
+            }
+        }
+
+        void cell(const std::pair<int, int>& cell) {
+            zigzag(cell.first);
+            zigzag(cell.second);
+        }
+
+        // First cell as is, then the step from each cell to the next
+        template <typename Cells>
+        void cells(const Cells& run) {
+            varint(run.size());
+            std::pair<int, int> previous(0, 0);
+            for (const std::pair<int, int>& c : run) {
+                zigzag(static_cast<int64_t>(c.first) - previous.first);
+                zigzag(static_cast<int64_t>(c.second) - previous.second);
+                previous = c;
+            }
+        }
+
+        void header(WireMessageType type, uint64_t tick) {
+            u8(kMagic0);
+            u8(kMagic1);
+            u8(kWireVersion);
+            u8(static_cast<uint8_t>(type));
+            varint(tick);
+        }
+    };
+
+    class Reader {
+    private:
+        const uint8_t* data_;
+        const uint8_t* end_;
+
+        void need(std::size_t bytes) const {
+            if (static_cast<std::size_t>(end_ - data_) < bytes) {
+                throw WireFormatError("Binary world state is truncated");
+            }
+        }
+
+    public:
+        Reader(const char* data, std::size_t size)
+            : data_(reinterpret_cast<const uint8_t*>(data)), end_(reinterpret_cast<const uint8_t*>(data) + size) {}
+
+        uint8_t u8() {
+            need(1);
+            return *data_++;
+        }
+
+        uint32_t u32() {
+            need(4);
+            uint32_t value = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                value |= static_cast<uint32_t>(*data_++) << shift;
+            }
+            return value;
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte = u8();
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+            }
+            throw WireFormatError("Binary world state has an overlong varint");
+        }
+
+        int64_t zigzag() {
+            uint64_t value = varint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        // A count of items that each take at least min_bytes, checked so a corrupt count cannot make us allocate gigabytes
+        std::size_t count(std::size_t min_bytes) {
+            uint64_t value = varint();
+            if (value > static_cast<uint64_t>(end_ - data_) / min_bytes) {
+                throw WireFormatError("Binary world state has an impossible item count");
+            }
+            return static_cast<std::size_t>(value);
+        }
+
+        std::string string() {
+            std::size_t length = count(1);
+            std::string value(reinterpret_cast<const char*>(data_), length);
+            data_ += length;
+            return value;
+        }
+
+        std::array<int, 3> color() {
+            std::array<int, 3> rgb;
+            for (int& channel : rgb) {
+                channel = u8();
+            }
+            return rgb;
+        }
+
+        std::pair<int, int> cell() {
+            int x = static_cast<int>(zigzag());
+            int y = static_cast<int>(zigzag());
+            return std::make_pair(x, y);
+        }
+
+        void cells(std::vector<std::pair<int, int>>& run) {
+            std::size_t size = count(2);
+            run.resize(size);
+            std::pair<int, int> previous(0, 0);
+            for (std::pair<int, int>& c : run) {
+                previous.first += static_cast<int>(zigzag());
+                previous.second += static_cast<int>(zigzag());
+                c = previous;
+            }
+        }
+
+        uint64_t header(WireMessageType expected) {
+            if (u8() != kMagic0 || u8() != kMagic1) {
+                throw WireFormatError("Not a binary world state");
+            }
+            uint8_t version = u8();
+            if (version != kWireVersion) {
+                throw WireFormatError("Unsupported binary world state version " + std::to_string(version));
+            }
+            if (u8() != static_cast<uint8_t>(expected)) {
+                throw WireFormatError("Unexpected binary world state type");
+            }
+            return varint();
+        }
+    };
+} // namespace
+
+bool snakelinkedlist::isWireMessage(const char* data, std::size_t size) {
+    return size >= 2 && data[0] == kMagic0 && data[1] == kMagic1;
+}
+
+WireMessageType snakelinkedlist::wireMessageType(const char* data, std::size_t size) {
+    if (size < kFixedHeaderLength || !isWireMessage(data, size)) {
+        throw WireFormatError("Not a binary world state");
+    }
+    uint8_t type = static_cast<uint8_t>(data[3]);
+    if (type != static_cast<uint8_t>(WireMessageType::KEYFRAME) && type != static_cast<uint8_t>(WireMessageType::DELTA)) {
+        throw WireFormatError("Unknown binary world state type " + std::to_string(type));
+    }
+    return static_cast<WireMessageType>(type);
+}
+
+uint64_t snakelinkedlist::wireMessageTick(const char* data, std::size_t size) {
+    wireMessageType(data, size);
+    Reader reader(data + kFixedHeaderLength, size - kFixedHeaderLength);
+    return reader.varint();
+}
+
+void snakelinkedlist::encodeKeyframe(const WorldSnapshot& keyframe, std::string& out) {
+    Writer writer(out);
+    writer.header(WireMessageType::KEYFRAME, keyframe.tick);
+    writer.cells(keyframe.food);
+    writer.varint(keyframe.snakes.size());
+    for (const snakejson::snake& s : keyframe.snakes) {
+        writer.u32(static_cast<uint32_t>(s.id));
+        writer.u8(s.alive ? kSnakeAlive : 0);
+        writer.varint(static_cast<uint64_t>(std::max(0, s.length)));
+        writer.string(s.direction);
+        writer.color(s.color);
+        writer.cells(s.coords);
+    }
+}
+
+void snakelinkedlist::encodeDelta(const WorldDelta& delta, std::string& out) {
+    Writer writer(out);
+    writer.header(WireMessageType::DELTA, delta.tick);
+    writer.u8(delta.has_food ? kDeltaHasFood : 0);
+    if (delta.has_food) {
+        writer.cells(delta.food);
+    }
+    writer.varint(delta.snakes.size());
+    for (const SnakeDelta& d : delta.snakes) {
+        uint8_t flags = (d.has_head ? kEntryHasHead : 0) | (d.grown ? kEntryGrown : 0) | (d.died ? kEntryDied : 0)
+                        | (d.has_body ? kEntryHasBody : 0) | (d.direction.empty() ? 0 : kEntryHasDirection)
+                        | (d.gone ? kEntryGone : 0);
+        writer.u32(static_cast<uint32_t>(d.id));
+        writer.u8(flags);
+        if (d.has_head) {
+            writer.cell(d.head);
+        }
+        writer.varint(static_cast<uint64_t>(std::max(0, d.tail)));
+        if (!d.direction.empty()) {
+            writer.string(d.direction);
+        }
+        if (d.has_body) {
+            writer.color(d.color);
+            writer.cells(d.body);
+        }
+    }
+}
+
+void snakelinkedlist::decodeKeyframe(const char* data, std::size_t size, WorldSnapshot& keyframe) {
+    Reader reader(data, size);
+    keyframe.tick = reader.header(WireMessageType::KEYFRAME);
+    reader.cells(keyframe.food);
+
+    // Smallest possible snake: id, flags, length, empty direction, color and an empty cell run
+    keyframe.snakes.resize(reader.count(11));
+    for (snakejson::snake& s : keyframe.snakes) {
+        s.id = static_cast<int>(reader.u32());
+        s.alive = (reader.u8() & kSnakeAlive) != 0;
+        s.length = static_cast<int>(reader.varint());
+        s.direction = reader.string();
+        s.color = reader.color();
+        reader.cells(s.coords);
+    }
+}
+
+void snakelinkedlist::decodeDelta(const char* data, std::size_t size, WorldDelta& delta) {
+    Reader reader(data, size);
+    delta.tick = reader.header(WireMessageType::DELTA);
+    delta.has_food = (reader.u8() & kDeltaHasFood) != 0;
+    if (delta.has_food) {
+        reader.cells(delta.food);
+    } else {
+        delta.food.clear();
+    }
+
+    // Smallest possible entry: id, flags and the tail count
+    delta.snakes.resize(reader.count(6));
+    for (SnakeDelta& d : delta.snakes) {
+        d.id = static_cast<int>(reader.u32());
+        uint8_t flags = reader.u8();
+        d.has_head = (flags & kEntryHasHead) != 0;
+        d.grown = (flags & kEntryGrown) != 0;
+        d.died = (flags & kEntryDied) != 0;
+        d.gone = (flags & kEntryGone) != 0;
+        d.has_body = (flags & kEntryHasBody) != 0;
+        if (d.has_head) {
+            d.head = reader.cell();
+        }
+        d.tail = static_cast<int>(reader.varint());
+        d.direction = (flags & kEntryHasDirection) ? reader.string() : std::string();
+        if (d.has_body) {
+            d.color = reader.color();
+            reader.cells(d.body);
+        } else {
+            d.body.clear();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef WIRE_CODEC_H
+#define WIRE_CODEC_H
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "world_snapshot.h"
+#include "world_model.h"
+
+namespace snakelinkedlist {
+
+    /*
+     Compact binary encoding of world states, an optional alternative to JSON.
+     The client offers it when it connects and the server only switches if it agrees, so JSON keeps working
+     with servers that have never heard of it. Every binary message starts with a small header:
+       'S' 'N'  magic, never the first bytes of a JSON message
+       u8       version (kWireVersion)
+       u8       message type (WireMessageType)
+       varint   tick
+     Integers are LEB128 varints, zigzag encoded when they can be negative. Ids are fixed u32 little endian
+     and colors are packed into three RGB bytes. A run of cells is stored as the first cell followed by the
+     difference from each cell to the next. Neighbouring body cells differ by one step, so most cells cost
+     two bytes, compared to about eight for "[12,7],".
+     */
+    const uint8_t kWireVersion = 1;
+    const std::string kWireBinaryName("binary/1"); // Name offered during the connect handshake
+    const std::string kWireJsonName("json");
+
+    enum class WireMessageType : uint8_t {
+        KEYFRAME = 1,
+        DELTA = 2
+    };
+
+    // Thrown when a binary message is truncated or otherwise malformed
+    class WireFormatError : public std::runtime_error {
+    public:
+        explicit WireFormatError(const std::string& what) : std::runtime_error(what) {}
+    };
+
+    // Whether a received message body is binary rather than JSON
+    bool isWireMessage(const char* data, std::size_t size);
+
+    // Reads the message type from the header of a binary message. Throws WireFormatError.
+    WireMessageType wireMessageType(const char* data, std::size_t size);
+
+    // Reads the tick from the header of a binary message without decoding the rest. Throws WireFormatError.
+    uint64_t wireMessageTick(const char* data, std::size_t size);
+
+    // Append the binary encoding of a keyframe or a delta to out
+    void encodeKeyframe(const WorldSnapshot& keyframe, std::string& out);
+    void encodeDelta(const WorldDelta& delta, std::string& out);
+
+    // Decode a binary message of the matching type. Throws WireFormatError.
+    void decodeKeyframe(const char* data, std::size_t size, WorldSnapshot& keyframe);
+    void decodeDelta(const char* data, std::size_t size, WorldDelta& delta);
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include "work_stealing_pool.h"
+
+namespace snakelinkedlist {
+
+    WorkStealingPool::WorkStealingPool(std::size_t threads) {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i) {
+            queues_.push_back(std::make_unique<Queue>());
+        }
+        for (std::size_t i = 1; i < threads; ++i) {
+            workers_.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    bool WorkStealingPool::take(std::size_t self, Range& range) {
+        {
+            Queue& own = *queues_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.ranges.empty()) {
+                range = own.ranges.back();
+                own.ranges.pop_back();
+                return true;
+            }
+        }
+        // Start with the next thread along so thieves don't all pile onto the same victim
+        for (std::size_t i = 1; i < queues_.size(); ++i) {
+            Queue& victim = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.ranges.empty()) {
+                range = victim.ranges.front();
+                victim.ranges.pop_front();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingPool::drain(std::size_t self) {
+        Range range;
+        while (take(self, range)) {
+            (*task_)(range.first, range.second);
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_.notify_all();
+            }
+        }
+    }
+
+    void WorkStealingPool::work(std::size_t self) {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this, seen]() { return stopping_ || generation_ != seen; });
+                if (stopping_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            drain(self);
+        }
+    }
+
+    void WorkStealingPool::parallelFor(std::size_t count, std::size_t grain, const Task& task) {
+        if (count == 0) {
+            return;
+        }
+        grain = std::max<std::size_t>(grain, 1);
+        std::size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || queues_.size() == 1) {
+            task(0, count);
+            return;
+        }
+
+        task_ = &task;
+        remaining_.store(chunks, std::memory_order_relaxed);
+        // Contiguous blocks of chunks per thread, so neighbouring indices usually stay on one thread
+        std::size_t threads = queues_.size();
+        for (std::size_t t = 0; t < threads; ++t) {
+            std::size_t first = chunks * t / threads;
+            std::size_t last = chunks * (t + 1) / threads;
+            Queue& queue = *queues_[t];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            for (std::size_t c = first; c < last; ++c) {
+                queue.ranges.push_back(Range(c * grain, std::min(count, (c + 1) * grain)));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        drain(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return remaining_.load(std::memory_order_acquire) == 0; });
+        task_ = nullptr;
+    }
+
+} // namespace snakelinkedlist
@@ -0,0 +1,69 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace snakelinkedlist {
+
+    /*
+     A fixed set of threads that share out the chunks of a loop, for work whose chunks cost very different
+     amounts, like bots of which some are boxed in and some have the whole board ahead of them.
+     parallelFor() deals the chunks out in contiguous blocks, one block per thread, into one deque each. A
+     thread works from the back of its own deque and, once that is empty, steals from the front of someone
+     else's, so nobody sits idle while another thread still has a backlog. The calling thread works too.
+     One parallelFor() at a time, and tasks must not throw.
+     */
+    class WorkStealingPool {
+    public:
+        typedef std::function<void(std::size_t begin, std::size_t end)> Task;
+
+    private:
+        typedef std::pair<std::size_t, std::size_t> Range;
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues_; // One per thread, queues_[0] is the caller's
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_; // Guards generation_ and stopping_, and pairs with the condition variables
+        std::condition_variable wake_; // A new loop was dealt out, or the pool is stopping
+        std::condition_variable done_; // The last chunk of the loop finished
+        uint64_t generation_ = 0; // Number of loops dealt out so far
+        bool stopping_ = false;
+
+        const Task* task_ = nullptr; // The running loop's task, set before its chunks are dealt out
+        std::atomic<std::size_t> remaining_{0}; // Chunks of the running loop that have not finished
+        std::atomic<uint64_t> steals_{0};
+
+        bool take(std::size_t self, Range& range); // From our own deque, or stolen from another
+        void drain(std::size_t self); // Runs chunks until there are none left to take
+        void work(std::size_t self); // Worker thread loop
+
+    public:
+        explicit WorkStealingPool(std::size_t threads); // Threads in all, the caller included, at least 1
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+        ~WorkStealingPool();
+
+        std::size_t threads() const { return queues_.size(); }
+        uint64_t steals() const { return steals_.load(std::memory_order_relaxed); } // Chunks run by a thread they weren't dealt to
+
+        // Runs task over [0, count) in chunks of at most grain indices and returns once every chunk has run
+        void parallelFor(std::size_t count, std::size_t grain, const Task& task);
+    };
+
+} // namespace snakelinkedlist
+#endif
@@ -0,0 +1,262 @@
+#include "world_model.h"
+#include <iostream>
+#include "json_state_reader.h"
+#include "wire_codec.h"
+
+using namespace snakelinkedlist;
+using nlohmann::json;
+
+void snakelinkedlist::from_json(const json& j, SnakeDelta& d) {
+    j.at("id").get_to(d.id);
+
+    auto head = j.find("head");
+    d.has_head = (head != j.end());
+    if (d.has_head) {
+        head->get_to(d.head);
+    }
+    d.tail = j.value("tail", 0);
+    d.grown = j.value("grown", false);
+    d.died = j.value("died", false);
+    d.gone = j.value("gone", false);
+    d.direction = j.value("direction", std::string());
+
+    auto body = j.find("location");
+    d.has_body = (body != j.end());
+    if (d.has_body) {
+        body->get_to(d.body);
+        j.at("color").get_to(d.color);
+    }
+}
+
+void snakelinkedlist::from_json(const json& j, WorldDelta& d) {
+    j.at("tick").get_to(d.tick);
+
+    auto food = j.find("food");
+    d.has_food = (food != j.end());
+    if (d.has_food) {
+        food->get_to(d.food);
+    }
+    j.at("snakes").get_to(d.snakes);
+}
+
+void snakelinkedlist::to_json(json& j, const SnakeDelta& d) {
+    j = json{{"id", d.id}};
+    if (d.has_head) {
+        j["head"] = d.head;
+    }
+    if (d.tail) {
+        j["tail"] = d.tail;
+    }
+    if (d.grown) {
+        j["grown"] = true;
+    }
+    if (d.died) {
+        j["died"] = true;
+    }
+    if (d.gone) {
+        j["gone"] = true;
+    }
+    if (!d.direction.empty()) {
+        j["direction"] = d.direction;
+    }
+    if (d.has_body) {
+        j["location"] = d.body;
+        j["color"] = d.color;
+    }
+}
+
+void snakelinkedlist::to_json(json& j, const WorldDelta& d) {
+    j = json{{"type", "delta"}, {"tick", d.tick}, {"snakes", d.snakes}};
+    if (d.has_food) {
+        j["food"] = d.food;
+    }
+}
+
+bool snakelinkedlist::isDeltaMessage(const json& message) {
+    auto type = message.find("type");
+    return type != message.end() && *type == "delta";
+}
+
+bool WorldModel::apply(const json& message, uint64_t fallback_tick) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (isDeltaMessage(message)) {
+        bool applied = apply(message.get<WorldDelta>());
+        stats_.delta_time += std::chrono::steady_clock::now() - start;
+        return applied;
+    }
+
+    // Our own snake is looked up again when the snapshot is built, the id does not matter here
+    std::unique_ptr<WorldSnapshot> keyframe = parseWorldSnapshot(message, 0, fallback_tick);
+    applyKeyframe(*keyframe);
+    stats_.keyframe_time += std::chrono::steady_clock::now() - start;
+    return true;
+}
+
+bool WorldModel::applyWire(const char* data, std::size_t size) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (wireMessageType(data, size) == WireMessageType::DELTA) {
+        decodeDelta(data, size, scratch_delta_);
+        bool applied = apply(scratch_delta_);
+        stats_.delta_time += std::chrono::steady_clock::now() - start;
+        return applied;
+    }
+
+    decodeKeyframe(data, size, scratch_keyframe_);
+    applyKeyframe(scratch_keyframe_);
+    stats_.keyframe_time += std::chrono::steady_clock::now() - start;
+    return true;
+}
+
+bool WorldModel::apply(const JsonStateReader& reader) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (reader.kind() == JsonStateReader::Kind::DELTA) {
+        bool applied = apply(reader.delta());
+        stats_.delta_time += std::chrono::steady_clock::now() - start;
+        return applied;
+    }
+
+    applyKeyframe(reader.keyframe());
+    stats_.keyframe_time += std::chrono::steady_clock::now() - start;
+    return true;
+}
+
+void WorldModel::applyKeyframe(const WorldSnapshot& keyframe) {
+    // Snakes we already know are overwritten in place so their bodies keep their buffers,
+    // only the ones the keyframe no longer lists are dropped
+    ++keyframes_;
+    for (const snakejson::snake& s : keyframe.snakes) {
+        SnakeTrack& track = snakes_[s.id];
+        track.id = s.id;
+        track.length = s.length;
+        track.alive = s.alive;
+        track.direction = s.direction;
+        track.color = s.color;
+        track.keyframe = keyframes_;
+        track.body.clear();
+        for (const std::pair<int, int>& coord : s.coords) {
+            track.body.pushTail(GridCell{coord.first, coord.second});
+        }
+    }
+    for (auto it = snakes_.begin(); it != snakes_.end();) {
+        if (it->second.keyframe != keyframes_) {
+            it = snakes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    food_ = keyframe.food;
+    tick_ = keyframe.tick;
+    synced_ = true;
+    ++stats_.keyframes;
+}
+
+bool WorldModel::apply(const WorldDelta& delta) {
+    // Deltas only make sense on top of the tick right before them
+    if (synced_ && delta.tick != tick_ + 1) {
+        std::cerr << "World model: expected tick " << tick_ + 1 << " but got " << delta.tick
+                  << ", waiting for a keyframe" << std::endl;
+        synced_ = false;
+        ++stats_.resyncs;
+    }
+    if (!synced_) {
+        ++stats_.ignored_deltas;
+        return false;
+    }
+
+    for (const SnakeDelta& d : delta.snakes) {
+        if (d.gone) {
+            // Out of our area of interest, the server stops telling us about it until it comes back with its body
+            if (snakes_.erase(d.id) > 0) {
+                ++stats_.snakes_gone;
+            }
+            continue;
+        }
+        if (d.has_body) {
+            // A new or respawned snake, its whole body came with the delta
+            SnakeTrack& track = snakes_[d.id];
+            track.id = d.id;
+            track.length = static_cast<int>(d.body.size());
+            track.alive = !d.died;
+            track.direction = d.direction;
+            track.color = d.color;
+            track.body.clear();
+            for (const std::pair<int, int>& coord : d.body) {
+                track.body.pushTail(GridCell{coord.first, coord.second});
+            }
+            continue;
+        }
+
+        auto found = snakes_.find(d.id);
+        if (found == snakes_.end()) {
+            std::cerr << "World model: delta for unknown snake " << d.id << ", waiting for a keyframe" << std::endl;
+            synced_ = false;
+            ++stats_.resyncs;
+            return false;
+        }
+
+        SnakeTrack& track = found->second;
+        if (d.has_head) {
+            track.body.pushHead(GridCell{d.head.first, d.head.second});
+        }
+        for (int popped = 0; popped < d.tail && !track.body.empty(); ++popped) {
+            track.body.popTail();
+        }
+        if (d.grown) {
+            ++track.length;
+        }
+        if (d.died) {
+            track.alive = false;
+        }
+        if (!d.direction.empty()) {
+            track.direction = d.direction;
+        }
+    }
+
+    if (delta.has_food) {
+        food_ = delta.food;
+    }
+    tick_ = delta.tick;
+    ++stats_.deltas;
+    return true;
+}
+
+std::unique_ptr<WorldSnapshot> WorldModel::snapshot(uint32_t own_id) const {
+    auto snapshot = std::make_unique<WorldSnapshot>();
+    snapshotInto(*snapshot, own_id);
+    return snapshot;
+}
+
+void WorldModel::snapshotInto(WorldSnapshot& snapshot, uint32_t own_id) const {
+    snapshot.tick = tick_;
+    snapshot.food.assign(food_.begin(), food_.end());
+    snapshot.has_own_snake = false;
+    snapshot.own_alive = false;
+    snapshot.own_length = 0;
+
+    // resize() keeps the snakes already there, and with them their coords buffers
+    snapshot.snakes.resize(snakes_.size());
+    std::size_t index = 0;
+    for (const auto& entry : snakes_) {
+        const SnakeTrack& track = entry.second;
+        snakejson::snake& s = snapshot.snakes[index++];
+        s.id = track.id;
+        s.length = track.length;
+        s.alive = track.alive;
+        s.direction = track.direction;
+        s.color = track.color;
+        s.coords.resize(track.body.size());
+        std::size_t cell = 0;
+        for (const GridCell& body_cell : track.body) {
+            s.coords[cell++] = std::make_pair(body_cell.x, body_cell.y);
+        }
+
+        if (static_cast<uint32_t>(track.id) == own_id) {
+            snapshot.has_own_snake = true;
+            snapshot.own_alive = track.alive;
+            snapshot.own_length = track.length;
+        }
+    }
+}
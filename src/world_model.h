@@ -0,0 +1,140 @@
+#ifndef WORLD_MODEL_H
+#define WORLD_MODEL_H
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "snakebody.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+
+    class JsonStateReader;
+
+    /*
+     The server sends two kinds of world state messages:
+     * Keyframes, the full state we always had: {"tick", "food", "snakes": [{... "location": [[x,y],...]}]}
+       A "type" of "keyframe" is optional, anything that is not a delta is treated as a keyframe.
+     * Deltas, which only describe what changed since the previous tick:
+       {"type": "delta", "tick": 42, "food": [[x,y],...], "snakes": [{"id": 3, "head": [x,y], "tail": 1, ...}]}
+       "food" is only present when it changed. Snakes that are not listed did not change.
+     * A client that subscribed to an area of interest with a VIEW command only hears about the snakes and food
+       inside it. A snake coming into view is sent like a respawn, with its whole body, and one leaving it is
+       sent as {"id": 3, "gone": true} so the client forgets it.
+     */
+    struct SnakeDelta {
+        int id = 0;
+        bool has_head = false; // A new head cell was pushed onto the front of the body
+        std::pair<int, int> head;
+        int tail = 0; // Number of cells popped off the back of the body
+        bool grown = false; // The snake ate this tick, its length went up by one
+        bool died = false; // The snake died this tick
+        bool gone = false; // The snake left our area of interest, forget it
+        std::string direction; // New direction, empty if it did not change
+
+        // A snake that joined or respawned carries its whole body and color instead of a head/tail change
+        bool has_body = false;
+        std::array<int, 3> color;
+        std::vector<std::pair<int, int>> body;
+    };
+
+    struct WorldDelta {
+        uint64_t tick = 0;
+        bool has_food = false;
+        std::vector<std::pair<int, int>> food;
+        std::vector<SnakeDelta> snakes;
+    };
+
+    void from_json(const nlohmann::json& j, SnakeDelta& d);
+    void from_json(const nlohmann::json& j, WorldDelta& d);
+    void to_json(nlohmann::json& j, const SnakeDelta& d);
+    void to_json(nlohmann::json& j, const WorldDelta& d);
+
+    // Whether a received message is a delta rather than a keyframe
+    bool isDeltaMessage(const nlohmann::json& message);
+
+    /*
+     Persistent world state kept on the io thread.
+     Every snake keeps its body in its own ring buffer across ticks, so a delta costs O(changed cells)
+     to apply instead of re-parsing and re-allocating every snake. Keyframes replace everything and
+     are how we get back in sync: if a delta skips a tick or names a snake we do not know about,
+     deltas are ignored until the next keyframe arrives.
+     Once the buffers have grown to the size of the board, applying binary keyframes and deltas and
+     filling a reused snapshot with snapshotInto() allocate nothing. JSON states read with a JsonStateReader
+     only allocate inside the parser, a few times per message; apply(json) builds a DOM and allocates per cell.
+     */
+    class WorldModel {
+    public:
+        struct Stats {
+            uint64_t keyframes = 0; // Keyframes applied
+            uint64_t deltas = 0; // Deltas applied
+            uint64_t ignored_deltas = 0; // Deltas dropped while waiting for a keyframe
+            uint64_t resyncs = 0; // Times we lost sync and had to wait for a keyframe
+            uint64_t snakes_gone = 0; // Snakes dropped because they left our area of interest
+            std::chrono::steady_clock::duration keyframe_time{0}; // Total time spent applying keyframes
+            std::chrono::steady_clock::duration delta_time{0}; // Total time spent applying deltas
+        };
+
+    private:
+        struct SnakeTrack {
+            int id;
+            int length;
+            bool alive;
+            std::string direction;
+            std::array<int, 3> color;
+            SnakeBodyRing body; // Head first
+            uint64_t keyframe = 0; // The last keyframe that listed this snake, see keyframes_
+        };
+
+        std::map<int, SnakeTrack> snakes_; // Ordered by id so snapshots list snakes in a stable order
+        std::vector<std::pair<int, int>> food_;
+        uint64_t tick_ = 0;
+        bool synced_ = false; // False until the first keyframe and after any gap in the deltas
+        uint64_t keyframes_ = 0; // Keyframes applied so far, tells snakes a keyframe left out from the rest
+        Stats stats_;
+
+        // Binary messages are decoded into these and they are kept, so their buffers are reused
+        WorldDelta scratch_delta_;
+        WorldSnapshot scratch_keyframe_;
+
+        bool applyDelta(const WorldDelta& delta);
+
+    public:
+        // Applies a received keyframe or delta. Returns true if the world changed and a new snapshot should be published.
+        // Throws nlohmann::json exceptions if the message is malformed.
+        bool apply(const nlohmann::json& message, uint64_t fallback_tick);
+        
+        // Same as above for a message in the binary wire format. Throws WireFormatError if it is malformed.
+        bool applyWire(const char* data, std::size_t size);
+
+        // Same as above for the keyframe or delta a JsonStateReader just read, which is how the client takes JSON
+        // states: without a DOM, and without allocating once the reader's buffers have grown
+        bool apply(const JsonStateReader& reader);
+
+        // Replaces the whole world with a decoded keyframe
+        void applyKeyframe(const WorldSnapshot& keyframe);
+
+        // Applies a decoded delta, returns false if it was ignored because we are out of sync
+        bool apply(const WorldDelta& delta);
+
+        // Builds an immutable snapshot of the current world for the render thread
+        std::unique_ptr<WorldSnapshot> snapshot(uint32_t own_id) const;
+
+        // Same as snapshot() but fills in a snapshot that is being reused, keeping the capacity of its buffers.
+        // Leaves received_at and the acknowledged input for the caller.
+        void snapshotInto(WorldSnapshot& snapshot, uint32_t own_id) const;
+
+        bool synced() const { return synced_; }
+        uint64_t tick() const { return tick_; }
+        const Stats& stats() const { return stats_; }
+    };
+} // namespace snakelinkedlist
+
+#endif
@@ -0,0 +1,67 @@
+#include "world_snapshot.h"
+#include <algorithm>
+
+using namespace snakelinkedlist;
+using nlohmann::json;
+
+const std::size_t SnakeIndex::kNotFound;
+
+void SnakeIndex::build(const std::vector<snakejson::snake>& snakes) {
+    entries_.clear();
+    for (std::size_t i = 0; i < snakes.size(); ++i) {
+        entries_.emplace_back(snakes[i].id, i);
+    }
+    if (!std::is_sorted(entries_.begin(), entries_.end())) {
+        std::sort(entries_.begin(), entries_.end());
+    }
+}
+
+std::size_t SnakeIndex::find(int id) const {
+    auto found = std::lower_bound(entries_.begin(), entries_.end(), std::make_pair(id, std::size_t(0)));
+    return (found != entries_.end() && found->first == id) ? found->second : kNotFound;
+}
+
+void snakejson::from_json(const json& j, snakejson::snake& s) {
+    j.at("id").get_to(s.id);
+    j.at("length").get_to(s.length);
+    j.at("alive").get_to(s.alive);
+    j.at("direction").get_to(s.direction);
+    j.at("color").get_to(s.color);
+    j.at("location").get_to(s.coords);
+}
+
+void snakejson::to_json(json& j, const snakejson::snake& s) {
+    j = json{{"id", s.id}, {"length", s.length}, {"alive", s.alive}, {"direction", s.direction},
+             {"color", s.color}, {"location", s.coords}};
+}
+
+std::unique_ptr<WorldSnapshot> snakelinkedlist::parseWorldSnapshot(const json& world, uint32_t own_id, uint64_t fallback_tick) {
+    auto snapshot = std::make_unique<WorldSnapshot>();
+
+    auto tick = world.find("tick");
+    snapshot->tick = (tick != world.end()) ? tick->get<uint64_t>() : fallback_tick;
+
+    world.at("food").get_to(snapshot->food);
+
+    const json& snakes = world.at("snakes");
+    snapshot->snakes.reserve(snakes.size());
+    for (const json& j : snakes) {
+        snapshot->snakes.push_back(j.get<snakejson::snake>());
+    }
+
+    // Find our own snake so the render thread does not have to
+    for (const snakejson::snake& s : snapshot->snakes) {
+        if (static_cast<uint32_t>(s.id) == own_id) {
+            snapshot->has_own_snake = true;
+            snapshot->own_alive = s.alive;
+            snapshot->own_length = s.length;
+            break;
+        }
+    }
+
+    return snapshot;
+}
+
+json snakelinkedlist::keyframeToJson(const WorldSnapshot& keyframe) {
+    return json{{"type", "keyframe"}, {"tick", keyframe.tick}, {"food", keyframe.food}, {"snakes", keyframe.snakes}};
+}
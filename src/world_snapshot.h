@@ -0,0 +1,83 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+
+namespace snakelinkedlist {
+
+    namespace snakejson {
+
+        // Used to define how we will parse out the snake from JSON
+        struct snake {
+            int id;
+            int length;
+            bool alive;
+            std::string direction;
+            std::array<int, 3> color;
+            std::vector<std::pair<int, int>> coords;
+        };
+
+        // Allows the snakes to be parsed out into snake structs easily
+        void from_json(const nlohmann::json& j, snakejson::snake& s);
+        void to_json(nlohmann::json& j, const snakejson::snake& s);
+    }
+
+    /*
+     Everything the render thread needs to show one server tick.
+     Snapshots are decoded completely on the io thread and never modified once published, so
+     update() and draw() can read one without locks and without paying any parsing cost.
+     */
+    struct WorldSnapshot {
+        uint64_t tick = 0; // Server tick number, or our own count of received states if the server sends none
+        std::chrono::steady_clock::time_point received_at; // When the io thread received the state
+
+        std::vector<std::pair<int, int>> food; // Grid cells holding a food pellet
+        std::vector<snakejson::snake> snakes; // Every snake on the board, ours included
+
+        // Status of our own snake, looked up by id while decoding
+        bool has_own_snake = false;
+        bool own_alive = false;
+        int own_length = 0;
+        
+        // Sequence number of the last input of ours the server had acknowledged before this state arrived,
+        // filled in by the client. The state already reflects that input and every one before it.
+        uint64_t acked_input = 0;
+        std::chrono::steady_clock::time_point acked_at; // When that acknowledgement arrived
+    };
+
+    /*
+     Finds a state's snakes by id. Built again for every state it is used on, into the same buffer, so once
+     that has grown to the number of snakes it costs no allocation. Snapshots from the world model already
+     list their snakes by id and are indexed without sorting.
+     */
+    class SnakeIndex {
+    private:
+        std::vector<std::pair<int, std::size_t>> entries_; // Snake id and index in the state's snakes, by id
+
+    public:
+        static const std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+        void build(const std::vector<snakejson::snake>& snakes);
+        void clear() { entries_.clear(); }
+
+        // Index of the snake with that id in the snakes last built from, or kNotFound
+        std::size_t find(int id) const;
+    };
+
+    // Decodes one server world state into a snapshot. Throws nlohmann::json exceptions if the state is malformed.
+    std::unique_ptr<WorldSnapshot> parseWorldSnapshot(const nlohmann::json& world, uint32_t own_id, uint64_t fallback_tick);
+    
+    // Encodes a snapshot as a JSON keyframe message, the inverse of parseWorldSnapshot
+    nlohmann::json keyframeToJson(const WorldSnapshot& keyframe);
+} // namespace snakelinkedlist
+
+#endif
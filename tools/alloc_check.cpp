@@ -0,0 +1,374 @@
+// Counts heap allocations in the client's steady-state world state path and fails if there are any.
+// Every operator new in the process is counted. A synthetic world of wandering, eating, dying and respawning
+// snakes is encoded up front as binary keyframes and deltas. Then each message goes through what GameClient
+// does with it: WorldModel::applyWire(), WorldModel::snapshotInto() a snapshot from the RecyclePool, publish
+// through the LatestSlot, and on the render side take the newest snapshot and recycle the one it replaces.
+// A second pass does what the render side does with interpolation on: push the snapshot into the
+// SnapshotInterpolator, recycle the one it pushes out, and interpolate a frame between the buffered states.
+// After a warm-up that lets every buffer reach its working size, that path must not allocate at all.
+// For comparison it also counts the old snapshot-per-tick path and the two JSON paths, which still allocate:
+// a DOM allocates for every cell, the SAX JsonStateReader only a few times per message inside the parser.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src alloc_check.cpp ../src/json_state_reader.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp ../src/wire_codec.cpp ../src/snapshot_interpolator.cpp -o alloc_check
+// Run:
+//     ./alloc_check [--snakes 200] [--ticks 4000] [--warmup 600] [--keyframe-every 50] [--seed 1]
+// Exits with status 1 if either binary pass allocated after warm-up.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "json_state_reader.h"
+#include "latest_slot.h"
+#include "recycle_pool.h"
+#include "snapshot_interpolator.h"
+#include "wire_codec.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+using nlohmann::json;
+
+// Every form of operator new and delete is replaced, so whatever a library calls is counted and goes back
+// to the heap it came from. They must not be inlined: GCC would see std::free() called on what operator new
+// returned and warn about mismatched allocation functions.
+#if defined(__GNUC__)
+#define ALLOC_CHECK_NOINLINE __attribute__((noinline))
+#else
+#define ALLOC_CHECK_NOINLINE
+#endif
+
+namespace {
+    std::atomic<uint64_t> g_allocations{0};
+
+    ALLOC_CHECK_NOINLINE void* countedAlloc(std::size_t size) noexcept {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    ALLOC_CHECK_NOINLINE void countedFree(void* p) noexcept {
+        std::free(p);
+    }
+}
+
+ALLOC_CHECK_NOINLINE void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOC_CHECK_NOINLINE void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOC_CHECK_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+ALLOC_CHECK_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete(void* p) noexcept {
+    countedFree(p);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete[](void* p) noexcept {
+    countedFree(p);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete(void* p, std::size_t) noexcept {
+    countedFree(p);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete[](void* p, std::size_t) noexcept {
+    countedFree(p);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept {
+    countedFree(p);
+}
+
+ALLOC_CHECK_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    countedFree(p);
+}
+
+namespace {
+
+    const uint32_t kOwnId = 5;
+    const int kBoardSize = 200;
+    const int kFood = 20;
+    const std::size_t kMaxLength = 64; // Snakes grow up to this and then just move
+    const int kLifeTicks = 200; // Each snake dies this often and comes back a tick later
+    const std::chrono::milliseconds kTickInterval(200); // When the states arrive, for the interpolator
+
+    struct Options {
+        int snakes = 200;
+        int ticks = 4000;
+        int warmup = 600; // A few lives, so every delta entry has carried a respawned body and every snake has grown back
+        int keyframe_every = 50;
+        unsigned seed = 1;
+    };
+
+    struct GenSnake {
+        int id;
+        std::deque<std::pair<int, int>> body; // Head at the front
+        int dx = 1;
+        int dy = 0;
+        bool alive = true;
+        int life = 0;
+        std::array<int, 3> color;
+    };
+
+    // One encoded message per tick in both formats
+    struct Message {
+        std::string binary;
+        std::string json;
+    };
+
+    std::pair<int, int> wrap(int x, int y) {
+        return std::make_pair((x + kBoardSize) % kBoardSize, (y + kBoardSize) % kBoardSize);
+    }
+
+    std::vector<std::pair<int, int>> cells(const std::deque<std::pair<int, int>>& body) {
+        return std::vector<std::pair<int, int>>(body.begin(), body.end());
+    }
+
+    // The server's side: moves the snakes every tick and encodes what changed, with a keyframe now and then
+    std::vector<Message> generate(const Options& options) {
+        std::mt19937 generator(options.seed);
+        std::uniform_int_distribution<> coord(0, kBoardSize - 1);
+        std::uniform_int_distribution<> percent(0, 99);
+
+        std::vector<GenSnake> snakes(options.snakes);
+        for (int i = 0; i < options.snakes; ++i) {
+            snakes[i].id = i + 1;
+            snakes[i].body.push_back(std::make_pair(coord(generator), coord(generator)));
+            snakes[i].life = kLifeTicks - (i * kLifeTicks / options.snakes); // Deaths spread over the life span
+            snakes[i].color = {{coord(generator) % 256, coord(generator) % 256, coord(generator) % 256}};
+        }
+        std::vector<std::pair<int, int>> food;
+        for (int i = 0; i < kFood; ++i) {
+            food.push_back(std::make_pair(coord(generator), coord(generator)));
+        }
+
+        std::vector<Message> messages;
+        messages.reserve(options.ticks);
+        for (uint64_t tick = 1; tick <= static_cast<uint64_t>(options.ticks); ++tick) {
+            WorldDelta delta;
+            delta.tick = tick;
+            if (tick % 5 == 0) {
+                food[tick % kFood] = std::make_pair(coord(generator), coord(generator));
+                delta.has_food = true;
+                delta.food = food;
+            }
+            for (GenSnake& s : snakes) {
+                SnakeDelta d;
+                d.id = s.id;
+                if (!s.alive) {
+                    // Back with a short new body
+                    s.alive = true;
+                    s.life = kLifeTicks;
+                    s.body.clear();
+                    std::pair<int, int> cell(coord(generator), coord(generator));
+                    for (int c = 0; c < 4; ++c) {
+                        s.body.push_back(wrap(cell.first - c, cell.second));
+                    }
+                    s.dx = 1;
+                    s.dy = 0;
+                    d.has_body = true;
+                    d.body = cells(s.body);
+                    d.color = s.color;
+                    d.direction = "D";
+                    delta.snakes.push_back(d);
+                    continue;
+                }
+                if (--s.life <= 0) {
+                    s.alive = false;
+                    d.died = true;
+                    delta.snakes.push_back(d);
+                    continue;
+                }
+                if (percent(generator) < 10) {
+                    std::swap(s.dx, s.dy);
+                    if (percent(generator) < 50) {
+                        s.dx = -s.dx;
+                        s.dy = -s.dy;
+                    }
+                    d.direction = s.dx > 0 ? "D" : s.dx < 0 ? "A" : s.dy > 0 ? "S" : "W";
+                }
+                d.has_head = true;
+                d.head = wrap(s.body.front().first + s.dx, s.body.front().second + s.dy);
+                s.body.push_front(d.head);
+                if (s.body.size() > kMaxLength || percent(generator) < 50) {
+                    s.body.pop_back();
+                    d.tail = 1;
+                } else {
+                    d.grown = true;
+                }
+                delta.snakes.push_back(d);
+            }
+
+            Message message;
+            if (tick == 1 || tick % options.keyframe_every == 0) {
+                WorldSnapshot keyframe;
+                keyframe.tick = tick;
+                keyframe.food = food;
+                for (const GenSnake& s : snakes) {
+                    snakejson::snake k;
+                    k.id = s.id;
+                    k.length = static_cast<int>(s.body.size());
+                    k.alive = s.alive;
+                    k.direction = s.dx > 0 ? "D" : s.dx < 0 ? "A" : s.dy > 0 ? "S" : "W";
+                    k.color = s.color;
+                    k.coords = cells(s.body);
+                    keyframe.snakes.push_back(k);
+                }
+                encodeKeyframe(keyframe, message.binary);
+                message.json = keyframeToJson(keyframe).dump();
+            } else {
+                encodeDelta(delta, message.binary);
+                message.json = json(delta).dump();
+            }
+            messages.push_back(std::move(message));
+        }
+        return messages;
+    }
+
+    enum class Path { BINARY_POOLED, BINARY_INTERPOLATED, BINARY_UNPOOLED, JSON_DOM, JSON_SAX };
+
+    // Runs every message through the client's ingest and hand-off, returns the allocations after warm-up
+    uint64_t run(const std::vector<Message>& messages, const Options& options, Path path) {
+        WorldModel model;
+        JsonStateReader reader;
+        LatestSlot<WorldSnapshot> inbox;
+        RecyclePool<WorldSnapshot> pool;
+        std::unique_ptr<WorldSnapshot> shown;
+        SnapshotInterpolator interpolator;
+        std::chrono::steady_clock::time_point start;
+
+        uint64_t allocations_at_warmup = 0;
+        for (std::size_t tick = 0; tick < messages.size(); ++tick) {
+            if (tick == static_cast<std::size_t>(options.warmup)) {
+                allocations_at_warmup = g_allocations.load();
+            }
+            const Message& message = messages[tick];
+
+            // io thread
+            bool changed = false;
+            if (path == Path::JSON_DOM) {
+                changed = model.apply(json::parse(message.json), tick + 1);
+            } else if (path == Path::JSON_SAX) {
+                reader.read(message.json.data(), message.json.size(), tick + 1);
+                changed = model.apply(reader);
+            } else {
+                changed = model.applyWire(message.binary.data(), message.binary.size());
+            }
+            if (changed) {
+                std::unique_ptr<WorldSnapshot> snapshot;
+                if (path == Path::BINARY_UNPOOLED) {
+                    snapshot = model.snapshot(kOwnId);
+                } else {
+                    snapshot = pool.acquire();
+                    model.snapshotInto(*snapshot, kOwnId);
+                }
+                snapshot->received_at = start + kTickInterval * static_cast<int>(tick);
+                pool.recycle(inbox.publish(std::move(snapshot)));
+            }
+
+            // Render thread, which misses a state now and then like a slow frame would
+            if (tick % 7 != 3) {
+                std::unique_ptr<WorldSnapshot> latest = inbox.take();
+                if (path == Path::BINARY_INTERPOLATED) {
+                    pool.recycle(interpolator.push(std::move(latest)));
+                    const snakejson::snake* own = nullptr;
+                    if (const WorldSnapshot* newest = interpolator.newest()) {
+                        for (const snakejson::snake& s : newest->snakes) {
+                            if (s.id == static_cast<int>(kOwnId)) {
+                                own = &s;
+                            }
+                        }
+                    }
+                    // Half way between two states, and half way along our own snake's last step
+                    auto now = start + kTickInterval * static_cast<int>(tick) + kTickInterval / 2;
+                    interpolator.advance(now, own, kTickInterval);
+                    interpolator.interpolate();
+                } else if (latest) {
+                    pool.recycle(std::move(shown));
+                    shown = std::move(latest);
+                }
+            }
+        }
+        return g_allocations.load() - allocations_at_warmup;
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--snakes") {
+                options.snakes = std::max(1, std::stoi(value));
+            } else if (flag == "--ticks") {
+                options.ticks = std::max(2, std::stoi(value));
+            } else if (flag == "--warmup") {
+                options.warmup = std::max(0, std::stoi(value));
+            } else if (flag == "--keyframe-every") {
+                options.keyframe_every = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        options.warmup = std::min(options.warmup, options.ticks - 1);
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::vector<Message> messages = generate(options);
+    std::printf("%d snakes, %d ticks after %d warm-up ticks, keyframe every %d\n", options.snakes,
+                options.ticks - options.warmup, options.warmup, options.keyframe_every);
+
+    double measured = options.ticks - options.warmup;
+    uint64_t pooled = run(messages, options, Path::BINARY_POOLED);
+    uint64_t interpolated = run(messages, options, Path::BINARY_INTERPOLATED);
+    uint64_t unpooled = run(messages, options, Path::BINARY_UNPOOLED);
+    uint64_t json_dom = run(messages, options, Path::JSON_DOM);
+    uint64_t json_sax = run(messages, options, Path::JSON_SAX);
+    std::printf("  binary, pooled snapshots     %10llu allocations, %8.1f per tick\n",
+                static_cast<unsigned long long>(pooled), pooled / measured);
+    std::printf("  binary, interpolated         %10llu allocations, %8.1f per tick\n",
+                static_cast<unsigned long long>(interpolated), interpolated / measured);
+    std::printf("  binary, new snapshot a tick  %10llu allocations, %8.1f per tick\n",
+                static_cast<unsigned long long>(unpooled), unpooled / measured);
+    std::printf("  json dom, pooled snapshots   %10llu allocations, %8.1f per tick\n",
+                static_cast<unsigned long long>(json_dom), json_dom / measured);
+    std::printf("  json sax, pooled snapshots   %10llu allocations, %8.1f per tick\n",
+                static_cast<unsigned long long>(json_sax), json_sax / measured);
+
+    if (pooled != 0 || interpolated != 0) {
+        std::printf("FAIL: the steady-state binary path allocated\n");
+        return 1;
+    }
+    std::printf("OK: no allocations in the steady-state binary path, with or without interpolation\n");
+    return 0;
+}
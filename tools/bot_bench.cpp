@@ -0,0 +1,252 @@
+// Plays 10 to 10,000 bot snakes in the simulation engine from src/sim_engine.h, on a board with about 400
+// cells per snake, and times their decisions two ways: the bot engine in src/bot_engine.h, which builds
+// bitboards from each world state and runs one multi-source BFS from all the food, and a plain BFS from
+// every bot's head over the cells of the board until it finds food. Each tick the bots see a keyframe of the
+// world, decide, and their commands go back to the engine the way the stand-in server applies them.
+// It prints decisions per second, the time per tick and its share of a 200 ms tick, and the average length
+// of the live snakes at the end, so a faster bot that plays worse would show.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src bot_bench.cpp ../src/bot_engine.cpp ../src/bitboard.cpp ../src/work_stealing_pool.cpp ../src/sim_engine.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/snakebody.cpp ../src/world_snapshot.cpp -o bot_bench -pthread
+// Run:
+//     ./bot_bench [--ticks 200] [--threads n] [--tick-ms 200] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bot_engine.h"
+#include "sim_engine.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options {
+        int ticks = 200;
+        int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        int tick_ms = 200;
+        unsigned seed = 1;
+    };
+
+    struct Result {
+        double seconds = 0; // Deciding only, the simulation is not counted
+        uint64_t decisions = 0;
+        double average_length = 0;
+    };
+
+    // What every bot did before the bot engine: a BFS from its own head over the board until it finds food
+    class PlainBots {
+    private:
+        int width_;
+        int height_;
+        std::vector<uint32_t> visited_; // Stamp of the search that last reached the cell
+        std::vector<char> first_step_; // Move from the head that leads to the cell
+        std::vector<char> blocked_;
+        std::vector<char> food_;
+        std::vector<int> queue_;
+        uint32_t stamp_ = 0;
+
+    public:
+        PlainBots(int width, int height)
+            : width_(width), height_(height), visited_(width * height, 0), first_step_(width * height, 0),
+              blocked_(width * height, 0), food_(width * height, 0) {
+            queue_.reserve(width * height);
+        }
+
+        // The board is built once per state, as a bot client holding many snakes would
+        void load(const WorldSnapshot& state) {
+            std::fill(blocked_.begin(), blocked_.end(), 0);
+            std::fill(food_.begin(), food_.end(), 0);
+            for (const snakejson::snake& other : state.snakes) {
+                if (other.alive) {
+                    for (const std::pair<int, int>& cell : other.coords) {
+                        blocked_[cell.second * width_ + cell.first] = 1;
+                    }
+                }
+            }
+            for (const std::pair<int, int>& cell : state.food) {
+                food_[cell.second * width_ + cell.first] = 1;
+            }
+        }
+
+        char decide(const snakejson::snake& s) {
+            if (!s.alive) {
+                return 'R';
+            }
+
+            const char kActions[] = {'W', 'A', 'S', 'D'};
+            const int kStepX[] = {0, -1, 0, 1};
+            const int kStepY[] = {-1, 0, 1, 0};
+            ++stamp_;
+            queue_.clear();
+            char fallback = 0;
+            for (int d = 0; d < 4; ++d) {
+                int x = s.coords.front().first + kStepX[d];
+                int y = s.coords.front().second + kStepY[d];
+                if (x < 0 || y < 0 || x >= width_ || y >= height_ || blocked_[y * width_ + x]) {
+                    continue;
+                }
+                int cell = y * width_ + x;
+                visited_[cell] = stamp_;
+                first_step_[cell] = kActions[d];
+                queue_.push_back(cell);
+                fallback = fallback ? fallback : kActions[d];
+            }
+            for (std::size_t next = 0; next < queue_.size(); ++next) {
+                int cell = queue_[next];
+                if (food_[cell]) {
+                    return first_step_[cell];
+                }
+                int x = cell % width_;
+                int y = cell / width_;
+                for (int d = 0; d < 4; ++d) {
+                    int nx = x + kStepX[d];
+                    int ny = y + kStepY[d];
+                    if (nx < 0 || ny < 0 || nx >= width_ || ny >= height_) {
+                        continue;
+                    }
+                    int neighbour = ny * width_ + nx;
+                    if (blocked_[neighbour] || visited_[neighbour] == stamp_) {
+                        continue;
+                    }
+                    visited_[neighbour] = stamp_;
+                    first_step_[neighbour] = first_step_[cell];
+                    queue_.push_back(neighbour);
+                }
+            }
+            return fallback;
+        }
+    };
+
+    SimOptions boardFor(int snakes, unsigned seed) {
+        SimOptions sim;
+        sim.width = static_cast<int>(std::ceil(std::sqrt(snakes * 400.0)));
+        sim.height = sim.width;
+        sim.snakes = snakes;
+        sim.food = snakes / 2 + 5;
+        sim.seed = seed;
+        return sim;
+    }
+
+    double averageLength(const SimEngine& engine) {
+        double total = 0;
+        int alive = 0;
+        for (const SimSnake& s : engine.snakes()) {
+            if (s.alive) {
+                total += s.length;
+                ++alive;
+            }
+        }
+        return alive ? total / alive : 0;
+    }
+
+    // Plays the bots for ticks ticks, deciding with decide(state, ids, actions)
+    template <typename Decide>
+    Result play(const SimOptions& sim, int ticks, Decide&& decide) {
+        SimEngine engine(sim);
+        std::vector<int> ids;
+        for (const SimSnake& s : engine.snakes()) {
+            ids.push_back(s.id);
+            engine.command(s.id, s.direction); // From now on they are steered, and wait for R to respawn
+        }
+        std::vector<char> actions(ids.size());
+        Result result;
+        for (int t = 0; t < ticks; ++t) {
+            WorldSnapshot state = engine.keyframe();
+            Clock::time_point start = Clock::now();
+            decide(state, ids, actions);
+            result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            result.decisions += ids.size();
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+                if (actions[i]) {
+                    engine.command(ids[i], actions[i]);
+                }
+            }
+            engine.tick();
+        }
+        result.average_length = averageLength(engine);
+        return result;
+    }
+
+    void row(const char* name, const Result& result, int ticks, int tick_ms) {
+        double ms_per_tick = result.seconds * 1000 / ticks;
+        std::printf("  %-16s %12.0f decisions/s %9.3f ms/tick %7.2f%% of the tick, length %5.1f\n", name,
+                    result.decisions / result.seconds, ms_per_tick, ms_per_tick / tick_ms * 100, result.average_length);
+        std::fflush(stdout);
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--ticks") {
+                options.ticks = std::max(1, std::stoi(value));
+            } else if (flag == "--threads") {
+                options.threads = std::max(1, std::stoi(value));
+            } else if (flag == "--tick-ms") {
+                options.tick_ms = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    const int kBots[] = {10, 100, 1000, 10000};
+
+    for (int bots : kBots) {
+        SimOptions sim = boardFor(bots, options.seed);
+        std::printf("%d bots on %dx%d, %d ticks\n", bots, sim.width, sim.height, options.ticks);
+
+        PlainBots plain(sim.width, sim.height);
+        Result plain_result = play(sim, options.ticks, [&](const WorldSnapshot& state, const std::vector<int>& ids, std::vector<char>& actions) {
+            plain.load(state);
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+                const snakejson::snake& s = state.snakes[ids[i] - 1];
+                char action = plain.decide(s);
+                actions[i] = (!s.direction.empty() && action == s.direction[0]) ? 0 : action;
+            }
+        });
+        row("plain BFS", plain_result, options.ticks, options.tick_ms);
+
+        std::vector<int> thread_counts = {1};
+        if (options.threads > 1) {
+            thread_counts.push_back(options.threads);
+        }
+        for (int threads : thread_counts) {
+            BotEngine engine(threads);
+            std::vector<BotDecision> decisions;
+            Result result = play(sim, options.ticks, [&](const WorldSnapshot& state, const std::vector<int>& ids, std::vector<char>& actions) {
+                engine.load(state, sim.width, sim.height);
+                engine.decide(ids, decisions);
+                for (std::size_t i = 0; i < ids.size(); ++i) {
+                    actions[i] = decisions[i].action;
+                }
+            });
+            char name[32];
+            std::snprintf(name, sizeof(name), "bitboard x%d", threads);
+            row(name, result, options.ticks, options.tick_ms);
+            const BotStats& stats = engine.stats();
+            std::printf("  %-16s %9.3f ms/tick building boards and food distances, %9.3f ms/tick deciding, %llu steals\n", "",
+                        std::chrono::duration<double, std::milli>(stats.load_time).count() / stats.states,
+                        std::chrono::duration<double, std::milli>(stats.decide_time).count() / stats.states,
+                        static_cast<unsigned long long>(engine.steals()));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+// Bot snakes: steers a range of snake ids on a real server through the usual {"id": n, "action": "W"} commands,
+// to fill test matches and to load the server with clients that play rather than follow a script.
+// One connection receives the world the way the game does (src/world_model.h) and every new state goes to the
+// bot engine in src/bot_engine.h, which decides for all the bots at once on a work-stealing pool of threads.
+// Decisions run on the main thread while the io thread keeps reading, and only the newest state is decided on,
+// so a slow tick makes the bots skip a state instead of falling behind.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src bots.cpp ../src/bot_engine.cpp ../src/bitboard.cpp ../src/work_stealing_pool.cpp ../src/server_connection.cpp ../src/frame_decoder.cpp ../src/world_model.cpp ../src/world_snapshot.cpp ../src/json_state_reader.cpp ../src/wire_codec.cpp ../src/snakebody.cpp -o bots -lboost_system -pthread
+// Run:
+//     ./bots [--host 127.0.0.1] [--port 49145] [--bots 100] [--first-id 1] [--arena 48x27]
+//            [--threads n] [--seconds 10] [--binary 1]
+//
+// Every second it prints world states and decisions per second, and how much of the time between two states
+// the bots took to decide, which has to stay well under 100% for them to keep up with the server.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include "bot_engine.h"
+#include "json.hpp"
+#include "json_state_reader.h"
+#include "latest_slot.h"
+#include "server_connection.h"
+#include "wire_codec.h"
+#include "world_model.h"
+
+using nlohmann::json;
+using snakelinkedlist::BotDecision;
+using snakelinkedlist::BotEngine;
+using snakelinkedlist::JsonStateReader;
+using snakelinkedlist::LatestSlot;
+using snakelinkedlist::ServerConnection;
+using snakelinkedlist::WorldModel;
+using snakelinkedlist::WorldSnapshot;
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    const std::chrono::seconds kReportEvery(1);
+
+    struct Options {
+        std::string host = "127.0.0.1";
+        std::string port = "49145";
+        int bots = 100;
+        int first_id = 1;
+        int width = 48;
+        int height = 27;
+        int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        double seconds = 10;
+        bool binary = true;
+    };
+
+    // The world as the io thread reads it, handed to the main thread a state at a time
+    class Receiver {
+    private:
+        WorldModel model_;
+        JsonStateReader reader_;
+        std::unique_ptr<WorldSnapshot> spare_; // Recycled by the io thread so snapshots stop allocating
+        LatestSlot<WorldSnapshot>& states_;
+
+    public:
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> undecodable{0};
+
+        explicit Receiver(LatestSlot<WorldSnapshot>& states) : states_(states) {}
+
+        void onMessage(const char* data, std::size_t size) {
+            bool changed = false;
+            try {
+                if (snakelinkedlist::isWireMessage(data, size)) {
+                    changed = model_.applyWire(data, size);
+                } else if (reader_.read(data, size, received.load(std::memory_order_relaxed)) != JsonStateReader::Kind::OTHER) {
+                    changed = model_.apply(reader_);
+                }
+            } catch (std::exception&) {
+                undecodable.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (!changed) {
+                return;
+            }
+            received.fetch_add(1, std::memory_order_relaxed);
+            if (!spare_) {
+                spare_ = std::make_unique<WorldSnapshot>();
+            }
+            model_.snapshotInto(*spare_, 0);
+            spare_->received_at = Clock::now();
+            spare_ = states_.publish(std::move(spare_));
+        }
+    };
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--host") {
+                options.host = value;
+            } else if (flag == "--port") {
+                options.port = value;
+            } else if (flag == "--bots") {
+                options.bots = std::max(1, std::stoi(value));
+            } else if (flag == "--first-id") {
+                options.first_id = std::max(0, std::stoi(value));
+            } else if (flag == "--arena") {
+                std::size_t x = value.find('x');
+                if (x == std::string::npos) {
+                    std::fprintf(stderr, "--arena takes WxH, like 48x27\n");
+                    std::exit(1);
+                }
+                options.width = std::max(1, std::stoi(value.substr(0, x)));
+                options.height = std::max(1, std::stoi(value.substr(x + 1)));
+            } else if (flag == "--threads") {
+                options.threads = std::max(1, std::stoi(value));
+            } else if (flag == "--seconds") {
+                options.seconds = std::stod(value);
+            } else if (flag == "--binary") {
+                options.binary = std::stoi(value) != 0;
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::printf("%d bots (ids %d to %d) on a %dx%d arena, %d threads, %s world states\n", options.bots,
+                options.first_id, options.first_id + options.bots - 1, options.width, options.height, options.threads,
+                options.binary ? "binary" : "JSON");
+
+    boost::asio::io_context io_context;
+    LatestSlot<WorldSnapshot> states;
+    Receiver receiver(states);
+    ServerConnection* connection_ptr = nullptr;
+    ServerConnection connection(io_context, options.host, options.port,
+        [&receiver](const char* data, std::size_t size) { receiver.onMessage(data, size); },
+        [&options, &connection_ptr]() {
+            if (options.binary) {
+                json hello;
+                hello["id"] = options.first_id;
+                hello["action"] = std::string("HELLO");
+                hello["wire"] = {snakelinkedlist::kWireBinaryName, snakelinkedlist::kWireJsonName};
+                hello["frame"] = {snakelinkedlist::kFrameLongName};
+                connection_ptr->send(hello);
+            }
+        });
+    connection_ptr = &connection;
+    connection.start();
+    std::thread io_thread([&io_context]() { io_context.run(); });
+
+    BotEngine engine(options.threads);
+    std::vector<int> ids;
+    for (int i = 0; i < options.bots; ++i) {
+        ids.push_back(options.first_id + i);
+    }
+    std::vector<BotDecision> decisions;
+
+    uint64_t decided = 0, sent = 0, trapped = 0;
+    uint64_t last_received = 0, last_decided = 0;
+    Clock::duration busy{0}; // Deciding since the last report
+    Clock::time_point previous_state; // When the last state we decided on arrived
+    Clock::duration between{0}; // Sum of the gaps between states we decided on, since the last report
+    uint64_t gaps = 0;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    Clock::time_point next_report = start + kReportEvery;
+    while (Clock::now() < end) {
+        std::unique_ptr<WorldSnapshot> state = states.take();
+        if (state) {
+            Clock::time_point began = Clock::now();
+            engine.load(*state, options.width, options.height);
+            engine.decide(ids, decisions);
+            for (const BotDecision& decision : decisions) {
+                trapped += decision.trapped ? 1 : 0;
+                if (decision.action) {
+                    json command;
+                    command["id"] = decision.id;
+                    command["action"] = std::string(1, decision.action);
+                    connection.send(command);
+                    ++sent;
+                }
+            }
+            busy += Clock::now() - began;
+            ++decided;
+            if (previous_state != Clock::time_point()) {
+                between += state->received_at - previous_state;
+                ++gaps;
+            }
+            previous_state = state->received_at;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+
+        Clock::time_point now = Clock::now();
+        if (now >= next_report) {
+            uint64_t received = receiver.received.load(std::memory_order_relaxed);
+            double gap_ms = gaps ? std::chrono::duration<double, std::milli>(between).count() / gaps : 0;
+            double busy_ms = decided > last_decided ? std::chrono::duration<double, std::milli>(busy).count() / (decided - last_decided) : 0;
+            std::printf("%6llu states/s, %6llu decided on, %9.0f decisions/s, %8.3f ms per state, %6.1f%% of the %.0f ms between states\n",
+                        static_cast<unsigned long long>(received - last_received),
+                        static_cast<unsigned long long>(decided - last_decided),
+                        double(decided - last_decided) * ids.size(), busy_ms, gap_ms > 0 ? busy_ms / gap_ms * 100 : 0, gap_ms);
+            std::fflush(stdout);
+            last_received = received;
+            last_decided = decided;
+            busy = Clock::duration::zero();
+            between = Clock::duration::zero();
+            gaps = 0;
+            next_report += kReportEvery;
+        }
+    }
+
+    connection.close();
+    io_context.stop();
+    io_thread.join();
+
+    const snakelinkedlist::BotStats& stats = engine.stats();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("\n%llu states received, %llu decided on, %llu undecodable, %.1f s\n",
+                static_cast<unsigned long long>(receiver.received.load()), static_cast<unsigned long long>(decided),
+                static_cast<unsigned long long>(receiver.undecodable.load()), elapsed);
+    std::printf("%llu decisions, %llu commands sent, %llu times a bot was boxed in\n",
+                static_cast<unsigned long long>(stats.decisions), static_cast<unsigned long long>(sent),
+                static_cast<unsigned long long>(trapped));
+    if (stats.states > 0) {
+        std::printf("per state: %.3f ms building boards and food distances, %.3f ms deciding, %llu chunks stolen in all\n",
+                    std::chrono::duration<double, std::milli>(stats.load_time).count() / stats.states,
+                    std::chrono::duration<double, std::milli>(stats.decide_time).count() / stats.states,
+                    static_cast<unsigned long long>(engine.steals()));
+    }
+    return 0;
+}
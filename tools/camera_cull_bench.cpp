@@ -0,0 +1,144 @@
+// Sweeps the arena from 100x100 to 10,000x10,000 cells, with more and more snakes on it, and times
+// building the board mesh two ways: with every cell on the board, which is what BoardRenderer did before
+// it had a camera, and with only the cells the camera can see plus the half screen margin the app keeps.
+// The mesh is written the way BoardRenderer::rebuild() writes it, four vertices and four colors per
+// cell, into plain arrays since there is no GL context here. It prints cells submitted, build time and
+// the bytes that would go to the GPU on every rebuild, against a 60 fps frame budget of 16.7 ms.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src camera_cull_bench.cpp ../src/camera.cpp ../src/world_snapshot.cpp -o camera_cull_bench
+// Run:
+//     ./camera_cull_bench [--length 200] [--rebuilds 20] [--seed 1]
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "synthetic_world.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+using namespace snakelinkedlist::synthetic;
+
+namespace {
+
+    const float kScreenWidth = 1200;
+    const float kScreenHeight = 675;
+
+    struct Options {
+        int length = 200;
+        int rebuilds = 20;
+        unsigned seed = 1;
+    };
+
+    // What an ofVboMesh of the board holds, as BoardRenderer fills it
+    struct MeshArrays {
+        std::vector<std::array<float, 3>> vertices;
+        std::vector<std::array<float, 4>> colors;
+
+        void writeCell(std::size_t first, const std::pair<int, int>& cell, const std::array<float, 4>& color) {
+            float x = static_cast<float>(cell.first);
+            float y = static_cast<float>(cell.second);
+            vertices[first] = {{x, y, 0}};
+            vertices[first + 1] = {{x + 1, y, 0}};
+            vertices[first + 2] = {{x + 1, y + 1, 0}};
+            vertices[first + 3] = {{x, y + 1, 0}};
+            for (std::size_t i = first; i < first + 4; ++i) {
+                colors[i] = color;
+            }
+        }
+
+        std::size_t bytes() const {
+            return vertices.size() * sizeof(vertices[0]) + colors.size() * sizeof(colors[0]);
+        }
+    };
+
+    // Counts, sizes and fills the arrays with the cells in region, the same two passes as BoardRenderer::rebuild()
+    std::size_t build(const WorldSnapshot& board, const CellRect& region, MeshArrays& mesh) {
+        std::size_t cells = 0;
+        forEachCellIn(board, region, nullptr, [&cells](const std::pair<int, int>&, const snakejson::snake*) {
+            ++cells;
+        });
+        mesh.vertices.resize(cells * 4);
+        mesh.colors.resize(cells * 4);
+        std::size_t vertex = 0;
+        const std::array<float, 4> food_color = {{1, 0, 0, 1}};
+        forEachCellIn(board, region, nullptr, [&](const std::pair<int, int>& cell, const snakejson::snake* s) {
+            if (s) {
+                mesh.writeCell(vertex, cell, {{s->color[0] / 255.0f, s->color[1] / 255.0f, s->color[2] / 255.0f, 1}});
+            } else {
+                mesh.writeCell(vertex, cell, food_color);
+            }
+            vertex += 4;
+        });
+        return cells;
+    }
+
+    void row(const char* name, std::size_t cells, double ms, std::size_t bytes) {
+        std::printf("  %-8s %9zu cells %9.3f ms %8.2f MB to upload %7.1f%% of a 60 fps frame\n", name, cells, ms,
+                    bytes / 1e6, ms / (1000.0 / 60) * 100);
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--length") {
+                options.length = std::max(1, std::stoi(value));
+            } else if (flag == "--rebuilds") {
+                options.rebuilds = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::mt19937 generator(options.seed);
+
+    // Side of the arena and snakes on it
+    const int kArenas[][2] = {{100, 50}, {1000, 500}, {3000, 2000}, {10000, 5000}};
+    for (const auto& arena : kArenas) {
+        int size = arena[0];
+        int snakes = arena[1];
+        WorldSnapshot board = makeBoard(size, snakes, options.length, snakes / 10 + 5, generator);
+
+        // Where the app would look: following the first snake at the default zoom
+        Camera camera(size, size, kScreenWidth, kScreenHeight);
+        camera.follow(board.snakes.front().coords.front(), 0);
+        CellRect visible = camera.visibleCells();
+        CellRect culled_region = visible.grown(std::max(visible.right - visible.left, visible.bottom - visible.top) / 2);
+        CellRect whole_board;
+        whole_board.right = size;
+        whole_board.bottom = size;
+
+        MeshArrays mesh;
+        std::size_t all_cells = 0;
+        double all_ms = 1e-6 * nanosPerCall(options.rebuilds, [&]() {
+            all_cells = build(board, whole_board, mesh);
+        });
+        std::size_t all_bytes = mesh.bytes();
+        std::size_t culled_cells = 0;
+        double culled_ms = 1e-6 * nanosPerCall(options.rebuilds, [&]() {
+            culled_cells = build(board, culled_region, mesh);
+        });
+
+        std::printf("%dx%d arena, %d snakes of length %d, %d x %d cells on screen\n", size, size, snakes,
+                    options.length, visible.right - visible.left, visible.bottom - visible.top);
+        row("all", all_cells, all_ms, all_bytes);
+        row("culled", culled_cells, culled_ms, mesh.bytes());
+    }
+    return 0;
+}
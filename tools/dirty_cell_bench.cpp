@@ -0,0 +1,214 @@
+// Runs the simulation from src/sim_engine.h and, for every tick, works out what DirtyCellRenderer would paint:
+// only the cells that changed since the last tick, found by src/board_diff.h, against a full repaint of every
+// cell in view, which is what the batched renderer uploads whenever a state arrives. Both are written into
+// plain vertex and color arrays the way the renderers fill their meshes, since there is no GL context here.
+// A picture of the board is kept up to date from the dirty cells alone and checked against the state every
+// tick, so a diff that misses a cell shows up as a mismatch. It prints cells per tick and time per tick for
+// both, and how many cells with more than one thing on them the diff had to look up.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src dirty_cell_bench.cpp ../src/board_diff.cpp ../src/sim_engine.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/snakebody.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/wire_codec.cpp -o dirty_cell_bench
+// Run:
+//     ./dirty_cell_bench [--ticks 500] [--warmup 300] [--seed 1] [--verify 1]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "board_diff.h"
+#include "camera.h"
+#include "sim_engine.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    struct Options {
+        int ticks = 500;
+        int warmup = 300; // Ticks run first so the snakes have grown
+        unsigned seed = 1;
+        bool verify = true;
+    };
+
+    // What an ofVboMesh of cells holds, four vertices and four colors per cell
+    struct MeshArrays {
+        std::vector<std::array<float, 3>> vertices;
+        std::vector<std::array<float, 4>> colors;
+
+        void resize(std::size_t cells) {
+            vertices.resize(cells * 4);
+            colors.resize(cells * 4);
+        }
+
+        void writeCell(std::size_t cell, const std::pair<int, int>& at, const std::array<float, 4>& color) {
+            std::size_t first = cell * 4;
+            float x = static_cast<float>(at.first);
+            float y = static_cast<float>(at.second);
+            vertices[first] = {{x, y, 0}};
+            vertices[first + 1] = {{x + 1, y, 0}};
+            vertices[first + 2] = {{x + 1, y + 1, 0}};
+            vertices[first + 3] = {{x, y + 1, 0}};
+            for (std::size_t i = first; i < first + 4; ++i) {
+                colors[i] = color;
+            }
+        }
+    };
+
+    std::array<float, 4> toColor(const std::array<int, 3>& color) {
+        return {{color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, 1}};
+    }
+
+    // Every cell in region, the two passes BoardRenderer::rebuild() and a full DirtyCellRenderer repaint make
+    std::size_t paintAll(const WorldSnapshot& state, const CellRect& region, MeshArrays& mesh) {
+        std::size_t cells = 0;
+        forEachCellIn(state, region, nullptr, [&cells](const std::pair<int, int>&, const snakejson::snake*) {
+            ++cells;
+        });
+        mesh.resize(cells);
+        std::size_t cell = 0;
+        forEachCellIn(state, region, nullptr, [&](const std::pair<int, int>& at, const snakejson::snake* s) {
+            mesh.writeCell(cell++, at, toColor(s ? s->color : kFoodColor));
+        });
+        return cells;
+    }
+
+    // What DirtyCellRenderer::paintDirty() writes
+    std::size_t paintDirty(const BoardDiff& diff, MeshArrays& mesh) {
+        std::size_t cells = diff.cleared().size() + diff.painted().size();
+        mesh.resize(cells);
+        std::size_t cell = 0;
+        const std::array<float, 4> empty = {{1, 1, 1, 0}};
+        for (const std::pair<int, int>& at : diff.cleared()) {
+            mesh.writeCell(cell++, at, empty);
+        }
+        for (const DirtyCell& dirty : diff.painted()) {
+            mesh.writeCell(cell++, dirty.cell, toColor(dirty.color));
+        }
+        return cells;
+    }
+
+    // One color per cell, -1 where the board is empty, what the framebuffer would show
+    struct Picture {
+        int width;
+        std::vector<int> cells;
+
+        static int pack(const std::array<int, 3>& color) { return (color[0] << 16) | (color[1] << 8) | color[2]; }
+
+        void repaint(const WorldSnapshot& state, const CellRect& region) {
+            std::fill(cells.begin(), cells.end(), -1);
+            forEachCellIn(state, region, nullptr, [this](const std::pair<int, int>& at, const snakejson::snake* s) {
+                cells[static_cast<std::size_t>(at.second) * width + at.first] = pack(s ? s->color : kFoodColor);
+            });
+        }
+
+        void apply(const BoardDiff& diff) {
+            for (const std::pair<int, int>& at : diff.cleared()) {
+                cells[static_cast<std::size_t>(at.second) * width + at.first] = -1;
+            }
+            for (const DirtyCell& dirty : diff.painted()) {
+                cells[static_cast<std::size_t>(dirty.cell.second) * width + dirty.cell.first] = pack(dirty.color);
+            }
+        }
+    };
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--ticks") {
+                options.ticks = std::max(1, std::stoi(value));
+            } else if (flag == "--warmup") {
+                options.warmup = std::max(0, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else if (flag == "--verify") {
+                options.verify = std::stoi(value) != 0;
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+
+    // Arena side, snakes and food. Plenty of food, so the snakes grow long between deaths.
+    const int kWorlds[][3] = {{48, 8, 40}, {200, 100, 2000}, {1000, 2000, 50000}};
+    for (const auto& world : kWorlds) {
+        SimOptions sim_options;
+        sim_options.width = world[0];
+        sim_options.height = world[0];
+        sim_options.snakes = world[1];
+        sim_options.food = world[2];
+        sim_options.seed = options.seed;
+        SimEngine sim(sim_options);
+        for (int i = 0; i < options.warmup; ++i) {
+            sim.tick();
+        }
+
+        CellRect region;
+        region.right = sim_options.width;
+        region.bottom = sim_options.height;
+        BoardDiff diff;
+        MeshArrays mesh;
+        Picture picture{sim_options.width, std::vector<int>(static_cast<std::size_t>(sim_options.width) * sim_options.height, -1)};
+        Picture expected = picture;
+
+        WorldSnapshot previous = sim.keyframe();
+        diff.reset(previous, nullptr, region);
+        picture.repaint(previous, region);
+
+        std::size_t full_cells = 0, dirty_cells = 0;
+        uint64_t mismatches = 0;
+        std::chrono::steady_clock::duration full_time{0}, dirty_time{0};
+        for (int t = 0; t < options.ticks; ++t) {
+            sim.tick();
+            WorldSnapshot current = sim.keyframe();
+
+            auto start = std::chrono::steady_clock::now();
+            full_cells += paintAll(current, region, mesh);
+            full_time += std::chrono::steady_clock::now() - start;
+
+            start = std::chrono::steady_clock::now();
+            diff.diff(previous, nullptr, current, nullptr);
+            dirty_cells += paintDirty(diff, mesh);
+            dirty_time += std::chrono::steady_clock::now() - start;
+            if (options.verify) {
+                picture.apply(diff);
+            }
+
+            if (options.verify) {
+                expected.repaint(current, region);
+                if (expected.cells != picture.cells) {
+                    ++mismatches;
+                    picture.cells = expected.cells;
+                }
+            }
+            previous = std::move(current);
+        }
+
+        std::size_t length = 0;
+        for (const snakejson::snake& s : previous.snakes) {
+            length += s.coords.size();
+        }
+        double ticks = options.ticks;
+        std::printf("%dx%d arena, %d snakes %.1f cells long on average, %d food\n", world[0], world[0], world[1],
+                    double(length) / previous.snakes.size(), world[2]);
+        std::printf("  full    %10.1f cells/tick %9.3f ms/tick\n", full_cells / ticks,
+                    std::chrono::duration<double, std::milli>(full_time).count() / ticks);
+        std::printf("  dirty   %10.1f cells/tick %9.3f ms/tick, %llu overlapping cells looked up, %llu ticks mismatched%s\n",
+                    dirty_cells / ticks, std::chrono::duration<double, std::milli>(dirty_time).count() / ticks,
+                    static_cast<unsigned long long>(diff.resolvedCells()), static_cast<unsigned long long>(mismatches),
+                    options.verify ? "" : " (not verified)");
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Times placing food on a 1000x1000 board filled to 0%, 50%, 90%, 99% and 99.9%, two ways: retrying random
+// cells until one is empty, which is what the stand-in server did, and drawing from the grid's FreeCellSet.
+// Each placement reserves its cell and the previous pellet's cell is given back, so the board stays as full
+// as it started. It also times the snake moves that keep the set in sync, occupy() plus release(), on a grid
+// with and without free cell tracking, since every move on the board pays for the set and not just food.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src food_placement_bench.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp -o food_placement_bench
+// Run:
+//     ./food_placement_bench [--size 1000] [--placements 200000] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "occupancy_grid.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    const OccupancyGrid::Owner kBlocker = 1; // Owner of every occupied cell in the benchmark
+
+    struct Options {
+        int size = 1000;
+        int placements = 200000;
+        unsigned seed = 1;
+    };
+
+    // Occupies a random fraction of the board, cells listed so a benchmark can move them around
+    std::vector<GridCell> fill(OccupancyGrid& grid, double fraction, std::mt19937& generator) {
+        std::vector<GridCell> cells;
+        for (int y = 0; y < grid.height(); ++y) {
+            for (int x = 0; x < grid.width(); ++x) {
+                cells.push_back(GridCell{x, y});
+            }
+        }
+        std::shuffle(cells.begin(), cells.end(), generator);
+        cells.resize(static_cast<std::size_t>(cells.size() * fraction));
+        for (const GridCell& cell : cells) {
+            grid.occupy(cell, kBlocker);
+        }
+        return cells;
+    }
+
+    // The old way: random cells until one is empty. Free cells aren't tracked so reserving isn't possible,
+    // the pellet is occupied instead, which keeps it out of later tries the same way.
+    bool retryPlace(OccupancyGrid& grid, std::mt19937& generator, GridCell& cell, long long& tries) {
+        std::uniform_int_distribution<> x(0, grid.width() - 1);
+        std::uniform_int_distribution<> y(0, grid.height() - 1);
+        do {
+            cell = GridCell{x(generator), y(generator)};
+            ++tries;
+        } while (!grid.isFree(cell));
+        return grid.occupy(cell, kBlocker);
+    }
+
+    template <typename F>
+    double seconds(F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Moves random occupied cells to random cells, the work a snake moving does to the grid. On a full board
+    // most targets are taken and the move is just a failed occupy(), which is also what a blocked snake costs.
+    double movesPerSecond(bool track, double fraction, const Options& options) {
+        std::mt19937 generator(options.seed);
+        OccupancyGrid grid(options.size, options.size, track);
+        std::vector<GridCell> occupied = fill(grid, fraction, generator);
+        if (occupied.empty()) {
+            return 0;
+        }
+        std::uniform_int_distribution<std::size_t> pick(0, occupied.size() - 1);
+        std::uniform_int_distribution<> coord(0, options.size - 1);
+        // Precomputed so the timing is just the grid
+        std::vector<std::pair<std::size_t, GridCell>> moves;
+        for (int i = 0; i < options.placements; ++i) {
+            moves.push_back(std::make_pair(pick(generator), GridCell{coord(generator), coord(generator)}));
+        }
+        double elapsed = seconds([&]() {
+            for (const auto& move : moves) {
+                GridCell& from = occupied[move.first];
+                if (grid.occupy(move.second, kBlocker)) {
+                    grid.release(from, kBlocker);
+                    from = move.second;
+                }
+            }
+        });
+        return moves.size() / elapsed;
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--size") {
+                options.size = std::max(2, std::stoi(value));
+            } else if (flag == "--placements") {
+                options.placements = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    const double kFractions[] = {0, 0.5, 0.9, 0.99, 0.999};
+
+    std::printf("%dx%d board, %d placements per row\n", options.size, options.size, options.placements);
+    std::printf("  %-8s %16s %12s %14s %16s %16s\n", "full", "retry places/s", "tries/place", "set places/s",
+                "tracked moves/s", "plain moves/s");
+    for (double fraction : kFractions) {
+        std::mt19937 generator(options.seed);
+
+        OccupancyGrid plain(options.size, options.size);
+        fill(plain, fraction, generator);
+        long long tries = 0;
+        GridCell previous;
+        bool has_previous = false;
+        double retry_seconds = seconds([&]() {
+            for (int i = 0; i < options.placements; ++i) {
+                GridCell cell;
+                retryPlace(plain, generator, cell, tries);
+                if (has_previous) {
+                    plain.release(previous, kBlocker);
+                }
+                previous = cell;
+                has_previous = true;
+            }
+        });
+
+        OccupancyGrid tracked(options.size, options.size, true);
+        fill(tracked, fraction, generator);
+        has_previous = false;
+        double set_seconds = seconds([&]() {
+            for (int i = 0; i < options.placements; ++i) {
+                GridCell cell;
+                if (!tracked.randomFreeCell(generator, cell)) {
+                    break;
+                }
+                tracked.reserve(cell);
+                if (has_previous) {
+                    tracked.unreserve(previous);
+                }
+                previous = cell;
+                has_previous = true;
+            }
+        });
+
+        std::printf("  %7.1f%% %16.0f %12.1f %14.0f %16.0f %16.0f\n", fraction * 100, options.placements / retry_seconds,
+                    static_cast<double>(tries) / options.placements, options.placements / set_seconds,
+                    movesPerSecond(true, fraction, options), movesPerSecond(false, fraction, options));
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+// Checks src/frame_decoder.h against the ways TCP hands a stream of messages over, and fails if any message
+// comes out different from how it went in. A mix of short messages with 4 digit headers and long ones of up to
+// --max-long bytes with "####" headers is framed with frameMessage() and fed to the decoder in reads of
+// random size, from a single byte to several messages at once. Messages past 9999 bytes need the decoder's
+// buffer to grow beyond its usual 64 KB. It also checks that frameMessage() refuses a long body unless long
+// headers are allowed, and that a broken header or an impossible long length is reported as BAD_HEADER.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src frame_decoder_check.cpp ../src/frame_decoder.cpp -o frame_decoder_check
+// Run:
+//     ./frame_decoder_check [--messages 5000] [--max-read 70000] [--max-long 300000] [--seed 1]
+// Exits with status 1 if any check failed.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+
+using snakelinkedlist::FrameDecoder;
+
+namespace {
+
+    struct Options {
+        int messages = 5000;
+        std::size_t max_read = 70000; // Larger than the decoder's buffer, so a read can fill all of it
+        std::size_t max_long = 300000;
+        unsigned seed = 1;
+    };
+
+    int g_failures = 0;
+
+    void check(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("FAIL: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // Mostly world state sized messages, every tenth one past what 4 digits can say
+    std::string makeBody(std::mt19937& generator, std::size_t index, const Options& options) {
+        std::size_t size;
+        if (index % 10 == 9) {
+            size = std::uniform_int_distribution<std::size_t>(FrameDecoder::kMaxBodyLength + 1, options.max_long)(generator);
+        } else {
+            size = std::uniform_int_distribution<std::size_t>(0, 3000)(generator);
+        }
+        std::string body(size, '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            body[i] = static_cast<char>((index * 31 + i * 7) & 0xFF);
+        }
+        return body;
+    }
+
+    // Pushes stream through the decoder in reads of 1 to max_read bytes, collecting every message it hands out
+    bool decode(const std::string& stream, std::mt19937& generator, std::size_t max_read, FrameDecoder& decoder,
+                std::vector<std::string>& out) {
+        std::uniform_int_distribution<std::size_t> read_size(1, max_read);
+        std::size_t position = 0;
+        while (position < stream.size()) {
+            std::pair<char*, std::size_t> space = decoder.prepare();
+            std::size_t size = std::min(std::min(read_size(generator), space.second), stream.size() - position);
+            std::memcpy(space.first, stream.data() + position, size);
+            position += size;
+            decoder.commit(size);
+
+            const char* data;
+            std::size_t length;
+            for (;;) {
+                FrameDecoder::Result result = decoder.next(data, length);
+                if (result == FrameDecoder::Result::BAD_HEADER) {
+                    return false;
+                }
+                if (result == FrameDecoder::Result::INCOMPLETE) {
+                    break;
+                }
+                out.emplace_back(data, length);
+            }
+        }
+        return true;
+    }
+
+    // What frameMessage() writes for bodies on either side of the 4 digit limit
+    void checkFraming() {
+        std::string framed;
+        check(snakelinkedlist::frameMessage(std::string(12, 'x'), false, framed) && framed == "  12xxxxxxxxxxxx",
+              "a short body gets a 4 digit header");
+        check(snakelinkedlist::frameMessage(std::string(FrameDecoder::kMaxBodyLength, 'x'), false, framed) &&
+                  framed.compare(0, FrameDecoder::kHeaderLength, "9999") == 0,
+              "a body of 9999 bytes still gets a 4 digit header");
+
+        framed = "untouched";
+        std::string long_body(FrameDecoder::kMaxBodyLength + 1, 'x');
+        check(!snakelinkedlist::frameMessage(long_body, false, framed) && framed == "untouched",
+              "a body of 10000 bytes is refused unless long headers are allowed");
+        check(snakelinkedlist::frameMessage(long_body, true, framed) &&
+                  framed.size() == FrameDecoder::kLongHeaderLength + long_body.size() &&
+                  framed.compare(0, FrameDecoder::kLongHeaderLength, std::string("####\x10\x27\0\0", 8)) == 0,
+              "a body of 10000 bytes gets \"####\" and its length little endian");
+    }
+
+    // Headers the decoder must not take for a length
+    void checkBadHeaders() {
+        const std::string bad[] = {
+            "    body", // No digits at all
+            " 1x2body", // Not a number
+            "-001body",
+            std::string("####\x01\x00\x00\x10", 8), // A long length past kMaxLongBodyLength
+        };
+        for (const std::string& stream : bad) {
+            FrameDecoder decoder;
+            std::pair<char*, std::size_t> space = decoder.prepare();
+            std::memcpy(space.first, stream.data(), stream.size());
+            decoder.commit(stream.size());
+            const char* data;
+            std::size_t size;
+            check(decoder.next(data, size) == FrameDecoder::Result::BAD_HEADER, "a broken header is BAD_HEADER");
+        }
+
+        // A long header whose length has not all arrived yet is only incomplete
+        FrameDecoder decoder;
+        std::pair<char*, std::size_t> space = decoder.prepare();
+        std::memcpy(space.first, "####\x10", 5);
+        decoder.commit(5);
+        const char* data;
+        std::size_t size;
+        check(decoder.next(data, size) == FrameDecoder::Result::INCOMPLETE, "half a long header is INCOMPLETE");
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--messages") {
+                options.messages = std::max(1, std::stoi(value));
+            } else if (flag == "--max-read") {
+                options.max_read = std::max<std::size_t>(1, std::stoul(value));
+            } else if (flag == "--max-long") {
+                options.max_long = std::min(FrameDecoder::kMaxLongBodyLength,
+                                            std::max(FrameDecoder::kMaxBodyLength + 1, std::stoul(value)));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    checkFraming();
+    checkBadHeaders();
+
+    std::mt19937 generator(options.seed);
+    std::vector<std::string> bodies;
+    std::string stream;
+    std::size_t long_messages = 0;
+    std::size_t longest = 0;
+    for (int i = 0; i < options.messages; ++i) {
+        bodies.push_back(makeBody(generator, i, options));
+        std::string framed;
+        if (!snakelinkedlist::frameMessage(bodies.back(), true, framed)) {
+            check(false, "every body fits a long header");
+            return 1;
+        }
+        stream += framed;
+        long_messages += bodies.back().size() > FrameDecoder::kMaxBodyLength ? 1 : 0;
+        longest = std::max(longest, bodies.back().size());
+    }
+    std::printf("%d messages, %zu of them over %zu bytes and up to %zu, %zu bytes in all, reads of 1 to %zu bytes\n",
+                options.messages, long_messages, FrameDecoder::kMaxBodyLength, longest, stream.size(), options.max_read);
+
+    // Both read sizes small enough to split every header and large enough to take many messages at once
+    const std::size_t max_reads[] = {7, options.max_read};
+    for (std::size_t max_read : max_reads) {
+        FrameDecoder decoder;
+        std::vector<std::string> decoded;
+        bool ok = decode(stream, generator, max_read, decoder, decoded);
+        check(ok, "the decoder found no bad header in a well framed stream");
+        check(decoded.size() == bodies.size(), "as many messages came out as went in");
+        check(std::equal(decoded.begin(), decoded.end(), bodies.begin(), bodies.end()),
+              "every message came out as it went in");
+        check(decoder.buffered() == 0, "nothing was left over");
+        std::printf("  reads of up to %6zu bytes: %8llu reads, %llu messages, %llu bytes moved, buffer grew to %zu\n",
+                    max_read, static_cast<unsigned long long>(decoder.reads()),
+                    static_cast<unsigned long long>(decoder.messages()),
+                    static_cast<unsigned long long>(decoder.movedBytes()), decoder.capacity());
+    }
+
+    if (g_failures > 0) {
+        std::printf("FAIL: %d checks failed\n", g_failures);
+        return 1;
+    }
+    std::printf("OK: every message decoded as it was framed\n");
+    return 0;
+}
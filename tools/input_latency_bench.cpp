@@ -0,0 +1,194 @@
+// Measures input-to-pixel latency of the client's two render loops against the same simulated server, with no
+// openFrameworks and no window. A server thread ticks every --tick-ms and stamps each world state with the last
+// key press it has applied. Key presses come at random times, 250 to 750 ms apart, and like openFrameworks key
+// events they are only handled at the start of the next frame. A press is done when a frame is presented from a
+// state that includes it, and the time from the press to the end of that frame goes into a LatencyHistogram.
+//
+// The "sleep" loop is update() as it was before world states went through a LatestSlot: sleep until 200 ms have
+// passed since the last update, take whatever state the client last received and draw it, with the frame rate
+// capped at 5 fps. The "slot" loop is the current one: frames at 60 fps, each taking the newest state from a
+// LatestSlot if the server published one and otherwise redrawing the last.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src input_latency_bench.cpp -o input_latency_bench -pthread
+// Run:
+//     ./input_latency_bench [--presses 100] [--tick-ms 200] [--draw-ms 2] [--seed 1]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "latency_histogram.h"
+#include "latest_slot.h"
+
+using snakelinkedlist::LatencyHistogram;
+using snakelinkedlist::LatestSlot;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    struct Options {
+        int presses = 100;
+        int tick_ms = 200;
+        double draw_ms = 2;
+        unsigned seed = 1;
+    };
+
+    enum class Loop { SLEEP, SLOT };
+
+    // What a world state needs to say for this: which key presses it already includes
+    struct State {
+        uint64_t applied_press = 0;
+    };
+
+    /*
+     Ticks on its own clock like the game server. Key presses sent before a tick are in that tick's state.
+     Each state goes both into a LatestSlot, as the io thread hands them over now, and into a "most recent"
+     copy that the sleep loop reads the way it used to call get_recent_json().
+     */
+    class Server {
+    private:
+        std::chrono::milliseconds tick_;
+        std::atomic<uint64_t> sent_press_{0};
+        std::atomic<bool> running_{true};
+        LatestSlot<State> slot_;
+        std::mutex recent_mutex_;
+        State recent_;
+        std::thread thread_;
+
+        void run() {
+            Clock::time_point next = Clock::now() + tick_;
+            while (running_.load()) {
+                std::this_thread::sleep_until(next);
+                next += tick_;
+                std::unique_ptr<State> state(new State);
+                state->applied_press = sent_press_.load();
+                {
+                    std::lock_guard<std::mutex> lock(recent_mutex_);
+                    recent_ = *state;
+                }
+                slot_.publish(std::move(state));
+            }
+        }
+
+    public:
+        explicit Server(std::chrono::milliseconds tick) : tick_(tick), thread_([this]() { run(); }) {}
+
+        ~Server() {
+            running_.store(false);
+            thread_.join();
+        }
+
+        void send(uint64_t press) { sent_press_.store(press); }
+        std::unique_ptr<State> take() { return slot_.take(); }
+
+        State recent() {
+            std::lock_guard<std::mutex> lock(recent_mutex_);
+            return recent_;
+        }
+    };
+
+    // Stands in for building and drawing the frame, which takes time on the render thread either way
+    void draw(double ms) {
+        Clock::time_point until = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double, std::milli>(ms));
+        while (Clock::now() < until) {
+        }
+    }
+
+    void run(Loop loop, const Options& options, LatencyHistogram& latency) {
+        std::mt19937 generator(options.seed);
+        std::uniform_int_distribution<int> gap_ms(250, 750);
+        const std::chrono::milliseconds tick(options.tick_ms);
+        const Clock::duration frame_interval = loop == Loop::SLEEP
+            ? Clock::duration(std::chrono::milliseconds(200))
+            : std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60));
+
+        Server server(tick);
+        State shown;
+        uint64_t press = 0; // The last key press made
+        bool pending = false; // Whether it has yet to show up in a frame
+        Clock::time_point pressed_at = Clock::now() + std::chrono::milliseconds(gap_ms(generator));
+        Clock::time_point frame_start = Clock::now();
+        Clock::duration elapsed(0); // How long the last update() took, the sleep loop slept for the rest
+
+        while (static_cast<int>(latency.count()) < options.presses) {
+            // Key events are handled between frames, a press during the last frame waits until now
+            if (!pending && Clock::now() >= pressed_at) {
+                ++press;
+                pending = true;
+                server.send(press);
+            }
+
+            if (loop == Loop::SLEEP) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200) - elapsed);
+                Clock::time_point update_start = Clock::now();
+                shown = server.recent();
+                elapsed = Clock::now() - update_start;
+            } else {
+                std::unique_ptr<State> latest = server.take();
+                if (latest) {
+                    shown = *latest;
+                }
+            }
+            draw(options.draw_ms);
+
+            Clock::time_point presented = Clock::now();
+            if (pending && shown.applied_press == press) {
+                latency.add(presented - pressed_at);
+                pending = false;
+                pressed_at = presented + std::chrono::milliseconds(gap_ms(generator));
+            }
+
+            // The frame rate cap, openFrameworks sleeps out whatever is left of the frame
+            frame_start += frame_interval;
+            if (frame_start < presented) {
+                frame_start = presented;
+            }
+            std::this_thread::sleep_until(frame_start);
+        }
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--presses") {
+                options.presses = std::max(1, std::stoi(value));
+            } else if (flag == "--tick-ms") {
+                options.tick_ms = std::max(1, std::stoi(value));
+            } else if (flag == "--draw-ms") {
+                options.draw_ms = std::max(0.0, std::stod(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::printf("%d key presses per loop, server tick %d ms, %.1f ms to draw a frame\n", options.presses,
+                options.tick_ms, options.draw_ms);
+
+    LatencyHistogram sleep_latency;
+    run(Loop::SLEEP, options, sleep_latency);
+    std::printf("  sleep, 5 fps:       %s\n", sleep_latency.summary().c_str());
+
+    LatencyHistogram slot_latency;
+    run(Loop::SLOT, options, slot_latency);
+    std::printf("  LatestSlot, 60 fps: %s\n", slot_latency.summary().c_str());
+    return 0;
+}
@@ -0,0 +1,129 @@
+// Compares the two ways the client can read a JSON world state: json::parse() into a DOM followed by
+// from_json into the game structs, and JsonStateReader, which reads straight into them with the SAX interface.
+// Prints throughput in MB of JSON per second and time per cell, for boards of 10k to 1M cells.
+// Every SAX result is checked against the DOM one before anything is timed.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src json_ingest_bench.cpp ../src/json_state_reader.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp ../src/wire_codec.cpp -o json_ingest_bench
+// Run:
+//     ./json_ingest_bench [cells per timed run, default 5000000]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "json.hpp"
+#include "json_state_reader.h"
+#include "synthetic_world.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+using namespace snakelinkedlist::synthetic;
+using nlohmann::json;
+
+namespace {
+
+    // Every snake moved one cell, and one of them respawned with its whole body
+    WorldDelta makeRespawnDelta(const WorldSnapshot& board) {
+        WorldDelta delta = makeDelta(board);
+        SnakeDelta& respawned = delta.snakes.front();
+        respawned.has_head = false;
+        respawned.tail = 0;
+        respawned.has_body = true;
+        respawned.body = board.snakes.front().coords;
+        respawned.color = board.snakes.front().color;
+        respawned.direction = "W";
+        return delta;
+    }
+
+    bool sameKeyframe(const WorldSnapshot& a, const WorldSnapshot& b) {
+        if (a.tick != b.tick || a.food != b.food || a.snakes.size() != b.snakes.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.snakes.size(); ++i) {
+            const snakejson::snake& x = a.snakes[i];
+            const snakejson::snake& y = b.snakes[i];
+            if (x.id != y.id || x.length != y.length || x.alive != y.alive || x.direction != y.direction
+                || x.color != y.color || x.coords != y.coords) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool sameDelta(const WorldDelta& a, const WorldDelta& b) {
+        if (a.tick != b.tick || a.has_food != b.has_food || a.food != b.food || a.snakes.size() != b.snakes.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.snakes.size(); ++i) {
+            const SnakeDelta& x = a.snakes[i];
+            const SnakeDelta& y = b.snakes[i];
+            if (x.id != y.id || x.has_head != y.has_head || (x.has_head && x.head != y.head) || x.tail != y.tail
+                || x.grown != y.grown || x.died != y.died || x.gone != y.gone || x.direction != y.direction || x.has_body != y.has_body
+                || (x.has_body && (x.body != y.body || x.color != y.color))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void row(const char* name, std::size_t bytes, double ns, std::size_t cells) {
+        std::printf("  %-14s %10zu bytes %9.1f us %8.1f MB/s %7.2f ns/cell\n", name, bytes, ns / 1000,
+                    bytes / ns * 1000, ns / cells);
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double cells_per_run = (argc > 1) ? std::atof(argv[1]) : 5e6;
+    std::mt19937 generator(7);
+
+    const int kBoards[][2] = {{100, 100}, {1000, 100}, {1000, 1000}};
+    for (const auto& shape : kBoards) {
+        int snakes = shape[0];
+        int length = shape[1];
+        WorldSnapshot board = makeBoard(1000, snakes, length, 50, generator);
+        WorldDelta delta = makeRespawnDelta(board);
+        std::size_t cells = static_cast<std::size_t>(snakes) * length + board.food.size();
+        std::size_t delta_cells = delta.snakes.size() - 1 + delta.snakes.front().body.size();
+        std::string keyframe_text = keyframeToJson(board).dump();
+        std::string delta_text = json(delta).dump();
+
+        JsonStateReader reader;
+        if (reader.read(keyframe_text.data(), keyframe_text.size(), 0) != JsonStateReader::Kind::KEYFRAME
+            || !sameKeyframe(reader.keyframe(), *parseWorldSnapshot(json::parse(keyframe_text), 0, 0))) {
+            std::fprintf(stderr, "SAX keyframe differs from the DOM one\n");
+            return 1;
+        }
+        if (reader.read(delta_text.data(), delta_text.size(), 0) != JsonStateReader::Kind::DELTA
+            || !sameDelta(reader.delta(), json::parse(delta_text).get<WorldDelta>())) {
+            std::fprintf(stderr, "SAX delta differs from the DOM one\n");
+            return 1;
+        }
+
+        int iterations = std::max(3, static_cast<int>(cells_per_run / cells));
+        double dom_keyframe_ns = nanosPerCall(iterations, [&]() {
+            parseWorldSnapshot(json::parse(keyframe_text), 1, 0);
+        });
+        double sax_keyframe_ns = nanosPerCall(iterations, [&]() {
+            reader.read(keyframe_text.data(), keyframe_text.size(), 0);
+        });
+        int delta_iterations = std::max(3, static_cast<int>(cells_per_run / delta_cells));
+        double dom_delta_ns = nanosPerCall(delta_iterations, [&]() {
+            json::parse(delta_text).get<WorldDelta>();
+        });
+        double sax_delta_ns = nanosPerCall(delta_iterations, [&]() {
+            reader.read(delta_text.data(), delta_text.size(), 0);
+        });
+
+        std::printf("%d snakes of length %d (%zu cells)\n", snakes, length, cells);
+        row("dom keyframe", keyframe_text.size(), dom_keyframe_ns, cells);
+        row("sax keyframe", keyframe_text.size(), sax_keyframe_ns, cells);
+        // A delta has a head per snake and the body of the one that respawned
+        row("dom delta", delta_text.size(), dom_delta_ns, delta_cells);
+        row("sax delta", delta_text.size(), sax_delta_ns, delta_cells);
+    }
+    return 0;
+}
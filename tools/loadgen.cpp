@@ -0,0 +1,337 @@
+// Load generator: many virtual clients against one server, to see how it copes with a crowd.
+// Each virtual client is a ServerConnection from src/server_connection.h, the same connection the game
+// uses, steering its own snake id with a scripted W/A/S/D/R sequence. All clients share a few io_contexts
+// that are run by a fixed pool of threads, so 10,000 clients cost 10,000 sockets but not 10,000 threads.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src loadgen.cpp ../src/server_connection.cpp ../src/frame_decoder.cpp ../src/wire_codec.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp -o loadgen -lboost_system -pthread
+// Run:
+//     ./loadgen [--host 127.0.0.1] [--port 49145] [--clients 100] [--threads n] [--contexts 1]
+//               [--seconds 10] [--action-ms 200] [--script WDSAR] [--connect-rate 1000] [--binary 1]
+//
+// Send latency is the round trip from writing a command to reading the server's {"ack": seq} for it.
+// Receive latency is how long after the first client got a world state the others got the same tick,
+// which is the time the server takes to fan one tick out to everyone plus the time we take to read it.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include "json.hpp"
+#include "latency_histogram.h"
+#include "server_connection.h"
+#include "wire_codec.h"
+
+using boost::asio::ip::tcp;
+using nlohmann::json;
+using snakelinkedlist::LatencyHistogram;
+using snakelinkedlist::ServerConnection;
+
+namespace {
+
+    const int kMaxClients = 10000;
+    const std::size_t kTicksRemembered = 64; // Ticks still being fanned out, far more than are ever in flight
+    const std::size_t kCommandsRemembered = 256; // Commands per client awaiting an ack
+    const std::chrono::seconds kReportEvery(1);
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options {
+        std::string host = "127.0.0.1";
+        std::string port = "49145";
+        int clients = 100;
+        int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        int contexts = 1;
+        double seconds = 10;
+        int action_ms = 200;
+        std::string script = "WDSAR";
+        int connect_rate = 1000; // New connections per second, so the server's accept backlog does not overflow
+        bool binary = true;
+        uint32_t first_id = 1;
+    };
+
+    int64_t nanosSinceEpoch(Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    // When each tick first reached any of the clients, shared by all of them
+    class TickArrivals {
+    private:
+        struct Entry {
+            uint64_t tick = 0;
+            Clock::time_point first;
+        };
+        std::mutex mutex_;
+        std::array<Entry, kTicksRemembered> entries_;
+
+    public:
+        // How long after the first client this one received the tick, zero for the first
+        Clock::duration lag(uint64_t tick, Clock::time_point received_at) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Entry& entry = entries_[tick % kTicksRemembered];
+            if (entry.tick != tick) {
+                entry.tick = tick;
+                entry.first = received_at;
+                return Clock::duration::zero();
+            }
+            return received_at - entry.first;
+        }
+    };
+
+    // Everything the clients count, updated from every pool thread at once
+    struct LoadStats {
+        std::atomic<uint64_t> connected{0};
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> bytes_received{0};
+        std::atomic<uint64_t> acks{0};
+        std::atomic<uint64_t> undecodable{0};
+        LatencyHistogram send_latency;
+        LatencyHistogram receive_latency;
+        TickArrivals arrivals;
+    };
+
+    class VirtualClient {
+    private:
+        const Options& options_;
+        LoadStats& stats_;
+        uint32_t id_;
+        boost::asio::steady_timer timer_;
+        std::unique_ptr<ServerConnection> connection_;
+        std::size_t script_position_;
+        uint64_t seq_ = 0; // Timer handler only
+
+        // When each command still awaiting its ack was sent, indexed by seq. Written by the timer handler
+        // and read by the message handler, which may run on different pool threads.
+        std::array<std::atomic<int64_t>, kCommandsRemembered> sent_at_;
+
+        void onConnected() {
+            stats_.connected.fetch_add(1, std::memory_order_relaxed);
+            if (options_.binary) {
+                json hello;
+                hello["id"] = id_;
+                hello["action"] = std::string("HELLO");
+                hello["wire"] = {snakelinkedlist::kWireBinaryName, snakelinkedlist::kWireJsonName};
+                hello["frame"] = {snakelinkedlist::kFrameLongName};
+                connection_->send(hello);
+            }
+        }
+
+        void onMessage(const char* data, std::size_t size) {
+            Clock::time_point now = Clock::now();
+            stats_.received.fetch_add(1, std::memory_order_relaxed);
+            std::size_t header = size > ServerConnection::kMaxBodyLength ? ServerConnection::kLongHeaderLength
+                                                                          : ServerConnection::kHeaderLength;
+            stats_.bytes_received.fetch_add(size + header, std::memory_order_relaxed);
+            try {
+                if (snakelinkedlist::isWireMessage(data, size)) {
+                    stats_.receive_latency.add(stats_.arrivals.lag(snakelinkedlist::wireMessageTick(data, size), now));
+                    return;
+                }
+                json message = json::parse(data, data + size);
+                auto ack = message.find("ack");
+                if (ack != message.end()) {
+                    uint64_t seq = ack->get<uint64_t>();
+                    int64_t sent_at = sent_at_[seq % kCommandsRemembered].exchange(0, std::memory_order_relaxed);
+                    if (sent_at != 0) {
+                        stats_.send_latency.add(std::chrono::nanoseconds(nanosSinceEpoch(now) - sent_at));
+                    }
+                    stats_.acks.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                auto tick = message.find("tick");
+                if (tick != message.end()) {
+                    stats_.receive_latency.add(stats_.arrivals.lag(tick->get<uint64_t>(), now));
+                }
+            } catch (std::exception&) {
+                stats_.undecodable.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void scheduleAction(Clock::duration delay) {
+            timer_.expires_after(delay);
+            timer_.async_wait([this](const boost::system::error_code& error) {
+                if (error) {
+                    return;
+                }
+                sendAction();
+                scheduleAction(std::chrono::milliseconds(options_.action_ms));
+            });
+        }
+
+        void sendAction() {
+            char action = options_.script[script_position_++ % options_.script.size()];
+            uint64_t seq = ++seq_;
+            json command;
+            command["id"] = id_;
+            command["action"] = std::string(1, action);
+            command["seq"] = seq;
+            sent_at_[seq % kCommandsRemembered].store(nanosSinceEpoch(Clock::now()), std::memory_order_relaxed);
+            connection_->send(command);
+            stats_.sent.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    public:
+        VirtualClient(boost::asio::io_context& io_context, const Options& options, LoadStats& stats, uint32_t id)
+            : options_(options), stats_(stats), id_(id), timer_(io_context), script_position_(id) {
+            for (std::atomic<int64_t>& sent_at : sent_at_) {
+                sent_at.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        VirtualClient(const VirtualClient&) = delete;
+        VirtualClient& operator=(const VirtualClient&) = delete;
+
+        // Connects and starts sending once connected, call from the thread that created the client
+        void start(boost::asio::io_context& io_context, const tcp::resolver::results_type& endpoints) {
+            connection_ = std::make_unique<ServerConnection>(io_context, endpoints,
+                [this](const char* data, std::size_t size) { this->onMessage(data, size); },
+                [this]() { this->onConnected(); });
+            connection_->start();
+            // Spread the first actions over one action period, so clients do not all send in the same instant
+            scheduleAction(std::chrono::milliseconds(options_.action_ms * (id_ % 16) / 16 + 1));
+        }
+
+        void stop() {
+            timer_.cancel();
+            if (connection_) {
+                connection_->close();
+            }
+        }
+    };
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--host") {
+                options.host = value;
+            } else if (flag == "--port") {
+                options.port = value;
+            } else if (flag == "--clients") {
+                options.clients = std::max(1, std::min(kMaxClients, std::stoi(value)));
+            } else if (flag == "--threads") {
+                options.threads = std::max(1, std::stoi(value));
+            } else if (flag == "--contexts") {
+                options.contexts = std::max(1, std::stoi(value));
+            } else if (flag == "--seconds") {
+                options.seconds = std::stod(value);
+            } else if (flag == "--action-ms") {
+                options.action_ms = std::max(1, std::stoi(value));
+            } else if (flag == "--script") {
+                options.script = value;
+            } else if (flag == "--connect-rate") {
+                options.connect_rate = std::max(1, std::stoi(value));
+            } else if (flag == "--binary") {
+                options.binary = std::stoi(value) != 0;
+            } else if (flag == "--first-id") {
+                options.first_id = static_cast<uint32_t>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        options.contexts = std::min(options.contexts, options.threads);
+        if (options.script.empty()) {
+            options.script = "WDSAR";
+        }
+        return options;
+    }
+
+    void report(LoadStats& stats, uint64_t& last_sent, uint64_t& last_received, uint64_t& last_bytes, double seconds) {
+        uint64_t sent = stats.sent.load(std::memory_order_relaxed);
+        uint64_t received = stats.received.load(std::memory_order_relaxed);
+        uint64_t bytes = stats.bytes_received.load(std::memory_order_relaxed);
+        std::printf("%6llu connected, %9.0f sent/s, %9.0f received/s, %7.2f MB/s in, ack p99 %.2fms, fan-out p99 %.2fms\n",
+                    static_cast<unsigned long long>(stats.connected.load(std::memory_order_relaxed)),
+                    (sent - last_sent) / seconds, (received - last_received) / seconds, (bytes - last_bytes) / seconds / 1e6,
+                    stats.send_latency.percentileMs(0.99), stats.receive_latency.percentileMs(0.99));
+        std::fflush(stdout);
+        last_sent = sent;
+        last_received = received;
+        last_bytes = bytes;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::printf("%d clients on %d threads sharing %d io_context(s), one action every %dms, %s world states\n",
+                options.clients, options.threads, options.contexts, options.action_ms, options.binary ? "binary" : "JSON");
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts;
+    std::vector<std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>> work;
+    for (int i = 0; i < options.contexts; ++i) {
+        contexts.push_back(std::make_unique<boost::asio::io_context>());
+        work.push_back(std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+            contexts.back()->get_executor()));
+    }
+
+    tcp::resolver resolver(*contexts.front());
+    tcp::resolver::results_type endpoints = resolver.resolve(options.host, options.port);
+
+    LoadStats stats;
+    std::vector<std::thread> pool;
+    for (int i = 0; i < options.threads; ++i) {
+        boost::asio::io_context& io_context = *contexts[i % contexts.size()];
+        pool.emplace_back([&io_context]() { io_context.run(); });
+    }
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    Clock::time_point next_report = start + kReportEvery;
+    uint64_t last_sent = 0, last_received = 0, last_bytes = 0;
+
+    // Clients are created here and connect at the configured rate, the pool threads do everything else
+    std::vector<std::unique_ptr<VirtualClient>> clients;
+    clients.reserve(options.clients);
+    while (Clock::now() < end) {
+        Clock::time_point now = Clock::now();
+        auto due = static_cast<std::size_t>(std::chrono::duration<double>(now - start).count() * options.connect_rate) + 1;
+        while (clients.size() < std::min<std::size_t>(due, options.clients)) {
+            boost::asio::io_context& io_context = *contexts[clients.size() % contexts.size()];
+            uint32_t id = options.first_id + static_cast<uint32_t>(clients.size());
+            clients.push_back(std::make_unique<VirtualClient>(io_context, options, stats, id));
+            clients.back()->start(io_context, endpoints);
+        }
+        if (now >= next_report) {
+            report(stats, last_sent, last_received, last_bytes,
+                   std::chrono::duration<double>(kReportEvery).count());
+            next_report += kReportEvery;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(clients.size() < static_cast<std::size_t>(options.clients) ? 1 : 10));
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (std::unique_ptr<VirtualClient>& client : clients) {
+        client->stop();
+    }
+    for (std::size_t i = 0; i < contexts.size(); ++i) {
+        work[i].reset();
+        contexts[i]->stop();
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    std::printf("\n%zu clients, %llu connected, %.1f s\n", clients.size(),
+                static_cast<unsigned long long>(stats.connected.load()), elapsed);
+    std::printf("sent     %10llu commands (%.0f/s), %llu acked\n", static_cast<unsigned long long>(stats.sent.load()),
+                stats.sent.load() / elapsed, static_cast<unsigned long long>(stats.acks.load()));
+    std::printf("received %10llu messages (%.0f/s, %.2f MB/s), %llu undecodable\n",
+                static_cast<unsigned long long>(stats.received.load()), stats.received.load() / elapsed,
+                stats.bytes_received.load() / elapsed / 1e6, static_cast<unsigned long long>(stats.undecodable.load()));
+    std::printf("send latency (command to ack):   %s\n", stats.send_latency.summary().c_str());
+    std::printf("receive latency (tick fan-out):  %s\n", stats.receive_latency.summary().c_str());
+    return 0;
+}
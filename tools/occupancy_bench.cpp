@@ -0,0 +1,218 @@
+// Stress test for collision detection with hundreds of snakes on a large board. The same seeded
+// world is run twice, once asking the shared OccupancyGrid in src/occupancy_grid.h whether the cell
+// a head moves into is free, and once scanning every live snake's body the way Snake::isDead() used
+// to scan its own.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src occupancy_bench.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/snakebody.cpp -o occupancy_bench
+// Run:
+//     ./occupancy_bench [--width 1000] [--height 1000] [--ticks 200] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "occupancy_grid.h"
+#include "snakebody.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    struct Options {
+        int width = 1000;
+        int height = 1000;
+        int ticks = 200;
+        unsigned seed = 1;
+    };
+
+    struct BenchSnake {
+        OccupancyGrid::Owner id;
+        SnakeBodyRing body;
+        int direction = 0; // Index into kSteps
+        bool alive = false;
+    };
+
+    const GridCell kSteps[] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}};
+
+    // Every snake wanders, growing until it reaches its target length and respawning when it dies
+    class World {
+    private:
+        bool use_grid_ = true;
+        const std::size_t target_length_;
+        std::mt19937 generator_;
+        OccupancyGrid grid_;
+        std::vector<BenchSnake> snakes_;
+
+        std::size_t checks_ = 0;
+        std::size_t deaths_ = 0;
+
+        // The scan every snake would have to do without a shared grid
+        bool scanOccupied(const GridCell& cell) const {
+            if (!grid_.contains(cell)) {
+                return true;
+            }
+            for (const BenchSnake& s : snakes_) {
+                if (!s.alive) {
+                    continue;
+                }
+                for (const GridCell& c : s.body) {
+                    if (c == cell) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool occupied(const GridCell& cell) {
+            ++checks_;
+            return use_grid_ ? !grid_.isFree(cell) : scanOccupied(cell);
+        }
+
+        void spawn(BenchSnake& s) {
+            std::uniform_int_distribution<> x(0, grid_.width() - 1);
+            std::uniform_int_distribution<> y(0, grid_.height() - 1);
+            GridCell cell{x(generator_), y(generator_)};
+            while (!grid_.isFree(cell)) {
+                cell = GridCell{x(generator_), y(generator_)};
+            }
+            s.body.clear();
+            s.body.pushHead(cell);
+            s.direction = generator_() % 4;
+            s.alive = true;
+            grid_.occupy(cell, s.id);
+        }
+
+        void kill(BenchSnake& s) {
+            for (const GridCell& c : s.body) {
+                grid_.release(c, s.id);
+            }
+            s.alive = false;
+            ++deaths_;
+        }
+
+    public:
+        World(const Options& options, int snakes, std::size_t target_length)
+            : target_length_(target_length), generator_(options.seed),
+              grid_(options.width, options.height) {
+            snakes_.resize(snakes);
+            for (int i = 0; i < snakes; ++i) {
+                snakes_[i].id = static_cast<OccupancyGrid::Owner>(i + 1);
+                spawn(snakes_[i]);
+            }
+        }
+
+        void tick() {
+            for (BenchSnake& s : snakes_) {
+                if (!s.alive) {
+                    spawn(s);
+                    continue;
+                }
+                if (generator_() % 8 == 0) {
+                    int turn = generator_() % 4;
+                    if ((turn ^ 1) != s.direction) {
+                        s.direction = turn;
+                    }
+                }
+
+                GridCell head = s.body.head();
+                head.x += kSteps[s.direction].x;
+                head.y += kSteps[s.direction].y;
+                if (s.body.size() >= target_length_) {
+                    grid_.release(s.body.tail(), s.id);
+                    s.body.popTail();
+                }
+                if (occupied(head)) {
+                    kill(s);
+                    continue;
+                }
+                s.body.pushHead(head);
+                grid_.occupy(head, s.id);
+            }
+        }
+
+        // Both ways give the same answers, so switching doesn't change how the world plays out
+        void useGrid(bool use_grid) { use_grid_ = use_grid; }
+
+        std::size_t checks() const { return checks_; }
+        std::size_t deaths() const { return deaths_; }
+        std::size_t occupiedCells() const { return grid_.occupied(); }
+    };
+
+    struct Result {
+        double tick_us;
+        double move_ns; // Per snake per tick, the collision check plus everything around it
+        std::size_t deaths;
+        std::size_t cells;
+    };
+
+    Result run(const Options& options, int snakes, std::size_t length, bool use_grid, int ticks) {
+        World world(options, snakes, length);
+        // Let the snakes grow out before timing so the scan sees full length bodies
+        for (std::size_t i = 0; i < length; ++i) {
+            world.tick();
+        }
+        world.useGrid(use_grid);
+        std::size_t checks_before = world.checks();
+        std::size_t deaths_before = world.deaths();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ticks; ++i) {
+            world.tick();
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        Result result;
+        result.tick_us = us / ticks;
+        result.move_ns = us * 1000.0 / std::max<std::size_t>(1, world.checks() - checks_before);
+        result.deaths = world.deaths() - deaths_before;
+        result.cells = world.occupiedCells();
+        return result;
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--width") {
+                options.width = std::stoi(value);
+            } else if (flag == "--height") {
+                options.height = std::stoi(value);
+            } else if (flag == "--ticks") {
+                options.ticks = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    std::printf("%dx%d board, %d timed ticks\n", options.width, options.height, options.ticks);
+    std::printf("%7s %7s %10s %12s %12s %12s %12s %8s\n", "snakes", "length", "cells", "grid us/tick", "grid ns/move",
+                "scan us/tick", "scan ns/move", "deaths");
+
+    const int snake_counts[] = {100, 300, 1000};
+    const std::size_t lengths[] = {10, 100, 1000};
+    for (int snakes : snake_counts) {
+        for (std::size_t length : lengths) {
+            Result grid = run(options, snakes, length, true, options.ticks);
+            // The scan is quadratic in the number of cells, keep its runs to a bearable length
+            int scan_ticks = std::max(1, static_cast<int>(options.ticks * 1000 / (snakes * length)));
+            Result scan = run(options, snakes, length, false, std::min(options.ticks, scan_ticks));
+            std::printf("%7d %7zu %10zu %12.1f %12.1f %12.1f %12.1f %8zu\n", snakes, length, grid.cells, grid.tick_us,
+                        grid.move_ns, scan.tick_us, scan.move_ns, grid.deaths);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Reads the world states a client started with --share publishes in shared memory (src/shared_world.h), the way
+// a spectator display, recorder or bot on the same machine would, without a connection of its own.
+// Each of --readers threads attaches on its own, as a separate process would, and keeps picking up the newest
+// state. It prints how many states the readers got, how many went by unread because a newer one was there first
+// or had to be read again, how old a state was when it was read and how long decoding it took.
+// A reader that hears nothing new for two seconds attaches again, in case the client was restarted.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src shared_world_reader.cpp ../src/shared_world.cpp ../src/wire_codec.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp -o shared_world_reader -lrt -pthread
+// Run:
+//     ./shared_world_reader [--name snake-world] [--readers 4] [--seconds 10] [--poll-us 500]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "shared_world.h"
+#include "wire_codec.h"
+#include "world_snapshot.h"
+
+using snakelinkedlist::LatencyHistogram;
+using snakelinkedlist::SharedWorldError;
+using snakelinkedlist::SharedWorldReader;
+using snakelinkedlist::WorldSnapshot;
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    const std::chrono::seconds kReportEvery(1);
+    const std::chrono::seconds kReattachAfter(2);
+    const std::chrono::milliseconds kAttachRetry(500);
+
+    struct Options {
+        std::string name = "snake-world";
+        int readers = 4;
+        double seconds = 10;
+        int poll_us = 500;
+    };
+
+    // Shared by every reader thread
+    struct ReadStats {
+        std::atomic<uint64_t> states{0};
+        std::atomic<uint64_t> missed{0};
+        std::atomic<uint64_t> torn{0};
+        std::atomic<uint64_t> attaches{0};
+        std::atomic<uint64_t> newest_tick{0};
+        std::atomic<uint64_t> cells{0}; // Food and snake cells in the last state any reader got
+        LatencyHistogram age; // From when the client published a state until a reader had decoded it
+        LatencyHistogram decode;
+    };
+
+    void readLoop(const Options& options, ReadStats& stats, const std::atomic<bool>& stop) {
+        std::unique_ptr<SharedWorldReader> reader;
+        WorldSnapshot snapshot;
+        Clock::time_point last_state = Clock::now();
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (!reader) {
+                try {
+                    reader = std::make_unique<SharedWorldReader>(options.name);
+                    stats.attaches.fetch_add(1, std::memory_order_relaxed);
+                    last_state = Clock::now();
+                } catch (SharedWorldError&) {
+                    std::this_thread::sleep_for(kAttachRetry);
+                    continue;
+                }
+            }
+
+            uint64_t missed = reader->missed();
+            uint64_t torn = reader->torn();
+            int64_t published_ns = 0;
+            auto start = Clock::now();
+            SharedWorldReader::Result result = reader->readLatest([&](const char* data, std::size_t size, uint64_t, int64_t at) {
+                snakelinkedlist::decodeKeyframe(data, size, snapshot);
+                published_ns = at;
+            });
+            Clock::time_point now = Clock::now();
+            stats.missed.fetch_add(reader->missed() - missed, std::memory_order_relaxed);
+            stats.torn.fetch_add(reader->torn() - torn, std::memory_order_relaxed);
+
+            if (result == SharedWorldReader::Result::STATE) {
+                stats.states.fetch_add(1, std::memory_order_relaxed);
+                stats.decode.add(now - start);
+                stats.age.add(now.time_since_epoch() - std::chrono::nanoseconds(published_ns));
+                stats.newest_tick.store(snapshot.tick, std::memory_order_relaxed);
+                std::size_t cells = snapshot.food.size();
+                for (const snakelinkedlist::snakejson::snake& s : snapshot.snakes) {
+                    cells += s.coords.size();
+                }
+                stats.cells.store(cells, std::memory_order_relaxed);
+                last_state = now;
+            } else if (now - last_state > kReattachAfter) {
+                reader.reset();
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(options.poll_us));
+        }
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--name") {
+                options.name = value;
+            } else if (flag == "--readers") {
+                options.readers = std::max(1, std::stoi(value));
+            } else if (flag == "--seconds") {
+                options.seconds = std::stod(value);
+            } else if (flag == "--poll-us") {
+                options.poll_us = std::max(0, std::stoi(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    ReadStats stats;
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < options.readers; ++i) {
+        readers.emplace_back([&]() { readLoop(options, stats, stop); });
+    }
+
+    Clock::time_point started = Clock::now();
+    Clock::time_point end = started + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds));
+    uint64_t last_states = 0;
+    while (Clock::now() < end) {
+        std::this_thread::sleep_for(kReportEvery);
+        uint64_t states = stats.states.load(std::memory_order_relaxed);
+        std::printf("tick %8llu, %7llu cells, %6.0f states/s over %d readers, age p50 %.3fms p99 %.3fms, decode p50 %.3fms\n",
+                    static_cast<unsigned long long>(stats.newest_tick.load(std::memory_order_relaxed)),
+                    static_cast<unsigned long long>(stats.cells.load(std::memory_order_relaxed)),
+                    double(states - last_states) / std::chrono::duration<double>(kReportEvery).count(), options.readers,
+                    stats.age.percentileMs(0.5), stats.age.percentileMs(0.99), stats.decode.percentileMs(0.5));
+        std::fflush(stdout);
+        last_states = states;
+    }
+    stop.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::printf("\n%d readers, %.1f s, attached %llu times\n", options.readers, options.seconds,
+                static_cast<unsigned long long>(stats.attaches.load()));
+    std::printf("read       %llu states, %llu went by unread, %llu reads the writer got in the way of\n",
+                static_cast<unsigned long long>(stats.states.load()), static_cast<unsigned long long>(stats.missed.load()),
+                static_cast<unsigned long long>(stats.torn.load()));
+    std::printf("age:    %s\n", stats.age.summary().c_str());
+    std::printf("decode: %s\n", stats.decode.summary().c_str());
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Runs the simulation engine in src/sim_engine.h headless and uncapped with 10 to 10,000 snakes, on a board
+// with about 400 cells per snake, and prints ticks per second for the world alone and for the world plus
+// encoding every tick as the JSON the client reads (a delta each tick and a keyframe every 50, like
+// standin_server --format delta). Each size is run twice from the same seed and the two checksums are
+// compared, so a change that breaks determinism shows up here too.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src sim_bench.cpp ../src/sim_engine.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/snakebody.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/wire_codec.cpp -o sim_bench
+// Run:
+//     ./sim_bench [--ticks 1000] [--seed 1]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "json.hpp"
+#include "sim_engine.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    const int kKeyframeEvery = 50;
+
+    struct Options {
+        int ticks = 1000;
+        unsigned seed = 1;
+    };
+
+    struct Run {
+        double seconds = 0;
+        std::size_t bytes = 0; // JSON written, 0 if the run did not encode
+        uint64_t checksum = 0;
+    };
+
+    SimOptions boardFor(int snakes, unsigned seed) {
+        SimOptions sim;
+        sim.width = static_cast<int>(std::ceil(std::sqrt(snakes * 400.0)));
+        sim.height = sim.width;
+        sim.snakes = snakes;
+        sim.food = snakes / 2 + 5;
+        sim.seed = seed;
+        return sim;
+    }
+
+    Run run(const SimOptions& sim, int ticks, bool encode) {
+        SimEngine engine(sim);
+        Run result;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ticks; ++i) {
+            engine.tick();
+            if (encode) {
+                std::string body = engine.tickNumber() % kKeyframeEvery == 0
+                    ? keyframeToJson(engine.keyframe()).dump()
+                    : nlohmann::json(engine.delta()).dump();
+                result.bytes += body.size();
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.checksum = engine.checksum();
+        return result;
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--ticks") {
+                options.ticks = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", flag.c_str());
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    const int kSnakes[] = {10, 100, 1000, 10000};
+
+    std::printf("%d ticks per run\n", options.ticks);
+    std::printf("  %6s %11s %12s %14s %14s %12s %13s\n", "snakes", "board", "ticks/s", "snake steps/s",
+                "+json ticks/s", "json B/tick", "deterministic");
+    for (int snakes : kSnakes) {
+        SimOptions sim = boardFor(snakes, options.seed);
+        Run world = run(sim, options.ticks, false);
+        Run again = run(sim, options.ticks, false);
+        Run encoded = run(sim, options.ticks, true);
+        char board[32];
+        std::snprintf(board, sizeof(board), "%dx%d", sim.width, sim.height);
+        std::printf("  %6d %11s %12.0f %14.0f %14.0f %12.0f %13s\n", snakes, board, options.ticks / world.seconds,
+                    double(options.ticks) * snakes / world.seconds, options.ticks / encoded.seconds,
+                    double(encoded.bytes) / options.ticks,
+                    world.checksum == again.checksum && world.checksum == encoded.checksum ? "yes" : "NO");
+    }
+    return 0;
+}
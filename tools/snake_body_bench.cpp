@@ -0,0 +1,108 @@
+// Measures what moving and growing a snake costs as it gets longer, for the ring buffer body in
+// src/snakebody.h and for the linked list Snake used to have (every segment shifted forward on a
+// move, the whole list walked to find the tail on a grow).
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src snake_body_bench.cpp ../src/snakebody.cpp -o snake_body_bench
+// Run:
+//     ./snake_body_bench
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include "snakebody.h"
+
+using namespace snakelinkedlist;
+
+namespace {
+
+    // The old layout: one heap node per segment
+    struct ListNode {
+        ListNode* next;
+        GridCell position;
+    };
+
+    class ListSnake {
+    private:
+        ListNode* head_;
+
+    public:
+        explicit ListSnake(std::size_t length) {
+            head_ = new ListNode{nullptr, GridCell{0, 0}};
+            ListNode* tail = head_;
+            for (std::size_t i = 1; i < length; ++i) {
+                tail->next = new ListNode{nullptr, GridCell{-static_cast<int>(i), 0}};
+                tail = tail->next;
+            }
+        }
+
+        ~ListSnake() {
+            while (head_) {
+                ListNode* next = head_->next;
+                delete head_;
+                head_ = next;
+            }
+        }
+
+        void update() {
+            GridCell previous = head_->position;
+            for (ListNode* curr = head_->next; curr; curr = curr->next) {
+                GridCell old = curr->position;
+                curr->position = previous;
+                previous = old;
+            }
+            ++head_->position.x;
+        }
+
+        void eat() {
+            ListNode* last = head_;
+            while (last->next) {
+                last = last->next;
+            }
+            last->next = new ListNode{nullptr, GridCell{last->position.x - 1, last->position.y}};
+        }
+    };
+
+    SnakeBodyRing makeRing(std::size_t length) {
+        SnakeBodyRing ring;
+        for (std::size_t i = 0; i < length; ++i) {
+            ring.pushTail(GridCell{-static_cast<int>(i), 0});
+        }
+        return ring;
+    }
+
+    template <typename F>
+    double nanosPerOp(std::size_t ops, F&& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < ops; ++i) {
+            f();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops;
+    }
+} // namespace
+
+int main() {
+    std::printf("%10s %14s %14s %14s %14s\n", "length", "ring move ns", "ring eat ns", "list move ns", "list eat ns");
+    for (std::size_t length = 1; length <= 1000000; length *= 10) {
+        // Keep the linked list runs to roughly the same total amount of work at every length
+        std::size_t ring_ops = 1000000;
+        std::size_t list_ops = std::max<std::size_t>(20, 20000000 / length);
+
+        SnakeBodyRing ring = makeRing(length);
+        int x = 0;
+        double ring_move = nanosPerOp(ring_ops, [&]() {
+            ring.pushHead(GridCell{++x, 0});
+            ring.popTail();
+        });
+        double ring_eat = nanosPerOp(ring_ops, [&]() { ring.pushTail(GridCell{--x, 0}); });
+
+        ListSnake list(length);
+        double list_move = nanosPerOp(list_ops, [&]() { list.update(); });
+        double list_eat = nanosPerOp(std::min<std::size_t>(list_ops, 2000), [&]() { list.eat(); });
+
+        std::printf("%10zu %14.2f %14.2f %14.1f %14.1f\n", length, ring_move, ring_eat, list_move, list_eat);
+    }
+    return 0;
+}
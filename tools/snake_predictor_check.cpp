@@ -0,0 +1,167 @@
+// Checks src/snake_predictor.h without openFrameworks or a server: hand-made world states go to reconcile()
+// and advance() is called at chosen times, then the predicted snake is compared cell by cell with what the
+// server would do. It covers stepping one cell per tick up to the prediction limit, a turn steering the next
+// step, an unacknowledged turn being replayed after a rewind and dropped once acknowledged, turns straight back
+// being ignored, other snakes blocking the way and their old cells being freed by the next state, and the
+// prediction stopping while our snake is dead.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src snake_predictor_check.cpp ../src/snake_predictor.cpp ../src/grid_snake.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/snakebody.cpp ../src/world_snapshot.cpp -o snake_predictor_check
+// Run:
+//     ./snake_predictor_check
+// Exits with status 1 if any check failed.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "snake_predictor.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+using Cells = std::vector<std::pair<int, int>>;
+
+namespace {
+
+    const int kBoardSize = 20;
+    const uint32_t kOwnId = 5;
+    const uint32_t kOtherId = 7;
+    const std::chrono::milliseconds kTick(200);
+
+    int g_failures = 0;
+
+    void check(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("FAIL: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    snakejson::snake makeSnake(uint32_t id, const Cells& coords, const char* direction) {
+        snakejson::snake s;
+        s.id = static_cast<int>(id);
+        s.length = static_cast<int>(coords.size());
+        s.alive = true;
+        s.direction = direction;
+        s.color = {{0, 100, 0}};
+        s.coords = coords;
+        return s;
+    }
+
+    WorldSnapshot makeState(uint64_t tick, std::chrono::steady_clock::time_point received_at,
+                            const std::vector<snakejson::snake>& snakes, uint64_t acked_input = 0,
+                            std::chrono::steady_clock::time_point acked_at = std::chrono::steady_clock::time_point()) {
+        WorldSnapshot state;
+        state.tick = tick;
+        state.received_at = received_at;
+        state.snakes = snakes;
+        state.acked_input = acked_input;
+        state.acked_at = acked_at;
+        return state;
+    }
+
+    const std::pair<int, int>& head(const SnakePredictor& predictor) {
+        return predictor.predicted().coords.front();
+    }
+
+    // Our snake at (5, 5) heading right with two cells behind it
+    const Cells kStart = {{5, 5}, {4, 5}, {3, 5}};
+
+    void checkStepping(std::chrono::steady_clock::time_point t0) {
+        SnakePredictor predictor(kBoardSize, kBoardSize, kOwnId);
+        predictor.reconcile(makeState(10, t0, {makeSnake(kOwnId, kStart, "D")}));
+        check(predictor.active(), "a state with our live snake starts the prediction");
+        check(!predictor.advance(t0), "nothing moves before a tick has passed");
+        check(predictor.advance(t0 + kTick), "the snake moves once a tick has passed");
+        check(predictor.predicted().coords == Cells({{6, 5}, {5, 5}, {4, 5}}), "one tick moves the whole body one cell");
+        check(!predictor.advance(t0 + kTick), "the same time moves nothing again");
+        predictor.advance(t0 + kTick * 50);
+        check(head(predictor) == std::make_pair(5 + kMaxPredictedTicks, 5), "the prediction stops kMaxPredictedTicks ahead");
+    }
+
+    void checkReplay(std::chrono::steady_clock::time_point t0) {
+        SnakePredictor predictor(kBoardSize, kBoardSize, kOwnId);
+        predictor.reconcile(makeState(10, t0, {makeSnake(kOwnId, kStart, "D")}));
+        predictor.pressed('S', 1, t0 + std::chrono::milliseconds(50));
+        check(predictor.redundant('S'), "pressing the same key again in the same tick is redundant");
+        check(!predictor.redundant('W'), "a different key is not redundant");
+        predictor.advance(t0 + kTick);
+        check(head(predictor) == std::make_pair(5, 6), "a turn steers the next step");
+
+        // The server has not applied the turn yet, so it is replayed on top of its state
+        predictor.reconcile(makeState(11, t0 + kTick, {makeSnake(kOwnId, {{6, 5}, {5, 5}, {4, 5}}, "D")}));
+        check(head(predictor) == std::make_pair(6, 5), "reconcile rewinds to the server's snake");
+        predictor.advance(t0 + kTick * 2);
+        check(head(predictor) == std::make_pair(6, 6), "an unacknowledged turn is replayed after the rewind");
+        check(predictor.stats().replayed_inputs == 1, "the replayed turn is counted");
+
+        // Now it has, and the acknowledgement 300 ms after the press gives the round trip
+        predictor.reconcile(makeState(12, t0 + kTick * 2, {makeSnake(kOwnId, {{6, 6}, {6, 5}, {5, 5}}, "S")}, 1,
+                                      t0 + std::chrono::milliseconds(350)));
+        check(std::fabs(predictor.stats().round_trip_ms - 300) < 0.5, "the acknowledgement measures the round trip");
+        check(!predictor.redundant('S'), "an acknowledged press is no longer pending");
+        predictor.advance(t0 + kTick * 2);
+        check(head(predictor) == std::make_pair(6, 7), "the prediction runs a round trip ahead of the last state");
+        check(predictor.stats().replayed_inputs == 1, "an acknowledged turn is not replayed");
+        check(predictor.stats().compared == 2 && predictor.stats().corrections == 1,
+              "only the tick predicted without the server's turn needed a correction");
+    }
+
+    void checkOppositeTurn(std::chrono::steady_clock::time_point t0) {
+        SnakePredictor predictor(kBoardSize, kBoardSize, kOwnId);
+        predictor.reconcile(makeState(10, t0, {makeSnake(kOwnId, kStart, "D")}));
+        predictor.pressed('A', 1, t0);
+        predictor.advance(t0 + kTick);
+        check(head(predictor) == std::make_pair(6, 5), "a turn straight back into the neck is ignored");
+    }
+
+    void checkOthers(std::chrono::steady_clock::time_point t0) {
+        SnakePredictor predictor(kBoardSize, kBoardSize, kOwnId);
+        snakejson::snake wall = makeSnake(kOtherId, {{7, 5}, {7, 4}, {7, 3}}, "S");
+        predictor.reconcile(makeState(10, t0, {makeSnake(kOwnId, kStart, "D"), wall}));
+        predictor.advance(t0 + kTick * 3);
+        check(head(predictor) == std::make_pair(7, 5), "running into another snake stops the prediction there");
+
+        // The other snake has gone elsewhere, the cells it had must not block us any more
+        wall.coords = {{15, 15}, {15, 14}, {15, 13}};
+        predictor.reconcile(makeState(11, t0 + kTick, {makeSnake(kOwnId, {{6, 5}, {5, 5}, {4, 5}}, "D"), wall}));
+        predictor.advance(t0 + kTick * 4);
+        check(head(predictor) == std::make_pair(9, 5), "cells other snakes left are free in the next state");
+    }
+
+    void checkDeath(std::chrono::steady_clock::time_point t0) {
+        SnakePredictor predictor(kBoardSize, kBoardSize, kOwnId);
+        predictor.reconcile(makeState(10, t0, {makeSnake(kOwnId, kStart, "D")}));
+        predictor.pressed('S', 1, t0);
+
+        snakejson::snake dead = makeSnake(kOwnId, kStart, "D");
+        dead.alive = false;
+        predictor.reconcile(makeState(11, t0 + kTick, {dead}));
+        check(!predictor.active(), "a dead snake is not predicted");
+        check(!predictor.advance(t0 + kTick * 3), "advance does nothing while our snake is dead");
+        check(!predictor.redundant('S'), "presses from before the death are dropped");
+
+        predictor.reconcile(makeState(12, t0 + kTick * 2, {makeSnake(kOwnId, {{2, 2}}, "D")}));
+        predictor.advance(t0 + kTick * 3);
+        check(head(predictor) == std::make_pair(3, 2), "the prediction starts again from the respawned snake");
+        check(std::fabs(predictor.stats().tick_interval_ms - 200) < 0.5, "states 200 ms apart measure a 200 ms tick");
+    }
+} // namespace
+
+int main() {
+    auto t0 = std::chrono::steady_clock::now();
+    checkStepping(t0);
+    checkReplay(t0);
+    checkOppositeTurn(t0);
+    checkOthers(t0);
+    checkDeath(t0);
+
+    if (g_failures > 0) {
+        std::printf("FAIL: %d checks failed\n", g_failures);
+        return 1;
+    }
+    std::printf("OK: the prediction stepped, replayed and reconciled as the server would\n");
+    return 0;
+}
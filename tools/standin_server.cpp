@@ -0,0 +1,608 @@
+// Local stand-in for the game server, so the client can be exercised without the real one.
+// It runs the deterministic snake world in src/sim_engine.h and broadcasts it to every connected client
+// each tick, either as full keyframes or as deltas with a keyframe every --keyframe-every ticks.
+// --tick-ms 0 ticks as fast as the world and the clients keep up.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src standin_server.cpp ../src/frame_decoder.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp ../src/wire_codec.cpp ../src/occupancy_grid.cpp ../src/free_cell_set.cpp ../src/sim_engine.cpp -o standin_server -lboost_system -pthread
+// Run:
+//     ./standin_server [--port 49145] [--snakes 8] [--width 48] [--height 27] [--food 5]
+//                      [--tick-ms 200] [--format full|delta] [--keyframe-every 50] [--seed 1] [--fragment 0]
+//
+// Messages are framed like chat_message.hpp: a 4 character decimal body length followed by the body.
+// A client that offers {"frame": ["u32"]} in its HELLO is answered with {"frame": "u32"}, and from then on
+// a world state longer than 9999 bytes comes with a long header, "####" and a u32 little endian length.
+// Such a state is dropped for every other client, and counted in the report.
+// Clients steer with the usual {"id": n, "action": "W"|"A"|"S"|"D"|"R"} commands. A client that sends
+// {"action": "HELLO", "wire": ["binary/1", ...]} is answered with {"wire": "binary/1"} and from then on
+// receives world states in the binary wire format, everyone else gets JSON. Commands carrying a
+// "seq" are answered with {"ack": seq} as soon as they are applied.
+// A client that sends {"action": "VIEW", "rect": [left, top, right, bottom]} only gets the snakes and food inside
+// that rect from then on: keyframes of what is inside, and deltas where a snake coming into view carries its
+// whole body and one leaving it is sent as {"id": n, "gone": true}.
+// --fragment n cuts what is sent into writes of 1 to n bytes with short pauses in between, regardless of
+// where messages begin and end, so clients get headers and bodies split across reads and the end of one
+// message together with the start of the next. 0 writes every message whole.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include "camera.h"
+#include "frame_decoder.h"
+#include "json.hpp"
+#include "occupancy_grid.h"
+#include "sim_engine.h"
+#include "wire_codec.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+using boost::asio::ip::tcp;
+using nlohmann::json;
+using snakelinkedlist::CellRect;
+using snakelinkedlist::FrameDecoder;
+using snakelinkedlist::GridCell;
+using snakelinkedlist::OccupancyGrid;
+using snakelinkedlist::SimEngine;
+using snakelinkedlist::SimOptions;
+using snakelinkedlist::SimSnake;
+using snakelinkedlist::SnakeBodyRing;
+using snakelinkedlist::SnakeDelta;
+using snakelinkedlist::WorldDelta;
+using snakelinkedlist::WorldSnapshot;
+
+namespace {
+
+    const std::size_t kHeaderLength = FrameDecoder::kHeaderLength;
+    const std::size_t kLengthBytes = FrameDecoder::kLongHeaderLength - FrameDecoder::kHeaderLength; // Of a long header
+
+    struct Options {
+        unsigned short port = 49145;
+        int snakes = 8;
+        int width = 48;
+        int height = 27;
+        int food = 5;
+        int tick_ms = 200;
+        bool delta = false;
+        int keyframe_every = 50;
+        unsigned seed = 1;
+        std::size_t fragment = 0;
+    };
+
+    typedef std::pair<int, int> Cell;
+
+    SimOptions simOptions(const Options& options) {
+        SimOptions sim;
+        sim.width = options.width;
+        sim.height = options.height;
+        sim.snakes = options.snakes;
+        sim.food = options.food;
+        sim.seed = options.seed;
+        return sim;
+    }
+
+    // body behind its header, a long one only if long_frames. Empty if it is too long for the headers allowed.
+    std::string frame(const std::string& body, bool long_frames = false) {
+        std::string framed;
+        snakelinkedlist::frameMessage(body, long_frames, framed);
+        return framed;
+    }
+
+    class Session : public std::enable_shared_from_this<Session> {
+    private:
+        tcp::socket socket_;
+        SimEngine& world_;
+        std::set<std::shared_ptr<Session>>& sessions_;
+        std::deque<std::string> writes_;
+        bool writing_ = false;
+        char header_[kHeaderLength + 1] = {};
+        unsigned char length_[kLengthBytes] = {}; // Of a long header
+        std::vector<char> body_;
+
+        // --fragment: the largest write, what is being written now and how much of writes_.front() it took
+        std::size_t fragment_;
+        std::string piece_;
+        std::size_t written_ = 0;
+        std::minstd_rand pieces_;
+        boost::asio::steady_timer pause_;
+
+        void readHeader() {
+            auto self = shared_from_this();
+            boost::asio::async_read(socket_, boost::asio::buffer(header_, kHeaderLength),
+                                    [this, self](boost::system::error_code error, std::size_t) {
+                                        if (error) {
+                                            sessions_.erase(self);
+                                            return;
+                                        }
+                                        if (long_frames && std::all_of(header_, header_ + kHeaderLength, [](char c) {
+                                                return c == FrameDecoder::kLongMarker;
+                                            })) {
+                                            readLength();
+                                            return;
+                                        }
+                                        // "%4d": spaces, then digits. Anything else and the stream can't be trusted.
+                                        std::size_t length = 0;
+                                        std::size_t i = 0;
+                                        while (i < kHeaderLength && header_[i] == ' ') {
+                                            ++i;
+                                        }
+                                        if (i == kHeaderLength) {
+                                            sessions_.erase(self);
+                                            return;
+                                        }
+                                        for (; i < kHeaderLength; ++i) {
+                                            if (header_[i] < '0' || header_[i] > '9') {
+                                                sessions_.erase(self);
+                                                return;
+                                            }
+                                            length = length * 10 + (header_[i] - '0');
+                                        }
+                                        body_.resize(length);
+                                        readBody();
+                                    });
+        }
+
+        // The u32 little endian length of a long header, which only a client we told we read them sends
+        void readLength() {
+            auto self = shared_from_this();
+            boost::asio::async_read(socket_, boost::asio::buffer(length_),
+                                    [this, self](boost::system::error_code error, std::size_t) {
+                                        if (error) {
+                                            sessions_.erase(self);
+                                            return;
+                                        }
+                                        std::size_t length = 0;
+                                        for (std::size_t i = kLengthBytes; i > 0; --i) {
+                                            length = (length << 8) | length_[i - 1];
+                                        }
+                                        if (length > FrameDecoder::kMaxLongBodyLength) {
+                                            sessions_.erase(self);
+                                            return;
+                                        }
+                                        body_.resize(length);
+                                        readBody();
+                                    });
+        }
+
+        void readBody() {
+            auto self = shared_from_this();
+            boost::asio::async_read(socket_, boost::asio::buffer(body_),
+                                    [this, self](boost::system::error_code error, std::size_t) {
+                                        if (error) {
+                                            sessions_.erase(self);
+                                            return;
+                                        }
+                                        handleCommand();
+                                        readHeader();
+                                    });
+        }
+
+        // Commands with a field of the wrong type are dropped, a bad client must not throw inside the handler
+        void handleCommand() {
+            json command = json::parse(body_.begin(), body_.end(), nullptr, false);
+            if (command.is_discarded() || !command.is_object()) {
+                return;
+            }
+            auto found = command.find("action");
+            if (found == command.end() || !found->is_string()) {
+                return;
+            }
+            const std::string& action = found->get_ref<const std::string&>();
+            if (action == "HELLO") {
+                negotiate(command);
+            } else if (action == "VIEW") {
+                auto rect = command.find("rect");
+                if (rect != command.end() && rect->is_array() && rect->size() == 4 &&
+                    std::all_of(rect->begin(), rect->end(), [](const json& v) { return v.is_number_integer(); })) {
+                    interest.left = (*rect)[0].get<int>();
+                    interest.top = (*rect)[1].get<int>();
+                    interest.right = (*rect)[2].get<int>();
+                    interest.bottom = (*rect)[3].get<int>();
+                    has_interest = true;
+                    interest_changed = true;
+                }
+            } else if (action.size() == 1) {
+                auto id = command.find("id");
+                if (id == command.end() || !id->is_number_integer()) {
+                    return;
+                }
+                world_.command(id->get<int>(), action[0]);
+                // Every state sent after this reflects the input, let the client stop replaying it
+                auto seq = command.find("seq");
+                if (seq != command.end() && seq->is_number_unsigned()) {
+                    send(frame(json{{"ack", seq->get<uint64_t>()}}.dump()));
+                }
+            }
+        }
+
+        void negotiate(const json& hello) {
+            json answer = json::object();
+            auto wire = hello.find("wire");
+            if (wire != hello.end() && wire->is_array() &&
+                std::find(wire->begin(), wire->end(), snakelinkedlist::kWireBinaryName) != wire->end()) {
+                answer["wire"] = snakelinkedlist::kWireBinaryName;
+                binary = true;
+            }
+            auto frames = hello.find("frame");
+            if (frames != hello.end() && frames->is_array() &&
+                std::find(frames->begin(), frames->end(), snakelinkedlist::kFrameLongName) != frames->end()) {
+                answer["frame"] = snakelinkedlist::kFrameLongName;
+                long_frames = true;
+            }
+            if (!answer.empty()) {
+                send(frame(answer.dump()));
+            }
+        }
+
+        void writeNext() {
+            if (fragment_ > 0) {
+                writePiece();
+                return;
+            }
+            auto self = shared_from_this();
+            boost::asio::async_write(socket_, boost::asio::buffer(writes_.front()),
+                                     [this, self](boost::system::error_code error, std::size_t) {
+                                         if (error) {
+                                             sessions_.erase(self);
+                                             return;
+                                         }
+                                         writes_.pop_front();
+                                         if (writes_.empty()) {
+                                             writing_ = false;
+                                         } else {
+                                             writeNext();
+                                         }
+                                     });
+        }
+
+        // Writes the next 1 to fragment_ bytes of whatever is queued, across message boundaries, then pauses
+        void writePiece() {
+            std::size_t size = std::uniform_int_distribution<std::size_t>(1, fragment_)(pieces_);
+            piece_.clear();
+            while (piece_.size() < size && !writes_.empty()) {
+                const std::string& front = writes_.front();
+                std::size_t take = std::min(size - piece_.size(), front.size() - written_);
+                piece_.append(front, written_, take);
+                written_ += take;
+                if (written_ == front.size()) {
+                    writes_.pop_front();
+                    written_ = 0;
+                }
+            }
+            auto self = shared_from_this();
+            boost::asio::async_write(socket_, boost::asio::buffer(piece_),
+                                     [this, self](boost::system::error_code error, std::size_t) {
+                                         if (error) {
+                                             sessions_.erase(self);
+                                             return;
+                                         }
+                                         if (writes_.empty()) {
+                                             writing_ = false;
+                                             return;
+                                         }
+                                         // Long enough for the piece to leave as a segment of its own
+                                         pause_.expires_after(std::chrono::microseconds(
+                                             std::uniform_int_distribution<int>(0, 500)(pieces_)));
+                                         pause_.async_wait([this, self](boost::system::error_code error) {
+                                             if (!error) {
+                                                 writePiece();
+                                             }
+                                         });
+                                     });
+        }
+
+    public:
+        bool needs_keyframe = true; // Deltas are useless to a client until it has seen a keyframe
+        bool binary = false; // The client asked for the binary wire format
+        bool long_frames = false; // The client reads long headers, states over 9999 bytes can go to it
+
+        // Area of interest: once the client has sent VIEW it only hears about what is inside interest
+        bool has_interest = false;
+        bool interest_changed = false; // Food has to be sent again, it is only sent when it changes otherwise
+        CellRect interest;
+        std::vector<bool> in_view; // By snake id, whether the client was last told about the snake
+
+        Session(tcp::socket socket, SimEngine& world, std::set<std::shared_ptr<Session>>& sessions, std::size_t fragment)
+            : socket_(std::move(socket)), world_(world), sessions_(sessions), fragment_(fragment),
+              pieces_(std::random_device()()), pause_(socket_.get_executor()) {
+            if (fragment_ > 0) {
+                boost::system::error_code ignored;
+                socket_.set_option(tcp::no_delay(true), ignored);
+            }
+        }
+
+        void start() { readHeader(); }
+
+        void send(std::string framed) {
+            writes_.push_back(std::move(framed));
+            if (!writing_) {
+                writing_ = true;
+                writeNext();
+            }
+        }
+    };
+
+    class Server {
+    private:
+        Options options_;
+        tcp::acceptor acceptor_;
+        boost::asio::steady_timer timer_;
+        SimEngine world_;
+        std::set<std::shared_ptr<Session>> sessions_;
+
+        // Bytes and serialization time per message kind, wire format and scope, reported every few seconds
+        enum Kind { KEYFRAME = 0, DELTA = 1 };
+        enum Format { JSON = 0, BINARY = 1 };
+        enum Scope { WHOLE = 0, VIEW = 1 }; // The whole world, or one client's area of interest
+        struct Totals {
+            uint64_t messages = 0;
+            uint64_t bytes = 0;
+            uint64_t dropped = 0; // Too long for the headers a client reads, not sent to it
+            std::chrono::steady_clock::duration encode_time{0};
+        } totals_[2][2][2];
+        std::chrono::steady_clock::time_point last_report_ = std::chrono::steady_clock::now();
+
+        void accept() {
+            acceptor_.async_accept([this](boost::system::error_code error, tcp::socket socket) {
+                if (!error) {
+                    auto session = std::make_shared<Session>(std::move(socket), world_, sessions_, options_.fragment);
+                    sessions_.insert(session);
+                    session->start();
+                }
+                accept();
+            });
+        }
+
+        // Encodes keyframe if kind is KEYFRAME and delta otherwise, returns the body
+        std::string encode(Kind kind, Format format, Scope scope, const WorldSnapshot* keyframe, const WorldDelta* delta) {
+            Totals& totals = totals_[kind][format][scope];
+            auto start = std::chrono::steady_clock::now();
+            std::string body;
+            if (format == BINARY) {
+                if (kind == KEYFRAME) {
+                    snakelinkedlist::encodeKeyframe(*keyframe, body);
+                } else {
+                    snakelinkedlist::encodeDelta(*delta, body);
+                }
+            } else {
+                body = (kind == KEYFRAME) ? snakelinkedlist::keyframeToJson(*keyframe).dump() : json(*delta).dump();
+            }
+            totals.encode_time += std::chrono::steady_clock::now() - start;
+            totals.bytes += body.size();
+            ++totals.messages;
+            return body;
+        }
+
+        // Frames body for the session and sends it. A body too long for the headers the session reads is
+        // dropped instead, sending it would throw the client out of step, and the session gets a keyframe next
+        // tick since whatever comes next builds on a state the client never saw.
+        void sendState(Session& session, const std::string& body, Kind kind, Format format, Scope scope) {
+            std::string framed = frame(body, session.long_frames);
+            if (framed.empty()) {
+                if (totals_[kind][format][scope].dropped++ == 0) {
+                    std::cerr << "World state of " << body.size() << " bytes does not fit the 4 digit header and the "
+                              << "client did not offer long headers, dropping states like it" << std::endl;
+                }
+                session.needs_keyframe = true;
+                return;
+            }
+            session.send(std::move(framed));
+        }
+
+        void tick() {
+            world_.tick();
+
+            // Each message is encoded at most once per tick, however many clients want it
+            bool keyframe_tick = !options_.delta || world_.tickNumber() % options_.keyframe_every == 0;
+            std::string encoded[2][2];
+            for (const std::shared_ptr<Session>& session : sessions_) {
+                Kind kind = (keyframe_tick || session->needs_keyframe) ? KEYFRAME : DELTA;
+                Format format = session->binary ? BINARY : JSON;
+                session->needs_keyframe = false;
+                if (session->has_interest) {
+                    // Only this client sees this part of the world, its message is its own
+                    if (kind == KEYFRAME) {
+                        WorldSnapshot keyframe = viewKeyframe(*session);
+                        sendState(*session, encode(kind, format, VIEW, &keyframe, nullptr), kind, format, VIEW);
+                    } else {
+                        WorldDelta delta = viewDelta(*session);
+                        sendState(*session, encode(kind, format, VIEW, nullptr, &delta), kind, format, VIEW);
+                    }
+                    continue;
+                }
+                std::string& body = encoded[kind][format];
+                if (body.empty()) {
+                    if (kind == KEYFRAME) {
+                        WorldSnapshot keyframe = world_.keyframe();
+                        body = encode(kind, format, WHOLE, &keyframe, nullptr);
+                    } else {
+                        body = encode(kind, format, WHOLE, nullptr, &world_.delta());
+                    }
+                }
+                sendState(*session, body, kind, format, WHOLE);
+            }
+
+            report();
+            timer_.expires_after(std::chrono::milliseconds(options_.tick_ms));
+            timer_.async_wait([this](boost::system::error_code error) {
+                if (!error) {
+                    tick();
+                }
+            });
+        }
+
+        // Whether any cell of body is inside rect. No cell of a body is further than its length from the head.
+        static bool inView(const CellRect& rect, const SnakeBodyRing& body) {
+            if (body.empty() || !rect.grown(static_cast<int>(body.size())).contains(Cell(body.head().x, body.head().y))) {
+                return false;
+            }
+            return std::any_of(body.begin(), body.end(), [&rect](const GridCell& cell) { return rect.contains(Cell(cell.x, cell.y)); });
+        }
+
+        // A keyframe of only the snakes and food in the session's area of interest
+        WorldSnapshot viewKeyframe(Session& session) {
+            WorldSnapshot keyframe;
+            keyframe.tick = world_.tickNumber();
+            for (const Cell& cell : world_.food()) {
+                if (session.interest.contains(cell)) {
+                    keyframe.food.push_back(cell);
+                }
+            }
+            session.in_view.assign(world_.snakes().size() + 1, false);
+            for (const SimSnake& s : world_.snakes()) {
+                if (!inView(session.interest, s.body)) {
+                    continue;
+                }
+                session.in_view[s.id] = true;
+                keyframe.snakes.push_back(snakelinkedlist::toSchema(s));
+            }
+            session.interest_changed = false;
+            return keyframe;
+        }
+
+        // The last tick's delta as the session sees it: changes to the snakes it already knows, whole bodies of
+        // the ones that came into view and a gone entry for the ones that left it
+        WorldDelta viewDelta(Session& session) {
+            WorldDelta delta;
+            delta.tick = world_.tickNumber();
+            session.in_view.resize(world_.snakes().size() + 1, false);
+            for (const SimSnake& s : world_.snakes()) {
+                bool now = inView(session.interest, s.body);
+                bool was = session.in_view[s.id];
+                session.in_view[s.id] = now;
+                if (now && was) {
+                    if (const SnakeDelta* changed = world_.deltaFor(s.id)) {
+                        delta.snakes.push_back(*changed);
+                    }
+                } else if (now) {
+                    SnakeDelta entered;
+                    entered.id = s.id;
+                    entered.direction = std::string(1, s.direction);
+                    entered.died = !s.alive;
+                    entered.has_body = true;
+                    entered.color = s.color;
+                    entered.body = snakelinkedlist::toSchema(s).coords;
+                    delta.snakes.push_back(entered);
+                } else if (was) {
+                    SnakeDelta gone;
+                    gone.id = s.id;
+                    gone.gone = true;
+                    delta.snakes.push_back(gone);
+                }
+            }
+            if (world_.delta().has_food || session.interest_changed) {
+                delta.has_food = true;
+                for (const Cell& cell : world_.food()) {
+                    if (session.interest.contains(cell)) {
+                        delta.food.push_back(cell);
+                    }
+                }
+            }
+            session.interest_changed = false;
+            return delta;
+        }
+
+        void report() {
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_report_ < std::chrono::seconds(5)) {
+                return;
+            }
+            last_report_ = now;
+
+            auto line = [](const char* name, const Totals& t) {
+                if (t.messages == 0) {
+                    return;
+                }
+                std::printf("  %-22s %8llu sent, %9.1f bytes/tick, %8.2f us to encode", name,
+                            static_cast<unsigned long long>(t.messages), double(t.bytes) / t.messages,
+                            std::chrono::duration<double, std::micro>(t.encode_time).count() / t.messages);
+                if (t.dropped > 0) {
+                    std::printf(", %llu dropped as too long", static_cast<unsigned long long>(t.dropped));
+                }
+                std::printf("\n");
+            };
+            std::printf("tick %llu, %zu clients\n", static_cast<unsigned long long>(world_.tickNumber()), sessions_.size());
+            line("json keyframes", totals_[KEYFRAME][JSON][WHOLE]);
+            line("json deltas", totals_[DELTA][JSON][WHOLE]);
+            line("binary keyframes", totals_[KEYFRAME][BINARY][WHOLE]);
+            line("binary deltas", totals_[DELTA][BINARY][WHOLE]);
+            line("json view keyframes", totals_[KEYFRAME][JSON][VIEW]);
+            line("json view deltas", totals_[DELTA][JSON][VIEW]);
+            line("binary view keyframes", totals_[KEYFRAME][BINARY][VIEW]);
+            line("binary view deltas", totals_[DELTA][BINARY][VIEW]);
+            std::fflush(stdout);
+        }
+
+    public:
+        Server(boost::asio::io_context& io_context, const Options& options)
+            : options_(options), acceptor_(io_context, tcp::endpoint(tcp::v4(), options.port)),
+              timer_(io_context), world_(simOptions(options)) {
+            accept();
+            tick();
+        }
+    };
+
+    Options parseOptions(int argc, char* argv[]) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--port") {
+                options.port = static_cast<unsigned short>(std::stoi(value));
+            } else if (flag == "--snakes") {
+                // Ids have to fit in the occupancy grid below its wall marker
+                options.snakes = std::min(std::stoi(value), static_cast<int>(OccupancyGrid::kWall) - 1);
+            } else if (flag == "--width") {
+                options.width = std::stoi(value);
+            } else if (flag == "--height") {
+                options.height = std::stoi(value);
+            } else if (flag == "--food") {
+                options.food = std::stoi(value);
+            } else if (flag == "--tick-ms") {
+                options.tick_ms = std::stoi(value);
+            } else if (flag == "--format") {
+                options.delta = (value == "delta");
+            } else if (flag == "--keyframe-every") {
+                options.keyframe_every = std::max(1, std::stoi(value));
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(std::stoul(value));
+            } else if (flag == "--fragment") {
+                options.fragment = static_cast<std::size_t>(std::max(0, std::stoi(value)));
+            } else {
+                std::cerr << "Unknown option " << flag << std::endl;
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options = parseOptions(argc, argv);
+    try {
+        boost::asio::io_context io_context;
+        Server server(io_context, options);
+        std::cout << "Stand-in server on port " << options.port << ", " << options.snakes << " snakes on "
+                  << options.width << "x" << options.height << ", sending " << (options.delta ? "deltas" : "keyframes");
+        if (options.fragment > 0) {
+            std::cout << " in writes of at most " << options.fragment << " bytes";
+        }
+        std::cout << std::endl;
+        io_context.run();
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
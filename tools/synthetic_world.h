@@ -0,0 +1,81 @@
+#ifndef SYNTHETIC_WORLD_H
+#define SYNTHETIC_WORLD_H
+#pragma once
+#include <chrono>
+#include <random>
+#include <utility>
+
+#include "world_model.h"
+#include "world_snapshot.h"
+
+namespace snakelinkedlist {
+    namespace synthetic {
+
+        /*
+         World states for the benches in this directory, built from a seeded generator instead of a running server.
+         Every snake is a random walk of length cells that never leaves the size x size arena, so bodies wander
+         and sometimes cross themselves the way real ones do. Food goes on random cells.
+         */
+        inline WorldSnapshot makeBoard(int size, int snakes, int length, int food, std::mt19937& generator) {
+            std::uniform_int_distribution<> coord(0, size - 1);
+            std::uniform_int_distribution<> turn(0, 3);
+            WorldSnapshot board;
+            board.tick = 123456;
+            for (int i = 0; i < food; ++i) {
+                board.food.push_back(std::make_pair(coord(generator), coord(generator)));
+            }
+            for (int id = 1; id <= snakes; ++id) {
+                snakejson::snake s;
+                s.id = id;
+                s.length = length;
+                s.alive = true;
+                s.direction = "D";
+                s.color = {{coord(generator) % 256, coord(generator) % 256, coord(generator) % 256}};
+                std::pair<int, int> cell(coord(generator), coord(generator));
+                for (int c = 0; c < length; ++c) {
+                    s.coords.push_back(cell);
+                    std::pair<int, int> next = cell;
+                    switch (turn(generator)) {
+                        case 0: ++next.first; break;
+                        case 1: --next.first; break;
+                        case 2: ++next.second; break;
+                        default: --next.second; break;
+                    }
+                    if (next.first >= 0 && next.first < size && next.second >= 0 && next.second < size) {
+                        cell = next;
+                    }
+                }
+                board.snakes.push_back(s);
+            }
+            return board;
+        }
+
+        // What the server would send as a delta for board: every snake moved one cell
+        inline WorldDelta makeDelta(const WorldSnapshot& board) {
+            WorldDelta delta;
+            delta.tick = board.tick + 1;
+            for (const snakejson::snake& s : board.snakes) {
+                SnakeDelta d;
+                d.id = s.id;
+                d.has_head = true;
+                d.head = std::make_pair(s.coords.front().first + 1, s.coords.front().second);
+                d.tail = 1;
+                delta.snakes.push_back(d);
+            }
+            return delta;
+        }
+
+        // Average time of one call to f over iterations calls, after one call to warm up caches and buffers
+        template <typename F>
+        double nanosPerCall(int iterations, F&& f) {
+            f();
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                f();
+            }
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+        }
+    } // namespace synthetic
+} // namespace snakelinkedlist
+
+#endif
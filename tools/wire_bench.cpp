@@ -0,0 +1,74 @@
+// Compares the JSON and binary world state encodings: bytes per tick and decode time per cell.
+// Boards are synthetic, every snake is a straight-ish run of cells like the server would send.
+//
+// Build from this directory:
+//     c++ -std=c++14 -O2 -I../src wire_bench.cpp ../src/world_snapshot.cpp ../src/world_model.cpp ../src/snakebody.cpp ../src/wire_codec.cpp -o wire_bench
+// Run:
+//     ./wire_bench [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "json.hpp"
+#include "synthetic_world.h"
+#include "wire_codec.h"
+#include "world_model.h"
+#include "world_snapshot.h"
+
+using namespace snakelinkedlist;
+using namespace snakelinkedlist::synthetic;
+using nlohmann::json;
+
+namespace {
+
+    void row(const char* name, std::size_t bytes, double decode_ns, std::size_t cells) {
+        std::printf("  %-16s %10zu bytes/tick %7.2f bytes/cell %9.1f us decode %7.2f ns/cell\n", name, bytes,
+                    double(bytes) / cells, decode_ns / 1000, decode_ns / cells);
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? std::atoi(argv[1]) : 50;
+    std::mt19937 generator(7);
+
+    const int kBoards[][2] = {{10, 20}, {100, 100}, {1000, 100}, {100, 10000}};
+    for (const auto& shape : kBoards) {
+        int snakes = shape[0];
+        int length = shape[1];
+        WorldSnapshot board = makeBoard(1000, snakes, length, 50, generator);
+        WorldDelta delta = makeDelta(board);
+        std::size_t cells = static_cast<std::size_t>(snakes) * length + board.food.size();
+
+        std::string json_keyframe = keyframeToJson(board).dump();
+        std::string json_delta = json(delta).dump();
+        std::string binary_keyframe;
+        encodeKeyframe(board, binary_keyframe);
+        std::string binary_delta;
+        encodeDelta(delta, binary_delta);
+
+        double json_keyframe_ns = nanosPerCall(iterations, [&]() {
+            parseWorldSnapshot(json::parse(json_keyframe), 1, 0);
+        });
+        double binary_keyframe_ns = nanosPerCall(iterations, [&]() {
+            WorldSnapshot decoded;
+            decodeKeyframe(binary_keyframe.data(), binary_keyframe.size(), decoded);
+        });
+        double json_delta_ns = nanosPerCall(iterations, [&]() {
+            json::parse(json_delta).get<WorldDelta>();
+        });
+        double binary_delta_ns = nanosPerCall(iterations, [&]() {
+            WorldDelta decoded;
+            decodeDelta(binary_delta.data(), binary_delta.size(), decoded);
+        });
+
+        std::printf("%d snakes of length %d (%zu cells)\n", snakes, length, cells);
+        row("json keyframe", json_keyframe.size(), json_keyframe_ns, cells);
+        row("binary keyframe", binary_keyframe.size(), binary_keyframe_ns, cells);
+        // A delta touches one head cell per snake
+        row("json delta", json_delta.size(), json_delta_ns, delta.snakes.size());
+        row("binary delta", binary_delta.size(), binary_delta_ns, delta.snakes.size());
+    }
+    return 0;
+}